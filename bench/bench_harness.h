@@ -0,0 +1,174 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Result of one benchmark case
+ */
+struct BenchResult {
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> params;
+    uint64_t iterations = 0;
+    double ns_per_op = 0.0; // median over samples
+    double min_ns_per_op = 0.0;
+    double p50_ns = -1.0; // latency cases only
+    double p99_ns = -1.0;
+};
+
+/**
+ * @brief Minimal timing harness with a machine-readable JSON report
+ */
+class BenchHarness {
+  private:
+    std::vector<BenchResult> results;
+    std::string filter;
+    std::chrono::milliseconds sample_time;
+    int samples;
+
+  public:
+    BenchHarness(std::string name_filter = "",
+                 std::chrono::milliseconds time_per_sample =
+                     std::chrono::milliseconds(50),
+                 int sample_count = 5)
+        : filter(std::move(name_filter)), sample_time(time_per_sample),
+          samples(sample_count) {}
+
+    bool selected(const std::string &name) const {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    /**
+     * @brief Time a throughput case; op is called in a tight loop
+     */
+    template <typename Op>
+    void run(const std::string &name,
+             std::vector<std::pair<std::string, std::string>> params, Op op) {
+        if (!selected(name))
+            return;
+
+        // Calibrate a batch size that takes roughly one sample
+        uint64_t batch = 1;
+        while (true) {
+            auto elapsed = time_batch(op, batch);
+            if (elapsed >= sample_time || batch >= (1ull << 32))
+                break;
+            batch *= elapsed < sample_time / 10 ? 10 : 2;
+        }
+
+        std::vector<double> per_op;
+        for (int s = 0; s < samples; ++s) {
+            auto elapsed = time_batch(op, batch);
+            per_op.push_back(
+                std::chrono::duration<double, std::nano>(elapsed).count() /
+                batch);
+        }
+        std::sort(per_op.begin(), per_op.end());
+
+        BenchResult result;
+        result.name = name;
+        result.params = std::move(params);
+        result.iterations = batch * samples;
+        result.ns_per_op = per_op[per_op.size() / 2];
+        result.min_ns_per_op = per_op.front();
+        report(result);
+    }
+
+    /**
+     * @brief Record a latency case measured by the caller, in nanoseconds
+     */
+    void add_latency(const std::string &name,
+                     std::vector<std::pair<std::string, std::string>> params,
+                     std::vector<double> latencies_ns) {
+        if (!selected(name) || latencies_ns.empty())
+            return;
+
+        std::sort(latencies_ns.begin(), latencies_ns.end());
+        std::size_t n = latencies_ns.size();
+
+        BenchResult result;
+        result.name = name;
+        result.params = std::move(params);
+        result.iterations = n;
+        result.ns_per_op = latencies_ns[(n - 1) / 2];
+        result.min_ns_per_op = latencies_ns.front();
+        result.p50_ns = latencies_ns[(n - 1) * 50 / 100];
+        result.p99_ns = latencies_ns[(n - 1) * 99 / 100];
+        report(result);
+    }
+
+    /**
+     * @brief Record a throughput case timed by the caller (e.g. multi-thread)
+     */
+    void add_throughput(const std::string &name,
+                        std::vector<std::pair<std::string, std::string>> params,
+                        uint64_t iterations,
+                        std::chrono::steady_clock::duration elapsed) {
+        if (!selected(name) || iterations == 0)
+            return;
+
+        BenchResult result;
+        result.name = name;
+        result.params = std::move(params);
+        result.iterations = iterations;
+        result.ns_per_op =
+            std::chrono::duration<double, std::nano>(elapsed).count() /
+            iterations;
+        result.min_ns_per_op = result.ns_per_op;
+        report(result);
+    }
+
+    void write_json(std::ostream &os) const {
+        os << "{\n  \"benchmarks\": [\n";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const auto &r = results[i];
+            os << "    {\"name\": \"" << r.name << "\", \"params\": {";
+            for (std::size_t p = 0; p < r.params.size(); ++p) {
+                os << (p ? ", " : "") << "\"" << r.params[p].first
+                   << "\": \"" << r.params[p].second << "\"";
+            }
+            os << "}, \"iterations\": " << r.iterations << std::fixed
+               << std::setprecision(2) << ", \"ns_per_op\": " << r.ns_per_op
+               << ", \"min_ns_per_op\": " << r.min_ns_per_op;
+            if (r.p50_ns >= 0) {
+                os << ", \"p50_ns\": " << r.p50_ns
+                   << ", \"p99_ns\": " << r.p99_ns;
+            }
+            os << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        os << "  ]\n}\n";
+    }
+
+  private:
+    template <typename Op>
+    static std::chrono::steady_clock::duration time_batch(Op &op,
+                                                          uint64_t batch) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < batch; ++i) {
+            op();
+        }
+        return std::chrono::steady_clock::now() - start;
+    }
+
+    void report(const BenchResult &result) {
+        std::ostringstream label;
+        label << result.name;
+        for (const auto &param : result.params) {
+            label << " " << param.first << "=" << param.second;
+        }
+        std::cerr << std::left << std::setw(52) << label.str() << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(12)
+                  << result.ns_per_op << " ns/op";
+        if (result.p99_ns >= 0) {
+            std::cerr << "  (p99 " << result.p99_ns << " ns)";
+        }
+        std::cerr << std::endl;
+        results.push_back(result);
+    }
+};
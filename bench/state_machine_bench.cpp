@@ -0,0 +1,367 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <state_machine/state_machine.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_harness.h"
+#include "traffic_light_standard_machine.h"
+#include "utils/traffic_executor.h"
+
+using namespace state_machine;
+
+// Micro-benchmarks for the engine, controller and observer hot paths.
+// A human-readable summary goes to stderr, the JSON report to stdout or
+// to the file given with --json.
+namespace {
+
+enum class BenchState : uint16_t {};
+enum class BenchEvent : uint16_t { GO, OTHER };
+
+using BenchMachine = RuntimeStateMachine<BenchState, BenchEvent>;
+
+BenchState state(std::size_t index) {
+    return static_cast<BenchState>(index);
+}
+
+// Ring of `count` states where GO always advances to the next one
+std::shared_ptr<BenchMachine> make_ring(std::size_t count) {
+    auto machine = std::make_shared<BenchMachine>(state(0));
+    for (std::size_t i = 0; i < count; ++i) {
+        machine->add_transition(
+            std::make_unique<SimpleStateTransition<BenchState, BenchEvent>>(
+                state(i), BenchEvent::GO, state((i + 1) % count)));
+    }
+    return machine;
+}
+
+std::shared_ptr<BenchMachine> make_guarded_ring(std::size_t count,
+                                                const bool *flag) {
+    auto machine = std::make_shared<BenchMachine>(state(0));
+    for (std::size_t i = 0; i < count; ++i) {
+        machine->add_transition(
+            std::make_unique<
+                ConditionalStateTransition<BenchState, BenchEvent>>(
+                state(i), BenchEvent::GO, state((i + 1) % count),
+                state((i + 1) % count), [flag]() { return *flag; }));
+    }
+    return machine;
+}
+
+std::shared_ptr<ConcurrentStateMachine<BenchState, BenchEvent>>
+make_concurrent_ring(std::size_t count) {
+    auto machine =
+        std::make_shared<ConcurrentStateMachine<BenchState, BenchEvent>>(
+            state(0));
+    for (std::size_t i = 0; i < count; ++i) {
+        machine->add_transition(
+            std::make_unique<SimpleStateTransition<BenchState, BenchEvent>>(
+                state(i), BenchEvent::GO, state((i + 1) % count)));
+    }
+    return machine;
+}
+
+class CountingHandler : public IActionHandler<BenchState, BenchEvent> {
+  public:
+    uint64_t handled = 0;
+    void handle(BenchState, BenchEvent, BenchState) override { ++handled; }
+};
+
+class CountingObserver : public IObserver<BenchState, BenchEvent> {
+  public:
+    uint64_t notified = 0;
+    void on_state_transition(BenchState, BenchEvent, BenchState) override {
+        ++notified;
+    }
+};
+
+class BenchController : public BaseController<BenchState, BenchEvent> {
+  public:
+    using BaseController::BaseController;
+    void fire(BenchEvent event) { handle_event(event); }
+};
+
+class BenchObservableController
+    : public ObservableController<BenchState, BenchEvent> {
+  public:
+    using ObservableController::ObservableController;
+    void fire(BenchEvent event) { handle_event(event); }
+};
+
+void bench_process_event(BenchHarness &harness) {
+    for (std::size_t count : {4, 16, 64, 256, 1024}) {
+        auto machine = make_ring(count);
+        harness.run("process_event", {{"transitions", std::to_string(count)}},
+                    [&machine]() { machine->process_event(BenchEvent::GO); });
+    }
+
+    // Events without a matching transition scan the whole table
+    for (std::size_t count : {16, 256}) {
+        auto machine = make_ring(count);
+        harness.run("process_event_no_match",
+                    {{"transitions", std::to_string(count)}},
+                    [&machine]() { machine->process_event(BenchEvent::OTHER); });
+    }
+}
+
+void bench_concurrent(BenchHarness &harness) {
+    for (std::size_t count : {4, 64}) {
+        auto machine = make_concurrent_ring(count);
+        harness.run("concurrent_process_event",
+                    {{"transitions", std::to_string(count)}, {"threads", "1"}},
+                    [&machine]() { machine->process_event(BenchEvent::GO); });
+    }
+
+    // Producers racing on one machine, no worker thread in between
+    if (!harness.selected("concurrent_process_event"))
+        return;
+    const uint64_t per_thread = 500000;
+    for (unsigned threads : {2u, 4u}) {
+        auto machine = make_concurrent_ring(4);
+        std::vector<std::thread> producers;
+        auto started = std::chrono::steady_clock::now();
+        for (unsigned t = 0; t < threads; ++t) {
+            producers.emplace_back([&machine, per_thread]() {
+                for (uint64_t i = 0; i < per_thread; ++i) {
+                    machine->process_event(BenchEvent::GO);
+                }
+            });
+        }
+        for (auto &producer : producers) {
+            producer.join();
+        }
+        harness.add_throughput(
+            "concurrent_process_event",
+            {{"transitions", "4"}, {"threads", std::to_string(threads)}},
+            per_thread * threads, std::chrono::steady_clock::now() - started);
+    }
+}
+
+void bench_guards(BenchHarness &harness) {
+    static bool flag = true;
+    for (std::size_t count : {4, 64}) {
+        auto simple = make_ring(count);
+        harness.run("guard_baseline_simple",
+                    {{"transitions", std::to_string(count)}},
+                    [&simple]() { simple->process_event(BenchEvent::GO); });
+
+        auto guarded = make_guarded_ring(count, &flag);
+        harness.run("guard_conditional",
+                    {{"transitions", std::to_string(count)}},
+                    [&guarded]() { guarded->process_event(BenchEvent::GO); });
+    }
+}
+
+// One definition file, interpreted from its packed table and generated
+// into switches
+void bench_definitions(BenchHarness &harness) {
+    using namespace generated;
+    using State = TrafficLightStandardState;
+    using Event = TrafficLightStandardEvent;
+    using Machine = TrafficLightStandardMachine;
+    static bool waiting = false;
+
+    DefinitionLoader<State, Event> loader(
+        [](State state) { return std::string(to_string(state)); },
+        Machine::STATE_COUNT,
+        [](Event event) { return std::string(to_string(event)); },
+        Machine::EVENT_COUNT);
+    auto slot = std::make_shared<DefinitionSlot<State, Event>>(
+        loader.load_file(TRAFFIC_LIGHT_DEFINITION));
+    VersionedStateMachine<State, Event> versioned(slot);
+    versioned.bind_guard(Machine::PEDESTRIAN_WAITING_GUARD,
+                         []() { return waiting; });
+    harness.run("definition_versioned", {{"states", "7"}}, [&versioned]() {
+        versioned.process_event(Event::TIME_EXPIRED);
+    });
+
+    Machine generated;
+    generated.bind_guard(Machine::PEDESTRIAN_WAITING_GUARD,
+                         []() { return waiting; });
+    harness.run("definition_generated", {{"states", "7"}}, [&generated]() {
+        generated.process_event(Event::TIME_EXPIRED);
+    });
+}
+
+// Builds, runs once and tears down a controller with its machine and
+// handler, from the heap and from an arena reset after every round
+void bench_controller_graph(BenchHarness &harness) {
+    using Machine = VersionedStateMachine<BenchState, BenchEvent>;
+    static bool flag = true;
+    const std::size_t count = 8;
+
+    MachineDefinition<BenchState, BenchEvent>::Builder builder(1, state(0));
+    for (std::size_t i = 0; i < count; ++i) {
+        builder.add_guarded(state(i), BenchEvent::GO, state(i),
+                            state((i + 1) % count), "go");
+    }
+    auto slot = std::make_shared<DefinitionSlot<BenchState, BenchEvent>>(
+        builder.build());
+
+    harness.run("controller_graph", {{"allocation", "heap"}}, [&slot]() {
+        auto machine = std::make_shared<Machine>(slot);
+        machine->bind_guard("go", []() { return flag; });
+        BenchController controller(machine,
+                                   std::make_shared<CountingHandler>());
+        controller.fire(BenchEvent::GO);
+    });
+
+    alignas(std::max_align_t) static char buffer[4096];
+    pmr::monotonic_buffer_resource arena(buffer, sizeof buffer);
+    harness.run("controller_graph", {{"allocation", "arena"}},
+                [&slot, &arena]() {
+                    {
+                        auto machine =
+                            allocate_shared_in<Machine>(&arena, slot, &arena);
+                        machine->bind_guard("go", []() { return flag; });
+                        BenchController controller(
+                            machine,
+                            allocate_shared_in<CountingHandler>(&arena),
+                            &arena);
+                        controller.fire(BenchEvent::GO);
+                    }
+                    arena.release();
+                });
+}
+
+#ifdef STATE_MACHINE_LATENCY_HISTOGRAMS
+void print_phase(const char *controller, const char *phase,
+                 const LatencySnapshot &snapshot) {
+    if (snapshot.count == 0)
+        return;
+    std::cerr << "  " << controller << " " << phase << ": p50 "
+              << snapshot.p50_ns << " ns, p99 " << snapshot.p99_ns
+              << " ns, p999 " << snapshot.p999_ns << " ns, max "
+              << snapshot.max_ns << " ns" << std::endl;
+}
+
+void print_phases(const char *controller,
+                  const ControllerLatencySnapshot &snapshot) {
+    print_phase(controller, "lookup", snapshot.lookup);
+    print_phase(controller, "handler", snapshot.handler);
+    print_phase(controller, "dispatch", snapshot.dispatch);
+}
+#endif
+
+void bench_base_controller(BenchHarness &harness) {
+    for (std::size_t count : {4, 64}) {
+        auto handler = std::make_shared<CountingHandler>();
+        BenchController controller(make_ring(count), handler);
+        harness.run("base_controller_handle_event",
+                    {{"transitions", std::to_string(count)}},
+                    [&controller]() { controller.fire(BenchEvent::GO); });
+#ifdef STATE_MACHINE_LATENCY_HISTOGRAMS
+        if (harness.selected("base_controller_handle_event")) {
+            print_phases("base_controller", controller.latency_snapshot());
+        }
+#endif
+    }
+}
+
+void bench_observable_controller(BenchHarness &harness) {
+    for (std::size_t count : {0, 1, 4, 16, 64}) {
+        BenchObservableController controller(make_ring(8));
+        std::vector<std::shared_ptr<CountingObserver>> observers;
+        for (std::size_t i = 0; i < count; ++i) {
+            observers.push_back(std::make_shared<CountingObserver>());
+            controller.add_observer(observers.back());
+        }
+        harness.run("observable_controller_notify",
+                    {{"observers", std::to_string(count)}},
+                    [&controller]() { controller.fire(BenchEvent::GO); });
+#ifdef STATE_MACHINE_LATENCY_HISTOGRAMS
+        if (harness.selected("observable_controller_notify")) {
+            print_phases("observable_controller",
+                         controller.latency_snapshot());
+        }
+#endif
+    }
+}
+
+void bench_executor_latency(BenchHarness &harness) {
+    if (!harness.selected("traffic_executor_latency"))
+        return;
+
+    const int rounds = 5000;
+    std::atomic<uint64_t> handled{0};
+    std::atomic<int64_t> handled_at{0};
+
+    TrafficExecutor executor(
+        [&handled, &handled_at](TrafficEvent) {
+            handled_at.store(std::chrono::steady_clock::now()
+                                 .time_since_epoch()
+                                 .count(),
+                             std::memory_order_relaxed);
+            handled.fetch_add(1, std::memory_order_release);
+        },
+        nullptr);
+    executor.start();
+
+    // Ping-pong: post one event and wait until the worker has handled it
+    std::vector<double> latencies;
+    latencies.reserve(rounds);
+    for (int i = 0; i < rounds; ++i) {
+        uint64_t before = handled.load(std::memory_order_acquire);
+        auto sent = std::chrono::steady_clock::now();
+        executor.send_button_event();
+        while (handled.load(std::memory_order_acquire) == before) {
+            std::this_thread::yield();
+        }
+        auto latency = std::chrono::steady_clock::duration(
+                           handled_at.load(std::memory_order_relaxed)) -
+                       sent.time_since_epoch();
+        latencies.push_back(
+            std::chrono::duration<double, std::nano>(latency).count());
+    }
+    executor.stop();
+
+    harness.add_latency("traffic_executor_latency",
+                        {{"mode", "enqueue_to_handle"}}, latencies);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::string json_path;
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--json <file>] [--filter <substring>]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    BenchHarness harness(filter);
+    bench_process_event(harness);
+    bench_concurrent(harness);
+    bench_guards(harness);
+    bench_definitions(harness);
+    bench_controller_graph(harness);
+    bench_base_controller(harness);
+    bench_observable_controller(harness);
+    bench_executor_latency(harness);
+
+    if (json_path.empty()) {
+        harness.write_json(std::cout);
+    } else {
+        std::ofstream out(json_path);
+        if (!out) {
+            std::cerr << "Cannot write " << json_path << std::endl;
+            return 1;
+        }
+        harness.write_json(out);
+    }
+    return 0;
+}
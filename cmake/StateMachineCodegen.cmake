@@ -0,0 +1,59 @@
+# add_state_machine(<target> <definition.json>
+#                   [NAMESPACE <ns>] [MACHINE <Class>]
+#                   [STATE_ENUM <Enum>] [EVENT_ENUM <Enum>] [HEADER <file.h>])
+#
+# Generates a header from a JSON machine definition and makes it available
+# to <target>. The header holds the state and event enums, their
+# to_string()/operator<< name tables and a switch-based IStateMachine.
+# Names default to the definition's "name" in CamelCase with a State,
+# Event or Machine suffix; the header defaults to <definition>_machine.h.
+# Several targets of one directory may ask for the same header; it is
+# generated once, with the options of the first call.
+function(add_state_machine target definition)
+    cmake_parse_arguments(ARG ""
+        "NAMESPACE;MACHINE;STATE_ENUM;EVENT_ENUM;HEADER" "" ${ARGN})
+
+    get_filename_component(definition "${definition}" ABSOLUTE)
+    get_filename_component(stem "${definition}" NAME_WE)
+    if(NOT ARG_HEADER)
+        set(ARG_HEADER "${stem}_machine.h")
+    endif()
+
+    set(output_dir "${CMAKE_CURRENT_BINARY_DIR}/generated")
+    set(output "${output_dir}/${ARG_HEADER}")
+
+    set(codegen_args)
+    if(ARG_NAMESPACE)
+        list(APPEND codegen_args --namespace ${ARG_NAMESPACE})
+    endif()
+    if(ARG_MACHINE)
+        list(APPEND codegen_args --machine ${ARG_MACHINE})
+    endif()
+    if(ARG_STATE_ENUM)
+        list(APPEND codegen_args --state-enum ${ARG_STATE_ENUM})
+    endif()
+    if(ARG_EVENT_ENUM)
+        list(APPEND codegen_args --event-enum ${ARG_EVENT_ENUM})
+    endif()
+
+    # Targets of one directory share a single rule: attaching the header to
+    # each of them would let a parallel build write it concurrently
+    string(MD5 rule_hash "${output}")
+    string(SUBSTRING "${rule_hash}" 0 8 rule_hash)
+    set(rule "generate_${stem}_${rule_hash}")
+    if(NOT TARGET ${rule})
+        add_custom_command(
+            OUTPUT "${output}"
+            COMMAND ${CMAKE_COMMAND} -E make_directory "${output_dir}"
+            COMMAND state_machine_codegen "${definition}" "${output}"
+                    ${codegen_args}
+            DEPENDS "${definition}" state_machine_codegen
+            COMMENT "Generating ${ARG_HEADER} from ${stem}.json"
+            VERBATIM
+        )
+        add_custom_target(${rule} DEPENDS "${output}")
+    endif()
+
+    add_dependencies(${target} ${rule})
+    target_include_directories(${target} PRIVATE "${output_dir}")
+endfunction()
@@ -21,13 +21,17 @@ int main() {
     // Create display service (simple console output for now)
     auto display_service = std::make_unique<ElevatorConsoleDisplayService>();
 
+    // Latest context, readable from any thread without locking
+    auto published_context =
+        std::make_shared<SeqlockSlot<ElevatorContextSnapshot>>();
+
     // Create controller using factory
     auto controller = ElevatorFactory::create_controller(
         ElevatorType::BASIC, std::move(display_service),
         std::make_unique<FunctionTimerService>(timer_func),
         0, // min floor
-        5  // max floor
-    );
+        5, // max floor
+        published_context);
 
     std::cout << "\n=== Testing Elevator Operation ===" << std::endl;
 
@@ -50,6 +54,18 @@ int main() {
     controller->emergency_stop(); // Emergency stop
     controller->timer_expired();  // EMERGENCY_STOP -> IDLE (after timeout)
 
+    std::cout << "\n=== Latest Published Context ===" << std::endl;
+    ElevatorConsoleDisplayService reader_display;
+    uint64_t seen_version = 0;
+    reader_display.render_latest(*published_context, seen_version);
+
+    std::cout << "\n=== Transition Hit Counts ===" << std::endl;
+    ElevatorFactory::get_transition_counters(ElevatorType::BASIC)
+        ->dump(
+            std::cout,
+            [](ElevatorState state) { return std::string(to_string(state)); },
+            [](ElevatorEvent event) { return std::string(to_string(event)); });
+
     std::cout << "\n=== Elevator Example completed successfully! ==="
               << std::endl;
     return 0;
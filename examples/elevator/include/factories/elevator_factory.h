@@ -30,13 +30,16 @@ class ElevatorFactory {
      * @param timer_service Timer service to use
      * @param min_floor Minimum floor number
      * @param max_floor Maximum floor number
+     * @param published_context Optional slot for lock-free context readers
      * @return Unique pointer to created controller
      */
     static std::unique_ptr<ElevatorController> create_controller(
         ElevatorType type,
         std::unique_ptr<IDisplayService<ElevatorContext>> display_service,
         std::unique_ptr<ITimerService> timer_service, int min_floor = 0,
-        int max_floor = 10);
+        int max_floor = 10,
+        std::shared_ptr<SeqlockSlot<ElevatorContextSnapshot>>
+            published_context = nullptr);
 
     /**
      * @brief Create a basic elevator controller
@@ -44,7 +47,9 @@ class ElevatorFactory {
     static std::unique_ptr<ElevatorController> create_basic_controller(
         std::unique_ptr<IDisplayService<ElevatorContext>> display_service,
         std::unique_ptr<ITimerService> timer_service, int min_floor = 0,
-        int max_floor = 10);
+        int max_floor = 10,
+        std::shared_ptr<SeqlockSlot<ElevatorContextSnapshot>>
+            published_context = nullptr);
 
     /**
      * @brief Create an advanced elevator controller with safety features
@@ -52,22 +57,49 @@ class ElevatorFactory {
     static std::unique_ptr<ElevatorController> create_advanced_controller(
         std::unique_ptr<IDisplayService<ElevatorContext>> display_service,
         std::unique_ptr<ITimerService> timer_service, int min_floor = 0,
-        int max_floor = 10);
+        int max_floor = 10,
+        std::shared_ptr<SeqlockSlot<ElevatorContextSnapshot>>
+            published_context = nullptr);
 
-  private:
-    // Helper methods for creating state machines
-    static void setup_basic_transitions(
-        std::shared_ptr<RuntimeStateMachine<ElevatorState, ElevatorEvent>>
-            state_machine,
-        std::function<bool()> has_requests,
-        std::function<bool()> should_move_up,
-        std::function<bool()> should_move_down);
+    /**
+     * @brief Edge hit counters shared by all controllers of a type
+     * @param type Elevator definition
+     * @return Counters indexed by [ElevatorState][ElevatorEvent]
+     */
+    static std::shared_ptr<TransitionCounters<ElevatorState, ElevatorEvent>>
+    get_transition_counters(ElevatorType type);
+
+    /**
+     * @brief Latency histograms shared by all controllers of a type
+     * Controllers record into them when built with
+     * ENABLE_LATENCY_HISTOGRAMS, instead of each holding its own.
+     */
+    static std::shared_ptr<ControllerLatency>
+    get_controller_latency(ElevatorType type);
+
+    /**
+     * @brief Transition table of an elevator type
+     * @param version Version stamped on the definition
+     * Guards are named HAS_REQUESTS_GUARD and MOVE_UP_GUARD.
+     */
+    static std::shared_ptr<const MachineDefinition<ElevatorState, ElevatorEvent>>
+    build_definition(ElevatorType type, uint64_t version = 1);
+
+    /**
+     * @brief Live definition of a type, shared by all its controllers
+     */
+    static std::shared_ptr<DefinitionSlot<ElevatorState, ElevatorEvent>>
+    get_definition_slot(ElevatorType type);
 
-    static void setup_advanced_transitions(
-        std::shared_ptr<RuntimeStateMachine<ElevatorState, ElevatorEvent>>
-            state_machine,
-        std::function<bool()> has_requests,
-        std::function<bool()> should_move_up,
-        std::function<bool()> should_move_down,
-        std::function<bool()> obstacle_detected);
+    static const char *const HAS_REQUESTS_GUARD;
+    static const char *const MOVE_UP_GUARD;
+
+  private:
+    static std::unique_ptr<ElevatorController> create_versioned_controller(
+        ElevatorType type,
+        std::unique_ptr<IDisplayService<ElevatorContext>> display_service,
+        std::unique_ptr<ITimerService> timer_service, int min_floor,
+        int max_floor,
+        std::shared_ptr<SeqlockSlot<ElevatorContextSnapshot>>
+            published_context);
 };
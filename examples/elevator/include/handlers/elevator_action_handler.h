@@ -2,7 +2,6 @@
 #include "elevator_context.h"
 #include "elevator_events.h"
 #include "elevator_states.h"
-#include <map>
 #include <memory>
 #include <set>
 #include <state_machine/state_machine.h>
@@ -14,9 +13,10 @@ using namespace state_machine;
 class ElevatorActionHandler
     : public IActionHandler<ElevatorState, ElevatorEvent> {
   private:
-    std::map<ElevatorState, ElevatorContext> states;
+    std::shared_ptr<const ElevatorContextTable> states; // shared, copy to modify
     std::unique_ptr<IDisplayService<ElevatorContext>> display_service;
     std::unique_ptr<ITimerService> timer_service;
+    std::shared_ptr<SeqlockSlot<ElevatorContextSnapshot>> published_context;
 
     int current_floor;
     int target_floor;
@@ -28,9 +28,21 @@ class ElevatorActionHandler
     void start_state_timer(ElevatorState state);
 
   public:
-    ElevatorActionHandler(std::unique_ptr<IDisplayService<ElevatorContext>> ds,
-                          std::unique_ptr<ITimerService> ts,
-                          int initial_floor = 0);
+    /**
+     * @param published Optional slot that receives the context of every
+     *                  entered state, for lock-free readers on other threads
+     * @param contexts State contexts shared with other handlers; null for
+     *                 default_contexts()
+     */
+    ElevatorActionHandler(
+        std::unique_ptr<IDisplayService<ElevatorContext>> ds,
+        std::unique_ptr<ITimerService> ts, int initial_floor = 0,
+        std::shared_ptr<SeqlockSlot<ElevatorContextSnapshot>> published =
+            nullptr,
+        std::shared_ptr<const ElevatorContextTable> contexts = nullptr);
+
+    // Contexts with the ElevatorTimings durations, built once
+    static std::shared_ptr<const ElevatorContextTable> default_contexts();
 
     void handle(ElevatorState current_state, ElevatorEvent event,
                 ElevatorState next_state) override;
@@ -47,6 +59,7 @@ class ElevatorActionHandler
     bool is_emergency_active() const { return emergency_active; }
     bool is_obstacle_present() const { return obstacle_present; }
 
+    // These give the handler its own copy of the contexts
     void set_state_timeout(ElevatorState state, uint32_t timeout);
     void configure_state(ElevatorState state, const ElevatorContext &config);
 };
@@ -1,8 +1,12 @@
 #pragma once
 #include <cstdint>
+#include <cstring>
 #include <set>
+#include <state_machine/implementations/state_context_table.h>
 #include <string>
 
+#include "elevator_states.h"
+
 /**
  * @brief Elevator door configuration
  */
@@ -51,3 +55,60 @@ struct ElevatorContext {
           current_floor(curr_floor), target_floor(tgt_floor),
           emergency_active(false), obstacle_detected(false) {}
 };
+
+/**
+ * @brief Trivially copyable copy of an ElevatorContext for SeqlockSlot
+ * Pending requests are kept as a bit mask, so only floors 0-63 survive.
+ */
+struct ElevatorContextSnapshot {
+    char name[24];
+    uint32_t duration;
+    ElevatorDoors doors;
+    ElevatorMovement movement;
+    int current_floor;
+    int target_floor;
+    uint64_t pending_floors; // bit n set = floor n requested
+    bool emergency_active;
+    bool obstacle_detected;
+
+    static ElevatorContextSnapshot from(const ElevatorContext &ctx) {
+        ElevatorContextSnapshot snapshot;
+        std::strncpy(snapshot.name, ctx.name.c_str(), sizeof(name) - 1);
+        snapshot.name[sizeof(name) - 1] = '\0';
+        snapshot.duration = ctx.duration;
+        snapshot.doors = ctx.doors;
+        snapshot.movement = ctx.movement;
+        snapshot.current_floor = ctx.current_floor;
+        snapshot.target_floor = ctx.target_floor;
+        snapshot.pending_floors = 0;
+        for (int floor : ctx.pending_requests) {
+            if (floor >= 0 && floor < 64) {
+                snapshot.pending_floors |= uint64_t(1) << floor;
+            }
+        }
+        snapshot.emergency_active = ctx.emergency_active;
+        snapshot.obstacle_detected = ctx.obstacle_detected;
+        return snapshot;
+    }
+
+    ElevatorContext to_context() const {
+        ElevatorContext ctx(name, duration, doors, movement, current_floor,
+                            target_floor);
+        for (int floor = 0; floor < 64; ++floor) {
+            if (pending_floors & (uint64_t(1) << floor)) {
+                ctx.pending_requests.insert(floor);
+            }
+        }
+        ctx.emergency_active = emergency_active;
+        ctx.obstacle_detected = obstacle_detected;
+        return ctx;
+    }
+};
+
+/**
+ * @brief Context of every elevator state, shared by handlers
+ * Floors, requests and flags in the entries are placeholders; handlers
+ * fill in their own before publishing a context.
+ */
+using ElevatorContextTable =
+    state_machine::StateContextTable<ElevatorState, ElevatorContext>;
@@ -1,17 +1,5 @@
 #pragma once
-#include <iostream>
 
-/**
- * @brief All possible elevator states
- */
-enum class ElevatorState {
-    IDLE,          // standing still, doors closed
-    DOORS_OPENING, // doors are opening
-    DOORS_OPEN,    // doors are open
-    DOORS_CLOSING, // doors are closing
-    MOVING_UP,     // moving upward
-    MOVING_DOWN,   // moving downward
-    EMERGENCY_STOP // emergency stop activated
-};
-
-std::ostream &operator<<(std::ostream &os, ElevatorState state);
+// ElevatorState, with to_string() and operator<<, is generated from
+// definitions/elevator.json by add_state_machine()
+#include "elevator_machine.h"
@@ -10,6 +10,15 @@ class ElevatorConsoleDisplayService : public IDisplayService<ElevatorContext> {
   public:
     void show_state(const ElevatorContext &ctx) override;
 
+    /**
+     * @brief Render the latest published context if it changed
+     * Lets a display thread render at its own cadence without locking
+     * @param seen_version Version rendered last; updated when rendering
+     * @return true if something was rendered
+     */
+    bool render_latest(const SeqlockSlot<ElevatorContextSnapshot> &slot,
+                       uint64_t &seen_version);
+
     // Elevator specific display methods
     void show_elevator_state(const ElevatorContext &ctx);
     void show_floor_requests(const std::set<int> &requests);
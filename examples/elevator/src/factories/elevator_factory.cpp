@@ -8,195 +8,171 @@ std::unique_ptr<ElevatorController> ElevatorFactory::create_controller(
     ElevatorType type,
     std::unique_ptr<IDisplayService<ElevatorContext>> display_service,
     std::unique_ptr<ITimerService> timer_service, int min_floor,
-    int max_floor) {
+    int max_floor,
+    std::shared_ptr<SeqlockSlot<ElevatorContextSnapshot>> published_context) {
 
     switch (type) {
     case ElevatorType::BASIC:
         return create_basic_controller(std::move(display_service),
                                        std::move(timer_service), min_floor,
-                                       max_floor);
+                                       max_floor, std::move(published_context));
     case ElevatorType::ADVANCED:
         return create_advanced_controller(std::move(display_service),
                                           std::move(timer_service), min_floor,
-                                          max_floor);
+                                          max_floor,
+                                          std::move(published_context));
     default:
         return create_basic_controller(std::move(display_service),
                                        std::move(timer_service), min_floor,
-                                       max_floor);
+                                       max_floor, std::move(published_context));
     }
 }
 
+const char *const ElevatorFactory::HAS_REQUESTS_GUARD = "has_requests";
+const char *const ElevatorFactory::MOVE_UP_GUARD = "should_move_up";
+
 std::unique_ptr<ElevatorController> ElevatorFactory::create_basic_controller(
     std::unique_ptr<IDisplayService<ElevatorContext>> display_service,
     std::unique_ptr<ITimerService> timer_service, int min_floor,
-    int max_floor) {
-
-    auto state_machine =
-        std::make_shared<RuntimeStateMachine<ElevatorState, ElevatorEvent>>(
-            ElevatorState::IDLE);
-
-    auto action_handler = std::make_shared<ElevatorActionHandler>(
-        std::move(display_service), std::move(timer_service), min_floor);
-
-    // Create controller first to get access to its methods
-    auto controller = std::make_unique<ElevatorController>(
-        state_machine, action_handler, min_floor, max_floor);
+    int max_floor,
+    std::shared_ptr<SeqlockSlot<ElevatorContextSnapshot>> published_context) {
 
-    // Get raw pointer for lambda capture (safe because controller owns the
-    // shared_ptr)
-    auto controller_ptr = controller.get();
-
-    auto has_requests = [controller_ptr]() -> bool {
-        return controller_ptr->has_pending_requests();
-    };
-
-    auto should_move_up = [controller_ptr]() -> bool {
-        return controller_ptr->get_target_floor() >
-               controller_ptr->get_current_floor();
-    };
-
-    auto should_move_down = [controller_ptr]() -> bool {
-        return controller_ptr->get_target_floor() <
-               controller_ptr->get_current_floor();
-    };
+    return create_versioned_controller(
+        ElevatorType::BASIC, std::move(display_service),
+        std::move(timer_service), min_floor, max_floor,
+        std::move(published_context));
+}
 
-    setup_basic_transitions(state_machine, has_requests, should_move_up,
-                            should_move_down);
+std::unique_ptr<ElevatorController> ElevatorFactory::create_advanced_controller(
+    std::unique_ptr<IDisplayService<ElevatorContext>> display_service,
+    std::unique_ptr<ITimerService> timer_service, int min_floor,
+    int max_floor,
+    std::shared_ptr<SeqlockSlot<ElevatorContextSnapshot>> published_context) {
 
-    return controller;
+    return create_versioned_controller(
+        ElevatorType::ADVANCED, std::move(display_service),
+        std::move(timer_service), min_floor, max_floor,
+        std::move(published_context));
 }
 
-std::unique_ptr<ElevatorController> ElevatorFactory::create_advanced_controller(
+std::unique_ptr<ElevatorController>
+ElevatorFactory::create_versioned_controller(
+    ElevatorType type,
     std::unique_ptr<IDisplayService<ElevatorContext>> display_service,
     std::unique_ptr<ITimerService> timer_service, int min_floor,
-    int max_floor) {
+    int max_floor,
+    std::shared_ptr<SeqlockSlot<ElevatorContextSnapshot>> published_context) {
 
     auto state_machine =
-        std::make_shared<RuntimeStateMachine<ElevatorState, ElevatorEvent>>(
-            ElevatorState::IDLE);
+        std::make_shared<VersionedStateMachine<ElevatorState, ElevatorEvent>>(
+            get_definition_slot(type));
 
     auto action_handler = std::make_shared<ElevatorActionHandler>(
-        std::move(display_service), std::move(timer_service), min_floor);
+        std::move(display_service), std::move(timer_service), min_floor,
+        std::move(published_context));
 
+    // Create controller first to get access to its methods
     auto controller = std::make_unique<ElevatorController>(
         state_machine, action_handler, min_floor, max_floor);
 
+    // Get raw pointer for lambda capture (safe because controller owns the
+    // state machine)
     auto controller_ptr = controller.get();
-    auto handler_ptr = action_handler.get();
 
-    auto has_requests = [controller_ptr]() -> bool {
+    // Guards are bound per controller, the definition is shared
+    state_machine->bind_guard(HAS_REQUESTS_GUARD, [controller_ptr]() {
         return controller_ptr->has_pending_requests();
-    };
-
-    auto should_move_up = [controller_ptr]() -> bool {
+    });
+    state_machine->bind_guard(MOVE_UP_GUARD, [controller_ptr]() {
         return controller_ptr->get_target_floor() >
                controller_ptr->get_current_floor();
-    };
-
-    auto should_move_down = [controller_ptr]() -> bool {
-        return controller_ptr->get_target_floor() <
-               controller_ptr->get_current_floor();
-    };
+    });
+    state_machine->set_counters(get_transition_counters(type));
+#ifdef STATE_MACHINE_LATENCY_HISTOGRAMS
+    controller->share_latency(get_controller_latency(type));
+#endif
 
-    auto obstacle_detected = [handler_ptr]() -> bool {
-        return handler_ptr->is_obstacle_present();
-    };
+    return controller;
+}
 
-    setup_advanced_transitions(state_machine, has_requests, should_move_up,
-                               should_move_down, obstacle_detected);
+std::shared_ptr<ControllerLatency>
+ElevatorFactory::get_controller_latency(ElevatorType type) {
+    static auto basic = std::make_shared<ControllerLatency>();
+    static auto advanced = std::make_shared<ControllerLatency>();
+    return type == ElevatorType::ADVANCED ? advanced : basic;
+}
 
-    return controller;
+std::shared_ptr<TransitionCounters<ElevatorState, ElevatorEvent>>
+ElevatorFactory::get_transition_counters(ElevatorType type) {
+    using Counters = TransitionCounters<ElevatorState, ElevatorEvent>;
+    const std::size_t states =
+        static_cast<std::size_t>(ElevatorState::EMERGENCY_STOP) + 1;
+    const std::size_t events =
+        static_cast<std::size_t>(ElevatorEvent::OBSTACLE_DETECTED) + 1;
+
+    static auto basic = std::make_shared<Counters>(states, events);
+    static auto advanced = std::make_shared<Counters>(states, events);
+    return type == ElevatorType::ADVANCED ? advanced : basic;
 }
 
-void ElevatorFactory::setup_basic_transitions(
-    std::shared_ptr<RuntimeStateMachine<ElevatorState, ElevatorEvent>>
-        state_machine,
-    std::function<bool()> has_requests, std::function<bool()> should_move_up,
-    std::function<bool()> should_move_down) {
+std::shared_ptr<const MachineDefinition<ElevatorState, ElevatorEvent>>
+ElevatorFactory::build_definition(ElevatorType type, uint64_t version) {
+    MachineDefinition<ElevatorState, ElevatorEvent>::Builder builder(
+        version, ElevatorState::IDLE);
 
-    // From IDLE
-    state_machine->add_transition(
-        std::make_unique<
-            ConditionalStateTransition<ElevatorState, ElevatorEvent>>(
-            ElevatorState::IDLE, ElevatorEvent::FLOOR_REQUESTED,
-            ElevatorState::DOORS_OPENING, ElevatorState::DOORS_OPENING,
-            has_requests));
+    // From IDLE; both outcomes open the doors, the guard is only counted
+    builder.add_guarded(ElevatorState::IDLE, ElevatorEvent::FLOOR_REQUESTED,
+                        ElevatorState::DOORS_OPENING,
+                        ElevatorState::DOORS_OPENING, HAS_REQUESTS_GUARD);
 
     // From DOORS_OPENING
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<ElevatorState, ElevatorEvent>>(
-            ElevatorState::DOORS_OPENING, ElevatorEvent::TIMER_EXPIRED,
-            ElevatorState::DOORS_OPEN));
+    builder.add(ElevatorState::DOORS_OPENING, ElevatorEvent::TIMER_EXPIRED,
+                ElevatorState::DOORS_OPEN);
 
     // From DOORS_OPEN
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<ElevatorState, ElevatorEvent>>(
-            ElevatorState::DOORS_OPEN, ElevatorEvent::TIMER_EXPIRED,
-            ElevatorState::DOORS_CLOSING));
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<ElevatorState, ElevatorEvent>>(
-            ElevatorState::DOORS_OPEN, ElevatorEvent::DOORS_CLOSE_REQUESTED,
-            ElevatorState::DOORS_CLOSING));
-
-    // From DOORS_CLOSING
-    state_machine->add_transition(
-        std::make_unique<
-            ConditionalStateTransition<ElevatorState, ElevatorEvent>>(
-            ElevatorState::DOORS_CLOSING, ElevatorEvent::TIMER_EXPIRED,
-            ElevatorState::IDLE, ElevatorState::MOVING_UP, should_move_up));
-
-    state_machine->add_transition(
-        std::make_unique<
-            ConditionalStateTransition<ElevatorState, ElevatorEvent>>(
-            ElevatorState::DOORS_CLOSING, ElevatorEvent::TIMER_EXPIRED,
-            ElevatorState::IDLE, ElevatorState::MOVING_DOWN, should_move_down));
-
-    // From MOVING_UP
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<ElevatorState, ElevatorEvent>>(
-            ElevatorState::MOVING_UP, ElevatorEvent::FLOOR_REACHED,
-            ElevatorState::DOORS_OPENING));
-
-    // From MOVING_DOWN
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<ElevatorState, ElevatorEvent>>(
-            ElevatorState::MOVING_DOWN, ElevatorEvent::FLOOR_REACHED,
-            ElevatorState::DOORS_OPENING));
-
-    // Emergency from any state
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<ElevatorState, ElevatorEvent>>(
-            ElevatorState::IDLE, ElevatorEvent::EMERGENCY_BUTTON,
-            ElevatorState::EMERGENCY_STOP));
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<ElevatorState, ElevatorEvent>>(
-            ElevatorState::EMERGENCY_STOP, ElevatorEvent::TIMER_EXPIRED,
-            ElevatorState::IDLE));
+    builder.add(ElevatorState::DOORS_OPEN, ElevatorEvent::TIMER_EXPIRED,
+                ElevatorState::DOORS_CLOSING);
+    builder.add(ElevatorState::DOORS_OPEN,
+                ElevatorEvent::DOORS_CLOSE_REQUESTED,
+                ElevatorState::DOORS_CLOSING);
+
+    // From DOORS_CLOSING; the first matching transition used to win, so
+    // a separate move-down rule was never reached and is left out
+    builder.add_guarded(ElevatorState::DOORS_CLOSING,
+                        ElevatorEvent::TIMER_EXPIRED, ElevatorState::IDLE,
+                        ElevatorState::MOVING_UP, MOVE_UP_GUARD);
+
+    // From MOVING_UP / MOVING_DOWN
+    builder.add(ElevatorState::MOVING_UP, ElevatorEvent::FLOOR_REACHED,
+                ElevatorState::DOORS_OPENING);
+    builder.add(ElevatorState::MOVING_DOWN, ElevatorEvent::FLOOR_REACHED,
+                ElevatorState::DOORS_OPENING);
+
+    // Emergency
+    builder.add(ElevatorState::IDLE, ElevatorEvent::EMERGENCY_BUTTON,
+                ElevatorState::EMERGENCY_STOP);
+    builder.add(ElevatorState::EMERGENCY_STOP, ElevatorEvent::TIMER_EXPIRED,
+                ElevatorState::IDLE);
+
+    if (type == ElevatorType::ADVANCED) {
+        // Obstacle detection during door closing
+        builder.add(ElevatorState::DOORS_CLOSING,
+                    ElevatorEvent::OBSTACLE_DETECTED,
+                    ElevatorState::DOORS_OPENING);
+        // Re-open doors if obstacle detected during opening
+        builder.add(ElevatorState::DOORS_OPENING,
+                    ElevatorEvent::OBSTACLE_DETECTED,
+                    ElevatorState::DOORS_OPENING);
+    }
+    return builder.build();
 }
 
-void ElevatorFactory::setup_advanced_transitions(
-    std::shared_ptr<RuntimeStateMachine<ElevatorState, ElevatorEvent>>
-        state_machine,
-    std::function<bool()> has_requests, std::function<bool()> should_move_up,
-    std::function<bool()> should_move_down,
-    std::function<bool()> obstacle_detected) {
-
-    // Start with basic transitions
-    setup_basic_transitions(state_machine, has_requests, should_move_up,
-                            should_move_down);
-
-    // Add advanced safety features
-    // Obstacle detection during door closing
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<ElevatorState, ElevatorEvent>>(
-            ElevatorState::DOORS_CLOSING, ElevatorEvent::OBSTACLE_DETECTED,
-            ElevatorState::DOORS_OPENING));
-
-    // Re-open doors if obstacle detected during opening
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<ElevatorState, ElevatorEvent>>(
-            ElevatorState::DOORS_OPENING, ElevatorEvent::OBSTACLE_DETECTED,
-            ElevatorState::DOORS_OPENING)); // Restart opening cycle
+std::shared_ptr<DefinitionSlot<ElevatorState, ElevatorEvent>>
+ElevatorFactory::get_definition_slot(ElevatorType type) {
+    using Slot = DefinitionSlot<ElevatorState, ElevatorEvent>;
+    static auto basic =
+        std::make_shared<Slot>(build_definition(ElevatorType::BASIC));
+    static auto advanced =
+        std::make_shared<Slot>(build_definition(ElevatorType::ADVANCED));
+    return type == ElevatorType::ADVANCED ? advanced : basic;
 }
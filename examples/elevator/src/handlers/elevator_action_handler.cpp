@@ -9,58 +9,51 @@
 
 ElevatorActionHandler::ElevatorActionHandler(
     std::unique_ptr<IDisplayService<ElevatorContext>> ds,
-    std::unique_ptr<ITimerService> ts, int initial_floor)
-    : display_service(std::move(ds)), timer_service(std::move(ts)),
-      current_floor(initial_floor), target_floor(initial_floor),
-      emergency_active(false), obstacle_present(false) {
-
-    std::map<ElevatorState, ElevatorContext> states;
-    std::unique_ptr<IDisplayService<ElevatorContext>> display_service;
-    std::unique_ptr<ITimerService> timer_service;
-
-    // Initialize all elevator states
-    states[ElevatorState::IDLE] = {"IDLE",
-                                   ElevatorTimings::IDLE_TIMEOUT,
-                                   {false, false, false}, // doors: closed
-                                   {false, false, true},  // movement: stopped
-                                   initial_floor,
-                                   initial_floor};
-
-    states[ElevatorState::DOORS_OPENING] = {
-        "DOORS_OPENING",      ElevatorTimings::DOORS_OPENING_DURATION,
-        {false, true, false}, // doors: opening
-        {false, false, true}, // movement: stopped
-        initial_floor,        initial_floor};
-
-    states[ElevatorState::DOORS_OPEN] = {
-        "DOORS_OPEN",         ElevatorTimings::DOORS_OPEN_DURATION,
-        {true, false, false}, // doors: open
-        {false, false, true}, // movement: stopped
-        initial_floor,        initial_floor};
-
-    states[ElevatorState::DOORS_CLOSING] = {
-        "DOORS_CLOSING",      ElevatorTimings::DOORS_CLOSING_DURATION,
-        {false, false, true}, // doors: closing
-        {false, false, true}, // movement: stopped
-        initial_floor,        initial_floor};
-
-    states[ElevatorState::MOVING_UP] = {
-        "MOVING_UP",           ElevatorTimings::FLOOR_TRAVEL_DURATION,
-        {false, false, false}, // doors: closed
-        {true, false, false},  // movement: moving up
-        initial_floor,         initial_floor};
-
-    states[ElevatorState::MOVING_DOWN] = {
-        "MOVING_DOWN",         ElevatorTimings::FLOOR_TRAVEL_DURATION,
-        {false, false, false}, // doors: closed
-        {false, true, false},  // movement: moving down
-        initial_floor,         initial_floor};
-
-    states[ElevatorState::EMERGENCY_STOP] = {
-        "EMERGENCY_STOP",      ElevatorTimings::EMERGENCY_TIMEOUT,
-        {false, false, false}, // doors: closed
-        {false, false, true},  // movement: stopped
-        initial_floor,         initial_floor};
+    std::unique_ptr<ITimerService> ts, int initial_floor,
+    std::shared_ptr<SeqlockSlot<ElevatorContextSnapshot>> published,
+    std::shared_ptr<const ElevatorContextTable> contexts)
+    : states(contexts ? std::move(contexts) : default_contexts()),
+      display_service(std::move(ds)), timer_service(std::move(ts)),
+      published_context(std::move(published)), current_floor(initial_floor),
+      target_floor(initial_floor), emergency_active(false),
+      obstacle_present(false) {}
+
+std::shared_ptr<const ElevatorContextTable>
+ElevatorActionHandler::default_contexts() {
+    static const std::shared_ptr<const ElevatorContextTable> shared = []() {
+        auto table = std::make_shared<ElevatorContextTable>(
+            static_cast<std::size_t>(ElevatorState::EMERGENCY_STOP) + 1);
+        table->set(ElevatorState::IDLE,
+                   {"IDLE", ElevatorTimings::IDLE_TIMEOUT,
+                    {false, false, false},  // doors: closed
+                    {false, false, true}}); // movement: stopped
+        table->set(ElevatorState::DOORS_OPENING,
+                   {"DOORS_OPENING", ElevatorTimings::DOORS_OPENING_DURATION,
+                    {false, true, false},   // doors: opening
+                    {false, false, true}}); // movement: stopped
+        table->set(ElevatorState::DOORS_OPEN,
+                   {"DOORS_OPEN", ElevatorTimings::DOORS_OPEN_DURATION,
+                    {true, false, false},   // doors: open
+                    {false, false, true}}); // movement: stopped
+        table->set(ElevatorState::DOORS_CLOSING,
+                   {"DOORS_CLOSING", ElevatorTimings::DOORS_CLOSING_DURATION,
+                    {false, false, true},   // doors: closing
+                    {false, false, true}}); // movement: stopped
+        table->set(ElevatorState::MOVING_UP,
+                   {"MOVING_UP", ElevatorTimings::FLOOR_TRAVEL_DURATION,
+                    {false, false, false},  // doors: closed
+                    {true, false, false}}); // movement: moving up
+        table->set(ElevatorState::MOVING_DOWN,
+                   {"MOVING_DOWN", ElevatorTimings::FLOOR_TRAVEL_DURATION,
+                    {false, false, false},  // doors: closed
+                    {false, true, false}}); // movement: moving down
+        table->set(ElevatorState::EMERGENCY_STOP,
+                   {"EMERGENCY_STOP", ElevatorTimings::EMERGENCY_TIMEOUT,
+                    {false, false, false},  // doors: closed
+                    {false, false, true}}); // movement: stopped
+        return table;
+    }();
+    return shared;
 }
 
 void ElevatorActionHandler::handle(ElevatorState current_state,
@@ -115,9 +108,9 @@ void ElevatorActionHandler::handle(ElevatorState current_state,
 }
 
 void ElevatorActionHandler::display_elevator_state(ElevatorState state) {
-    auto it = states.find(state);
-    if (it != states.end()) {
-        auto ctx = it->second;
+    const ElevatorContext *context = states->find(state);
+    if (context) {
+        auto ctx = *context;
 
         // Update context with current data
         ctx.current_floor = current_floor;
@@ -126,6 +119,9 @@ void ElevatorActionHandler::display_elevator_state(ElevatorState state) {
         ctx.emergency_active = emergency_active;
         ctx.obstacle_detected = obstacle_present;
 
+        if (published_context) {
+            published_context->publish(ElevatorContextSnapshot::from(ctx));
+        }
         if (display_service) {
             // Note: We need to adapt display_service for elevator context
             // For now, this won't compile - we'll need generic display service
@@ -134,9 +130,9 @@ void ElevatorActionHandler::display_elevator_state(ElevatorState state) {
 }
 
 void ElevatorActionHandler::start_state_timer(ElevatorState state) {
-    auto it = states.find(state);
-    if (it != states.end()) {
-        const auto &ctx = it->second;
+    const ElevatorContext *context = states->find(state);
+    if (context) {
+        const auto &ctx = *context;
         uint32_t duration_sec = ctx.duration;
 
         if (timer_service && duration_sec > 0) {
@@ -147,10 +143,19 @@ void ElevatorActionHandler::start_state_timer(ElevatorState state) {
 
 void ElevatorActionHandler::set_state_timeout(ElevatorState state,
                                               uint32_t timeout) {
-    states[state].duration = timeout;
+    auto copy = std::make_shared<ElevatorContextTable>(*states);
+    ElevatorContext context;
+    if (const ElevatorContext *current = states->find(state)) {
+        context = *current;
+    }
+    context.duration = timeout;
+    copy->set(state, context);
+    states = std::move(copy);
 }
 
 void ElevatorActionHandler::configure_state(ElevatorState state,
                                             const ElevatorContext &config) {
-    states[state] = config;
+    auto copy = std::make_shared<ElevatorContextTable>(*states);
+    copy->set(state, config);
+    states = std::move(copy);
 }
@@ -27,3 +27,15 @@ void ElevatorConsoleDisplayService::show_state(const ElevatorContext &ctx) {
 
     std::cout << std::endl;
 }
+
+bool ElevatorConsoleDisplayService::render_latest(
+    const SeqlockSlot<ElevatorContextSnapshot> &slot, uint64_t &seen_version) {
+    uint64_t version = 0;
+    ElevatorContextSnapshot snapshot = slot.read(&version);
+    if (version == seen_version)
+        return false;
+
+    seen_version = version;
+    show_state(snapshot.to_context());
+    return true;
+}
@@ -8,7 +8,7 @@
 
 using namespace state_machine;
 
-int main() {
+int main(int argc, char *argv[]) {
     std::cout << "=== Traffic Light Example (using state_machine library) ==="
               << std::endl;
 
@@ -18,10 +18,27 @@ int main() {
                   << std::endl;
     };
 
-    // Create controller using factory
-    auto controller = TrafficLightFactory::create_controller(
-        TrafficLightType::STANDARD, std::make_unique<ConsoleDisplayService>(),
-        std::make_unique<FunctionTimerService>(timer_func));
+    // Create controller using factory, optionally from a definition file
+    std::unique_ptr<TrafficLightController> controller;
+    if (argc > 1) {
+        try {
+            auto slot =
+                std::make_shared<DefinitionSlot<TrafficState, TrafficEvent>>(
+                    TrafficLightFactory::load_definition(argv[1]));
+            controller = TrafficLightFactory::create_controller(
+                slot, std::make_unique<ConsoleDisplayService>(),
+                std::make_unique<FunctionTimerService>(timer_func));
+        } catch (const std::exception &e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Loaded definition " << argv[1] << std::endl;
+    } else {
+        controller = TrafficLightFactory::create_controller(
+            TrafficLightType::STANDARD,
+            std::make_unique<ConsoleDisplayService>(),
+            std::make_unique<FunctionTimerService>(timer_func));
+    }
 
     // Test basic operation
     std::cout << "\n=== Testing State Transitions ===" << std::endl;
@@ -39,6 +56,19 @@ int main() {
     controller->timeout_expired(); // WALK -> WALK_FINISH
     controller->timeout_expired(); // WALK_FINISH -> RED_YELLOW
 
+    if (argc <= 1) {
+        std::cout << "\n=== Transition Hit Counts ===" << std::endl;
+        TrafficLightFactory::get_transition_counters(TrafficLightType::STANDARD)
+            ->dump(
+                std::cout,
+                [](TrafficState state) {
+                    return std::string(to_string(state));
+                },
+                [](TrafficEvent event) {
+                    return std::string(to_string(event));
+                });
+    }
+
     std::cout << "\n=== Example completed successfully! ===" << std::endl;
     return 0;
 }
@@ -14,7 +14,8 @@ class TrafficLightController
     TrafficLightController(
         std::shared_ptr<IStateMachine<TrafficState, TrafficEvent>>
             state_machine,
-        std::shared_ptr<IActionHandler<TrafficState, TrafficEvent>> ah);
+        std::shared_ptr<IActionHandler<TrafficState, TrafficEvent>> ah,
+        pmr::memory_resource *resource = pmr::get_default_resource());
 
     void button_pressed();
     void timeout_expired();
@@ -7,9 +7,12 @@
 #include "traffic_events.h"
 #include "traffic_states.h"
 #include <memory>
+#include <string>
 
 using namespace state_machine;
 
+class TrafficLightActionHandler;
+
 /**
  * @brief Traffic light types supported by the factory
  */
@@ -28,36 +31,135 @@ class TrafficLightFactory {
      * @param type Type of traffic light to create
      * @param display_service Display service to use
      * @param timer_service Timer service to use
+     * @param published_context Optional slot for lock-free context readers
      * @return Unique pointer to created controller
      */
     static std::unique_ptr<TrafficLightController> create_controller(
         TrafficLightType type,
         std::unique_ptr<IDisplayService<TrafficContext>> display_service,
-        std::unique_ptr<ITimerService> timer_service);
+        std::unique_ptr<ITimerService> timer_service,
+        std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>>
+            published_context = nullptr);
+
+    /**
+     * @brief Create a controller running whatever definition slot holds
+     * @param contexts State timeouts and lights, typically one
+     *                 build_context_table() result shared by every
+     *                 controller of the slot; null to build them from the
+     *                 slot's current definition
+     */
+    static std::unique_ptr<TrafficLightController> create_controller(
+        std::shared_ptr<DefinitionSlot<TrafficState, TrafficEvent>> slot,
+        std::unique_ptr<IDisplayService<TrafficContext>> display_service,
+        std::unique_ptr<ITimerService> timer_service,
+        std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>>
+            published_context = nullptr,
+        std::shared_ptr<const TrafficContextTable> contexts = nullptr);
+
+    /**
+     * @brief Create a controller whose parts live in a memory resource
+     * @param resource Source of the controller, its action handler, state
+     *                 machine and guard bindings; must outlive them. With
+     *                 a monotonic_buffer_resource a whole fleet of
+     *                 controllers is freed by one release().
+     * The services stay wherever the caller allocated them.
+     */
+    static std::shared_ptr<TrafficLightController> create_controller_in(
+        pmr::memory_resource *resource, TrafficLightType type,
+        std::unique_ptr<IDisplayService<TrafficContext>> display_service,
+        std::unique_ptr<ITimerService> timer_service,
+        std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>>
+            published_context = nullptr);
 
     /**
      * @brief Create a standard traffic light controller (with RED_YELLOW)
      */
     static std::unique_ptr<TrafficLightController> create_standard_controller(
         std::unique_ptr<IDisplayService<TrafficContext>> display_service,
-        std::unique_ptr<ITimerService> timer_service);
+        std::unique_ptr<ITimerService> timer_service,
+        std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>>
+            published_context = nullptr);
 
     /**
      * @brief Create a simple traffic light controller (without RED_YELLOW)
      */
     static std::unique_ptr<TrafficLightController> create_simple_controller(
         std::unique_ptr<IDisplayService<TrafficContext>> display_service,
-        std::unique_ptr<ITimerService> timer_service);
+        std::unique_ptr<ITimerService> timer_service,
+        std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>>
+            published_context = nullptr);
+
+    /**
+     * @brief Edge hit counters shared by all controllers of a type
+     * @param type Traffic light definition
+     * @return Counters indexed by [TrafficState][TrafficEvent]
+     */
+    static std::shared_ptr<TransitionCounters<TrafficState, TrafficEvent>>
+    get_transition_counters(TrafficLightType type);
+
+    /**
+     * @brief Latency histograms shared by all controllers of a type
+     * Controllers record into them when built with
+     * ENABLE_LATENCY_HISTOGRAMS, instead of each holding its own.
+     */
+    static std::shared_ptr<ControllerLatency>
+    get_controller_latency(TrafficLightType type);
+
+    /**
+     * @brief Transition table of a traffic light type
+     * @param version Version stamped on the definition
+     * The pedestrian check is the guard named PEDESTRIAN_GUARD.
+     */
+    static std::shared_ptr<const MachineDefinition<TrafficState, TrafficEvent>>
+    build_definition(TrafficLightType type, uint64_t version = 1);
+
+    /**
+     * @brief Live definition of a type, shared by all its controllers
+     * Publishing a newer definition here switches every controller of the
+     * type at its next event.
+     */
+    static std::shared_ptr<DefinitionSlot<TrafficState, TrafficEvent>>
+    get_definition_slot(TrafficLightType type);
+
+    /**
+     * @brief State contexts shared by all controllers of a type
+     */
+    static std::shared_ptr<const TrafficContextTable>
+    get_context_table(TrafficLightType type);
+
+    /**
+     * @brief State contexts from a definition's attributes
+     * Throws if a display entry names an unknown lamp.
+     */
+    static std::shared_ptr<const TrafficContextTable> build_context_table(
+        const MachineDefinition<TrafficState, TrafficEvent> &definition);
+
+    /**
+     * @brief Compile a JSON definition of a traffic light
+     * @param path File in the DefinitionDocument layout
+     * A state's "cars" and "pedestrians" display entries list its lit
+     * lamps, e.g. "red yellow". Throws on invalid definitions.
+     */
+    static std::shared_ptr<const MachineDefinition<TrafficState, TrafficEvent>>
+    load_definition(const std::string &path);
+
+    static const char *const PEDESTRIAN_GUARD;
 
   private:
-    // Helper methods for creating state machines
-    static void setup_standard_transitions(
-        std::shared_ptr<RuntimeStateMachine<TrafficState, TrafficEvent>>
-            state_machine,
-        std::function<bool()> ped_check);
-
-    static void setup_simple_transitions(
-        std::shared_ptr<RuntimeStateMachine<TrafficState, TrafficEvent>>
-            state_machine,
-        std::function<bool()> ped_check);
+    static std::unique_ptr<TrafficLightController> create_versioned_controller(
+        std::shared_ptr<DefinitionSlot<TrafficState, TrafficEvent>> slot,
+        std::shared_ptr<TransitionCounters<TrafficState, TrafficEvent>>
+            counters,
+        std::shared_ptr<TrafficLightActionHandler> action_handler);
+
+    static void share_type_latency(TrafficLightController &controller,
+                                   TrafficLightType type);
+
+    static std::shared_ptr<VersionedStateMachine<TrafficState, TrafficEvent>>
+    create_state_machine(
+        std::shared_ptr<DefinitionSlot<TrafficState, TrafficEvent>> slot,
+        std::shared_ptr<TransitionCounters<TrafficState, TrafficEvent>>
+            counters,
+        std::shared_ptr<const TrafficLightActionHandler> action_handler,
+        pmr::memory_resource *resource);
 };
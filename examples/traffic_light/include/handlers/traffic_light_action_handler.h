@@ -5,7 +5,6 @@
 #include "traffic_context.h"
 #include "traffic_events.h"
 #include "traffic_states.h"
-#include <map>
 #include <memory>
 
 using namespace state_machine;
@@ -16,18 +15,31 @@ using namespace state_machine;
 class TrafficLightActionHandler
     : public IActionHandler<TrafficState, TrafficEvent> {
   private:
-    std::map<TrafficState, TrafficContext> states;
+    std::shared_ptr<const TrafficContextTable> states; // shared, copy to modify
     bool pedestrian_request = false;
     std::unique_ptr<IDisplayService<TrafficContext>> display_service;
     std::unique_ptr<ITimerService> timer_service;
+    std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>> published_context;
 
     void display_traffic_state(TrafficState state);
     void start_state_timer(TrafficState state);
 
   public:
+    /**
+     * @param published Optional slot that receives the context of every
+     *                  entered state, for lock-free readers on other threads
+     * @param contexts State contexts shared with other handlers; null for
+     *                 default_contexts()
+     */
     TrafficLightActionHandler(
         std::unique_ptr<IDisplayService<TrafficContext>> ds,
-        std::unique_ptr<ITimerService> ts);
+        std::unique_ptr<ITimerService> ts,
+        std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>> published =
+            nullptr,
+        std::shared_ptr<const TrafficContextTable> contexts = nullptr);
+
+    // Contexts with the LightTimings durations, built once
+    static std::shared_ptr<const TrafficContextTable> default_contexts();
 
     // Implementation of IActionHandler interface
     void handle(TrafficState current_state, TrafficEvent event,
@@ -36,6 +48,7 @@ class TrafficLightActionHandler
     // Traffic light specific methods
     bool has_pedestrian_request() const;
     void handle_button_press_event();
+    // These give the handler its own copy of the contexts
     void set_state_timeout(TrafficState state, uint32_t timeout);
     void configure_state(TrafficState state, const TrafficContext &config);
 };
@@ -1,7 +1,11 @@
 #pragma once
 #include <cstdint>
+#include <cstring>
+#include <state_machine/implementations/state_context_table.h>
 #include <string>
 
+#include "traffic_states.h"
+
 /**
  * @brief Car traffic light configuration
  */
@@ -38,3 +42,34 @@ struct TrafficContext {
                    const PedestrianLights &ped)
         : name(n), duration(dur), carLights(car), pedLights(ped) {}
 };
+
+/**
+ * @brief Trivially copyable copy of a TrafficContext for SeqlockSlot
+ * Names longer than the buffer are truncated.
+ */
+struct TrafficContextSnapshot {
+    char name[24];
+    uint32_t duration;
+    TrafficLights carLights;
+    PedestrianLights pedLights;
+
+    static TrafficContextSnapshot from(const TrafficContext &ctx) {
+        TrafficContextSnapshot snapshot;
+        std::strncpy(snapshot.name, ctx.name.c_str(), sizeof(name) - 1);
+        snapshot.name[sizeof(name) - 1] = '\0';
+        snapshot.duration = ctx.duration;
+        snapshot.carLights = ctx.carLights;
+        snapshot.pedLights = ctx.pedLights;
+        return snapshot;
+    }
+
+    TrafficContext to_context() const {
+        return TrafficContext(name, duration, carLights, pedLights);
+    }
+};
+
+/**
+ * @brief Context of every traffic light state, shared by handlers
+ */
+using TrafficContextTable =
+    state_machine::StateContextTable<TrafficState, TrafficContext>;
@@ -1,9 +1,5 @@
 #pragma once
-#include <iostream>
 
-/**
- * @brief System events that trigger state transitions
- */
-enum class TrafficEvent { TIME_EXPIRED, BUTTON_PRESSED };
-
-std::ostream &operator<<(std::ostream &os, TrafficEvent event);
+// TrafficEvent, with to_string() and operator<<, is generated from
+// definitions/traffic_light_standard.json by add_state_machine()
+#include "traffic_light_machine.h"
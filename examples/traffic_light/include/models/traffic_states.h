@@ -1,16 +1,5 @@
 #pragma once
-#include <iostream>
-/**
- * @brief All possible traffic light states
- */
-enum class TrafficState {
-    CAR_GREEN,
-    CAR_YELLOW,
-    CAR_RED,
-    WALK_PREP,
-    WALK,
-    WALK_FINISH,
-    CAR_RED_YELLOW
-};
 
-std::ostream &operator<<(std::ostream &os, TrafficState state);
+// TrafficState, with to_string() and operator<<, is generated from
+// definitions/traffic_light_standard.json by add_state_machine()
+#include "traffic_light_machine.h"
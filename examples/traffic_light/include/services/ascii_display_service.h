@@ -29,6 +29,15 @@ class AsciiDisplayService : public IDisplayService<TrafficContext> {
   public:
     void show_state(const TrafficContext &ctx) override;
 
+    /**
+     * @brief Render the latest published context if it changed
+     * Lets a display thread render at its own cadence without locking
+     * @param seen_version Version rendered last; updated when rendering
+     * @return true if something was rendered
+     */
+    bool render_latest(const SeqlockSlot<TrafficContextSnapshot> &slot,
+                       uint64_t &seen_version);
+
     // Optional: disable colors for terminals that don't support them
     void set_color_enabled(bool enabled);
 };
@@ -2,8 +2,9 @@
 
 TrafficLightController::TrafficLightController(
     std::shared_ptr<IStateMachine<TrafficState, TrafficEvent>> sm,
-    std::shared_ptr<IActionHandler<TrafficState, TrafficEvent>> ah)
-    : BaseController(sm, std::move(ah)) {}
+    std::shared_ptr<IActionHandler<TrafficState, TrafficEvent>> ah,
+    pmr::memory_resource *resource)
+    : BaseController(sm, std::move(ah), resource) {}
 
 void TrafficLightController::handle_button_press() {
     handle_event(TrafficEvent::BUTTON_PRESSED);
@@ -1,151 +1,314 @@
 #include "traffic_light_factory.h"
 #include "light_timings.h"
 #include "traffic_light_action_handler.h"
+#include <sstream>
 #include <state_machine/state_machine.h>
+#include <stdexcept>
+
+const char *const TrafficLightFactory::PEDESTRIAN_GUARD = "pedestrian_waiting";
+
+namespace {
+
+// Sets the lamps named in a display entry such as "red yellow"
+template <typename Lights>
+void light_lamps(const std::map<std::string, std::string> &display,
+                 const std::string &key, TrafficState state,
+                 std::map<std::string, bool Lights::*> lamps, Lights &lights) {
+    lights = Lights(false);
+    auto entry = display.find(key);
+    if (entry == display.end())
+        return;
+    std::istringstream words(entry->second);
+    std::string word;
+    while (words >> word) {
+        auto lamp = lamps.find(word);
+        if (lamp == lamps.end()) {
+            throw std::runtime_error(
+                "Traffic light state " + std::string(to_string(state)) +
+                " has no " + key +
+                " lamp '" + word + "'");
+        }
+        lights.*(lamp->second) = true;
+    }
+}
+
+TrafficContext to_context(TrafficState state,
+                          const StateAttributes &attributes) {
+    TrafficContext context;
+    context.name = to_string(state);
+    context.duration = attributes.timeout;
+    light_lamps<TrafficLights>(attributes.display, "cars", state,
+                               {{"red", &TrafficLights::red},
+                                {"yellow", &TrafficLights::yellow},
+                                {"green", &TrafficLights::green}},
+                               context.carLights);
+    light_lamps<PedestrianLights>(attributes.display, "pedestrians", state,
+                                  {{"red", &PedestrianLights::red},
+                                   {"green", &PedestrianLights::green}},
+                                  context.pedLights);
+    return context;
+}
+
+} // namespace
 
 std::unique_ptr<TrafficLightController> TrafficLightFactory::create_controller(
     TrafficLightType type,
     std::unique_ptr<IDisplayService<TrafficContext>> display_service,
-    std::unique_ptr<ITimerService> timer_service) {
+    std::unique_ptr<ITimerService> timer_service,
+    std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>> published_context) {
 
     switch (type) {
     case TrafficLightType::STANDARD:
         return create_standard_controller(std::move(display_service),
-                                          std::move(timer_service));
+                                          std::move(timer_service),
+                                          std::move(published_context));
     case TrafficLightType::SIMPLE:
         return create_simple_controller(std::move(display_service),
-                                        std::move(timer_service));
+                                        std::move(timer_service),
+                                        std::move(published_context));
     default:
         return create_standard_controller(std::move(display_service),
-                                          std::move(timer_service));
+                                          std::move(timer_service),
+                                          std::move(published_context));
     }
 }
 
 std::unique_ptr<TrafficLightController>
 TrafficLightFactory::create_standard_controller(
     std::unique_ptr<IDisplayService<TrafficContext>> display_service,
-    std::unique_ptr<ITimerService> timer_service) {
-
-    auto state_machine =
-        std::make_shared<RuntimeStateMachine<TrafficState, TrafficEvent>>(
-            TrafficState::CAR_GREEN);
+    std::unique_ptr<ITimerService> timer_service,
+    std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>> published_context) {
 
     auto action_handler = std::make_shared<TrafficLightActionHandler>(
-        std::move(display_service), std::move(timer_service));
-
-    auto ped_check = [action_handler]() -> bool {
-        return action_handler->has_pedestrian_request();
-    };
+        std::move(display_service), std::move(timer_service),
+        std::move(published_context),
+        get_context_table(TrafficLightType::STANDARD));
 
-    setup_standard_transitions(state_machine, ped_check);
-
-    return std::make_unique<TrafficLightController>(state_machine,
-                                                    action_handler);
+    auto controller = create_versioned_controller(
+        get_definition_slot(TrafficLightType::STANDARD),
+        get_transition_counters(TrafficLightType::STANDARD),
+        std::move(action_handler));
+    share_type_latency(*controller, TrafficLightType::STANDARD);
+    return controller;
 }
 
 std::unique_ptr<TrafficLightController>
 TrafficLightFactory::create_simple_controller(
     std::unique_ptr<IDisplayService<TrafficContext>> display_service,
-    std::unique_ptr<ITimerService> timer_service) {
+    std::unique_ptr<ITimerService> timer_service,
+    std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>> published_context) {
 
-    auto state_machine =
-        std::make_shared<RuntimeStateMachine<TrafficState, TrafficEvent>>(
-            TrafficState::CAR_GREEN);
+    auto action_handler = std::make_shared<TrafficLightActionHandler>(
+        std::move(display_service), std::move(timer_service),
+        std::move(published_context),
+        get_context_table(TrafficLightType::SIMPLE));
+
+    auto controller = create_versioned_controller(
+        get_definition_slot(TrafficLightType::SIMPLE),
+        get_transition_counters(TrafficLightType::SIMPLE),
+        std::move(action_handler));
+    share_type_latency(*controller, TrafficLightType::SIMPLE);
+    return controller;
+}
 
+std::unique_ptr<TrafficLightController> TrafficLightFactory::create_controller(
+    std::shared_ptr<DefinitionSlot<TrafficState, TrafficEvent>> slot,
+    std::unique_ptr<IDisplayService<TrafficContext>> display_service,
+    std::unique_ptr<ITimerService> timer_service,
+    std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>> published_context,
+    std::shared_ptr<const TrafficContextTable> contexts) {
+
+    if (!contexts) {
+        contexts = build_context_table(*slot->load());
+    }
     auto action_handler = std::make_shared<TrafficLightActionHandler>(
-        std::move(display_service), std::move(timer_service));
+        std::move(display_service), std::move(timer_service),
+        std::move(published_context), std::move(contexts));
 
-    // Configure modified timing for YELLOW state (longer duration instead of
-    // RED_YELLOW)
-    action_handler->set_state_timeout(TrafficState::CAR_YELLOW,
-                                      LightTimings::YELLOW_DURATION +
-                                          LightTimings::RED_YELLOW_DURATION);
+    return create_versioned_controller(std::move(slot), nullptr,
+                                       std::move(action_handler));
+}
+
+std::shared_ptr<TrafficLightController>
+TrafficLightFactory::create_controller_in(
+    pmr::memory_resource *resource, TrafficLightType type,
+    std::unique_ptr<IDisplayService<TrafficContext>> display_service,
+    std::unique_ptr<ITimerService> timer_service,
+    std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>> published_context) {
+
+    auto action_handler = allocate_shared_in<TrafficLightActionHandler>(
+        resource, std::move(display_service), std::move(timer_service),
+        std::move(published_context), get_context_table(type));
+    auto state_machine =
+        create_state_machine(get_definition_slot(type),
+                             get_transition_counters(type),
+                             action_handler, resource);
+
+    auto controller = allocate_shared_in<TrafficLightController>(
+        resource, std::move(state_machine), std::move(action_handler),
+        resource);
+    share_type_latency(*controller, type);
+    return controller;
+}
 
-    auto ped_check = [action_handler]() -> bool {
-        return action_handler->has_pedestrian_request();
-    };
+std::unique_ptr<TrafficLightController>
+TrafficLightFactory::create_versioned_controller(
+    std::shared_ptr<DefinitionSlot<TrafficState, TrafficEvent>> slot,
+    std::shared_ptr<TransitionCounters<TrafficState, TrafficEvent>> counters,
+    std::shared_ptr<TrafficLightActionHandler> action_handler) {
 
-    setup_simple_transitions(state_machine, ped_check);
+    auto state_machine =
+        create_state_machine(std::move(slot), std::move(counters),
+                             action_handler, pmr::get_default_resource());
 
     return std::make_unique<TrafficLightController>(state_machine,
                                                     std::move(action_handler));
 }
 
-void TrafficLightFactory::setup_standard_transitions(
-    std::shared_ptr<RuntimeStateMachine<TrafficState, TrafficEvent>>
-        state_machine,
-    std::function<bool()> ped_check) {
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::CAR_GREEN, TrafficEvent::TIME_EXPIRED,
-            TrafficState::CAR_YELLOW));
-
-    state_machine->add_transition(
-        std::make_unique<
-            ConditionalStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::CAR_YELLOW, TrafficEvent::TIME_EXPIRED,
-            TrafficState::CAR_RED, TrafficState::WALK_PREP, ped_check));
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::CAR_RED, TrafficEvent::TIME_EXPIRED,
-            TrafficState::CAR_RED_YELLOW));
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::CAR_RED_YELLOW, TrafficEvent::TIME_EXPIRED,
-            TrafficState::CAR_GREEN));
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::WALK_PREP, TrafficEvent::TIME_EXPIRED,
-            TrafficState::WALK));
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::WALK, TrafficEvent::TIME_EXPIRED,
-            TrafficState::WALK_FINISH));
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::WALK_FINISH, TrafficEvent::TIME_EXPIRED,
-            TrafficState::CAR_RED_YELLOW));
-}
-
-void TrafficLightFactory::setup_simple_transitions(
-    std::shared_ptr<RuntimeStateMachine<TrafficState, TrafficEvent>>
-        state_machine,
-    std::function<bool()> ped_check) {
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::CAR_GREEN, TrafficEvent::TIME_EXPIRED,
-            TrafficState::CAR_YELLOW));
-
-    state_machine->add_transition(
-        std::make_unique<
-            ConditionalStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::CAR_YELLOW, TrafficEvent::TIME_EXPIRED,
-            TrafficState::CAR_RED, TrafficState::WALK_PREP, ped_check));
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::CAR_RED, TrafficEvent::TIME_EXPIRED,
-            TrafficState::CAR_GREEN));
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::WALK_PREP, TrafficEvent::TIME_EXPIRED,
-            TrafficState::WALK));
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::WALK, TrafficEvent::TIME_EXPIRED,
-            TrafficState::WALK_FINISH));
-
-    state_machine->add_transition(
-        std::make_unique<SimpleStateTransition<TrafficState, TrafficEvent>>(
-            TrafficState::WALK_FINISH, TrafficEvent::TIME_EXPIRED,
-            TrafficState::CAR_GREEN));
+std::shared_ptr<VersionedStateMachine<TrafficState, TrafficEvent>>
+TrafficLightFactory::create_state_machine(
+    std::shared_ptr<DefinitionSlot<TrafficState, TrafficEvent>> slot,
+    std::shared_ptr<TransitionCounters<TrafficState, TrafficEvent>> counters,
+    std::shared_ptr<const TrafficLightActionHandler> action_handler,
+    pmr::memory_resource *resource) {
+
+    auto state_machine =
+        allocate_shared_in<VersionedStateMachine<TrafficState, TrafficEvent>>(
+            resource, std::move(slot), resource);
+
+    // Guards are bound per controller, the definition is shared. The
+    // machine keeps the handler alive, so the guard can hold a plain
+    // pointer that fits inside the std::function.
+    const TrafficLightActionHandler *handler = action_handler.get();
+    state_machine->bind_guard(PEDESTRIAN_GUARD, [handler]() {
+        return handler->has_pedestrian_request();
+    });
+    state_machine->keep_alive(std::move(action_handler));
+    if (counters) {
+        state_machine->set_counters(std::move(counters));
+    }
+    return state_machine;
+}
+
+void TrafficLightFactory::share_type_latency(TrafficLightController &controller,
+                                             TrafficLightType type) {
+#ifdef STATE_MACHINE_LATENCY_HISTOGRAMS
+    controller.share_latency(get_controller_latency(type));
+#else
+    (void)controller;
+    (void)type;
+#endif
+}
+
+std::shared_ptr<ControllerLatency>
+TrafficLightFactory::get_controller_latency(TrafficLightType type) {
+    static auto standard = std::make_shared<ControllerLatency>();
+    static auto simple = std::make_shared<ControllerLatency>();
+    return type == TrafficLightType::SIMPLE ? simple : standard;
+}
+
+std::shared_ptr<TransitionCounters<TrafficState, TrafficEvent>>
+TrafficLightFactory::get_transition_counters(TrafficLightType type) {
+    using Counters = TransitionCounters<TrafficState, TrafficEvent>;
+    const std::size_t states =
+        static_cast<std::size_t>(TrafficState::CAR_RED_YELLOW) + 1;
+    const std::size_t events =
+        static_cast<std::size_t>(TrafficEvent::BUTTON_PRESSED) + 1;
+
+    static auto standard = std::make_shared<Counters>(states, events);
+    static auto simple = std::make_shared<Counters>(states, events);
+    return type == TrafficLightType::SIMPLE ? simple : standard;
+}
+
+std::shared_ptr<const MachineDefinition<TrafficState, TrafficEvent>>
+TrafficLightFactory::build_definition(TrafficLightType type,
+                                      uint64_t version) {
+    MachineDefinition<TrafficState, TrafficEvent>::Builder builder(
+        version, TrafficState::CAR_GREEN);
+
+    builder.add(TrafficState::CAR_GREEN, TrafficEvent::TIME_EXPIRED,
+                TrafficState::CAR_YELLOW);
+    builder.add_guarded(TrafficState::CAR_YELLOW, TrafficEvent::TIME_EXPIRED,
+                        TrafficState::CAR_RED, TrafficState::WALK_PREP,
+                        PEDESTRIAN_GUARD);
+    builder.add(TrafficState::WALK_PREP, TrafficEvent::TIME_EXPIRED,
+                TrafficState::WALK);
+    builder.add(TrafficState::WALK, TrafficEvent::TIME_EXPIRED,
+                TrafficState::WALK_FINISH);
+
+    if (type == TrafficLightType::SIMPLE) {
+        builder.add(TrafficState::CAR_RED, TrafficEvent::TIME_EXPIRED,
+                    TrafficState::CAR_GREEN);
+        builder.add(TrafficState::WALK_FINISH, TrafficEvent::TIME_EXPIRED,
+                    TrafficState::CAR_GREEN);
+        // A light caught in RED_YELLOW by a switch to this cycle goes on
+        // to green, as it would have
+        builder.map_states([](TrafficState state, uint64_t) {
+            return state == TrafficState::CAR_RED_YELLOW
+                       ? TrafficState::CAR_GREEN
+                       : state;
+        });
+    } else {
+        builder.add(TrafficState::CAR_RED, TrafficEvent::TIME_EXPIRED,
+                    TrafficState::CAR_RED_YELLOW);
+        builder.add(TrafficState::CAR_RED_YELLOW, TrafficEvent::TIME_EXPIRED,
+                    TrafficState::CAR_GREEN);
+        builder.add(TrafficState::WALK_FINISH, TrafficEvent::TIME_EXPIRED,
+                    TrafficState::CAR_RED_YELLOW);
+    }
+    return builder.build();
+}
+
+std::shared_ptr<DefinitionSlot<TrafficState, TrafficEvent>>
+TrafficLightFactory::get_definition_slot(TrafficLightType type) {
+    using Slot = DefinitionSlot<TrafficState, TrafficEvent>;
+    static auto standard =
+        std::make_shared<Slot>(build_definition(TrafficLightType::STANDARD));
+    static auto simple =
+        std::make_shared<Slot>(build_definition(TrafficLightType::SIMPLE));
+    return type == TrafficLightType::SIMPLE ? simple : standard;
+}
+
+std::shared_ptr<const TrafficContextTable>
+TrafficLightFactory::get_context_table(TrafficLightType type) {
+    static const auto standard = TrafficLightActionHandler::default_contexts();
+    static const auto simple = []() {
+        // A longer YELLOW stands in for RED_YELLOW
+        auto table = std::make_shared<TrafficContextTable>(*standard);
+        TrafficContext yellow = *standard->find(TrafficState::CAR_YELLOW);
+        yellow.duration = LightTimings::YELLOW_DURATION +
+                          LightTimings::RED_YELLOW_DURATION;
+        table->set(TrafficState::CAR_YELLOW, yellow);
+        return std::shared_ptr<const TrafficContextTable>(std::move(table));
+    }();
+    return type == TrafficLightType::SIMPLE ? simple : standard;
+}
+
+std::shared_ptr<const TrafficContextTable>
+TrafficLightFactory::build_context_table(
+    const MachineDefinition<TrafficState, TrafficEvent> &definition) {
+    // States the definition leaves out keep their default context
+    auto table = std::make_shared<TrafficContextTable>(
+        *TrafficLightActionHandler::default_contexts());
+    for (TrafficState state : definition.get_all_states()) {
+        const StateAttributes *attributes = definition.get_attributes(state);
+        if (attributes) {
+            table->set(state, to_context(state, *attributes));
+        }
+    }
+    return table;
+}
+
+std::shared_ptr<const MachineDefinition<TrafficState, TrafficEvent>>
+TrafficLightFactory::load_definition(const std::string &path) {
+    static const DefinitionLoader<TrafficState, TrafficEvent> loader(
+        [](TrafficState state) { return std::string(to_string(state)); },
+        TrafficLightMachine::STATE_COUNT,
+        [](TrafficEvent event) { return std::string(to_string(event)); },
+        TrafficLightMachine::EVENT_COUNT);
+
+    auto definition = loader.load_file(path);
+    // Reject unknown lamps now rather than when a controller is built
+    build_context_table(*definition);
+    return definition;
 }
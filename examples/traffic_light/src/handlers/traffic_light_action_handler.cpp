@@ -8,53 +8,42 @@
 
 TrafficLightActionHandler::TrafficLightActionHandler(
     std::unique_ptr<IDisplayService<TrafficContext>> ds,
-    std::unique_ptr<ITimerService> ts)
-    : pedestrian_request(false), display_service(std::move(ds)),
-      timer_service(std::move(ts)) {
-
-    // Initialize all states
-    states[TrafficState::CAR_GREEN] = {
-        "CAR_GREEN",
-        LightTimings::GREEN_DURATION,
-        {false, false, true},
-        {true, false},
-    };
-    states[TrafficState::CAR_YELLOW] = {
-        "CAR_YELLOW",
-        LightTimings::YELLOW_DURATION,
-        {false, true, false},
-        {true, false},
-    };
-    states[TrafficState::CAR_RED] = {
-        "CAR_RED",
-        LightTimings::RED_DURATION,
-        {true, false, false},
-        {true, false},
-    };
-    states[TrafficState::WALK_PREP] = {
-        "WALK_PREP",
-        LightTimings::WALK_PREP_DURATION,
-        {true, false, false},
-        {true, false},
-    };
-    states[TrafficState::WALK] = {
-        "WALK",
-        LightTimings::WALK_DURATION,
-        {true, false, false},
-        {false, true},
-    };
-    states[TrafficState::WALK_FINISH] = {
-        "WALK_FINISH",
-        LightTimings::WALK_FINISH_DURATION,
-        {true, false, false},
-        {true, false},
-    };
-    states[TrafficState::CAR_RED_YELLOW] = {
-        "CAR_RED_YELLOW",
-        LightTimings::RED_YELLOW_DURATION,
-        {true, true, false},
-        {true, false},
-    };
+    std::unique_ptr<ITimerService> ts,
+    std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>> published,
+    std::shared_ptr<const TrafficContextTable> contexts)
+    : states(contexts ? std::move(contexts) : default_contexts()),
+      pedestrian_request(false), display_service(std::move(ds)),
+      timer_service(std::move(ts)), published_context(std::move(published)) {}
+
+std::shared_ptr<const TrafficContextTable>
+TrafficLightActionHandler::default_contexts() {
+    static const std::shared_ptr<const TrafficContextTable> shared = []() {
+        auto table = std::make_shared<TrafficContextTable>(
+            static_cast<std::size_t>(TrafficState::CAR_RED_YELLOW) + 1);
+        table->set(TrafficState::CAR_GREEN,
+                   {"CAR_GREEN", LightTimings::GREEN_DURATION,
+                    {false, false, true}, {true, false}});
+        table->set(TrafficState::CAR_YELLOW,
+                   {"CAR_YELLOW", LightTimings::YELLOW_DURATION,
+                    {false, true, false}, {true, false}});
+        table->set(TrafficState::CAR_RED,
+                   {"CAR_RED", LightTimings::RED_DURATION,
+                    {true, false, false}, {true, false}});
+        table->set(TrafficState::WALK_PREP,
+                   {"WALK_PREP", LightTimings::WALK_PREP_DURATION,
+                    {true, false, false}, {true, false}});
+        table->set(TrafficState::WALK,
+                   {"WALK", LightTimings::WALK_DURATION,
+                    {true, false, false}, {false, true}});
+        table->set(TrafficState::WALK_FINISH,
+                   {"WALK_FINISH", LightTimings::WALK_FINISH_DURATION,
+                    {true, false, false}, {true, false}});
+        table->set(TrafficState::CAR_RED_YELLOW,
+                   {"CAR_RED_YELLOW", LightTimings::RED_YELLOW_DURATION,
+                    {true, true, false}, {true, false}});
+        return table;
+    }();
+    return shared;
 }
 
 void TrafficLightActionHandler::handle(TrafficState current_state,
@@ -87,10 +76,13 @@ bool TrafficLightActionHandler::has_pedestrian_request() const {
 
 void TrafficLightActionHandler::display_traffic_state(TrafficState state) {
     /* Lookup guard */
-    auto it = states.find(state);
-    if (it != states.end()) {
-        const auto &ctx = it->second;
+    const TrafficContext *context = states->find(state);
+    if (context) {
+        const auto &ctx = *context;
 
+        if (published_context) {
+            published_context->publish(TrafficContextSnapshot::from(ctx));
+        }
         if (display_service) {
             display_service->show_state(ctx);
         }
@@ -99,9 +91,9 @@ void TrafficLightActionHandler::display_traffic_state(TrafficState state) {
 
 void TrafficLightActionHandler::start_state_timer(TrafficState state) {
     /* Lookup guard */
-    auto it = states.find(state);
-    if (it != states.end()) {
-        const auto &ctx = it->second;
+    const TrafficContext *context = states->find(state);
+    if (context) {
+        const auto &ctx = *context;
         uint32_t duration_sec = ctx.duration;
 
         if (timer_service) {
@@ -116,10 +108,19 @@ void TrafficLightActionHandler::handle_button_press_event() {
 }
 void TrafficLightActionHandler::set_state_timeout(const TrafficState state,
                                                   uint32_t timeout) {
-    states[state].duration = timeout;
+    auto copy = std::make_shared<TrafficContextTable>(*states);
+    TrafficContext context;
+    if (const TrafficContext *current = states->find(state)) {
+        context = *current;
+    }
+    context.duration = timeout;
+    copy->set(state, context);
+    states = std::move(copy);
 }
 
 void TrafficLightActionHandler::configure_state(TrafficState state,
                                                 const TrafficContext &config) {
-    states[state] = config;
+    auto copy = std::make_shared<TrafficContextTable>(*states);
+    copy->set(state, config);
+    states = std::move(copy);
 }
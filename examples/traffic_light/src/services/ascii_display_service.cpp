@@ -136,3 +136,15 @@ void AsciiDisplayService::set_color_enabled(bool enabled) {
 
     color_enabled = enabled;
 }
+
+bool AsciiDisplayService::render_latest(
+    const SeqlockSlot<TrafficContextSnapshot> &slot, uint64_t &seen_version) {
+    uint64_t version = 0;
+    TrafficContextSnapshot snapshot = slot.read(&version);
+    if (version == seen_version)
+        return false;
+
+    seen_version = version;
+    show_state(snapshot.to_context());
+    return true;
+}
@@ -0,0 +1,191 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include <state_machine/state_machine.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Traffic light domain types
+#include "controllers/traffic_light_controller.h"
+#include "factories/traffic_light_factory.h"
+#include "models/traffic_events.h"
+
+using namespace state_machine;
+
+namespace {
+
+const char *const BOARD_NAME = "/traffic_light_fleet_board";
+const std::size_t STATE_COUNT = TrafficLightMachine::STATE_COUNT;
+const std::size_t LIGHT_ARENA_BYTES = 512; // one controller graph
+
+/**
+ * @brief One traffic light of a shard: an unchanged factory-built
+ *        controller whose timeouts run on the shard's executor
+ */
+class FleetLight {
+  private:
+    Executor<TrafficEvent> &executor_;
+    Executor<TrafficEvent>::InstanceId instance_ = 0;
+    std::atomic<Executor<TrafficEvent>::TimerId> timer_{0};
+    std::shared_ptr<TrafficLightController> controller_;
+
+  public:
+    FleetLight(Executor<TrafficEvent> &executor, uint32_t fleet_id,
+               std::shared_ptr<StateBoard> board,
+               pmr::memory_resource *arena)
+        : executor_(executor) {
+        controller_ = TrafficLightFactory::create_controller_in(
+            arena, TrafficLightType::STANDARD, nullptr,
+            std::make_unique<FunctionTimerService>(
+                [this](uint32_t seconds) { start_timer(seconds); }));
+        if (board) {
+            controller_->add_transition_hook(
+                std::make_shared<
+                    StateBoardPublisher<TrafficState, TrafficEvent>>(
+                    board, "light-" + std::to_string(fleet_id),
+                    TrafficState::CAR_GREEN, fleet_id));
+        }
+        instance_ = executor_.add_instance(
+            [this](TrafficEvent event) { handle_event(event); });
+    }
+
+    Executor<TrafficEvent>::InstanceId get_instance() const {
+        return instance_;
+    }
+
+    void start_timer(uint32_t seconds) {
+        // Re-arming replaces the pending timeout
+        auto previous = timer_.exchange(executor_.schedule_event(
+            instance_, std::chrono::seconds(seconds),
+            TrafficEvent::TIME_EXPIRED));
+        if (previous != 0) {
+            executor_.cancel_timer(previous);
+        }
+    }
+
+  private:
+    void handle_event(TrafficEvent event) {
+        switch (event) {
+        case TrafficEvent::TIME_EXPIRED:
+            controller_->timeout_expired();
+            break;
+        case TrafficEvent::BUTTON_PRESSED:
+            controller_->button_pressed();
+            break;
+        }
+    }
+};
+
+// Body of every shard process
+int run_shard(ShardContext &context) {
+    // Controllers log each transition; a fleet would drown the terminal
+    int null_fd = ::open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+        ::dup2(null_fd, STDOUT_FILENO);
+        ::close(null_fd);
+    }
+
+    Executor<TrafficEvent> executor;
+    auto reactor = std::make_shared<Reactor>();
+    ShardIngress<TrafficEvent> ingress(context, *reactor, executor);
+    ingress.on_stop([&executor]() { executor.request_stop(); });
+
+    // Every controller of the shard lives here and is freed in one go
+    // after the lights are destroyed
+    pmr::monotonic_buffer_resource arena(context.instance_ids.size() *
+                                         LIGHT_ARENA_BYTES);
+    std::vector<std::unique_ptr<FleetLight>> lights;
+    for (uint32_t id : context.instance_ids) {
+        lights.emplace_back(
+            new FleetLight(executor, id, context.board, &arena));
+        ingress.route(id, lights.back()->get_instance());
+    }
+
+    executor.add_source(reactor);
+    executor.start();
+    for (auto &light : lights) {
+        light->start_timer(1);
+    }
+    executor.wait_for_completion();
+    return 0;
+}
+
+void print_summary(FleetCoordinator &fleet, std::size_t light_count) {
+    std::size_t histogram[STATE_COUNT] = {};
+    StateBoardEntry entry;
+    for (uint32_t id = 0; id < light_count; ++id) {
+        if (fleet.query(id, entry) && entry.state < STATE_COUNT) {
+            ++histogram[entry.state];
+        }
+    }
+
+    for (std::size_t shard = 0; shard < fleet.get_shard_count(); ++shard) {
+        const ShardControl &control = fleet.get_control(shard);
+        std::cout << "  shard " << shard << " pid " << fleet.get_pid(shard)
+                  << ": received " << control.received.load()
+                  << ", handled " << control.handled.load() << ", restarts "
+                  << fleet.get_restarts(shard) << std::endl;
+    }
+    std::cout << " ";
+    for (std::size_t state = 0; state < STATE_COUNT; ++state) {
+        std::cout << " " << static_cast<TrafficState>(state) << "="
+                  << histogram[state];
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    FleetOptions options;
+    options.shard_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4;
+    options.instance_count =
+        argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+    int seconds = argc > 3 ? std::atoi(argv[3]) : 10;
+    options.board_name = BOARD_NAME;
+
+    try {
+        FleetCoordinator fleet(options, run_shard);
+        fleet.start();
+        std::cout << options.instance_count << " traffic lights on "
+                  << options.shard_count << " shard processes; kill one to "
+                  << "watch it restart" << std::endl;
+
+        // Pedestrians press buttons at random lights
+        std::mt19937 random(42);
+        std::uniform_int_distribution<uint32_t> pick(
+            0, static_cast<uint32_t>(options.instance_count) - 1);
+        std::vector<EventFrame> presses(options.instance_count / 10 + 1);
+
+        for (int tick = 1; tick <= seconds * 10; ++tick) {
+            for (auto &press : presses) {
+                press = {pick(random),
+                         static_cast<uint16_t>(TrafficEvent::BUTTON_PRESSED),
+                         0, 0, 0};
+            }
+            fleet.route(presses.data(), presses.size());
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            if (tick % 10 == 0) {
+                std::size_t restarted = fleet.restart_failed();
+                if (restarted > 0) {
+                    std::cout << "Restarted " << restarted << " shard(s)"
+                              << std::endl;
+                }
+                std::cout << "After " << tick / 10 << "s:" << std::endl;
+                print_summary(fleet, options.instance_count);
+            }
+        }
+        fleet.stop();
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
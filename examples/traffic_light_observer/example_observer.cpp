@@ -1,4 +1,6 @@
 #include <chrono>
+#include <ctime>
+#include <iomanip>
 #include <iostream>
 #include <state_machine/state_machine.h>
 #include <thread>
@@ -10,7 +12,6 @@
 #include "console_display_service.h"
 #include "console_logger_observer.h"
 #include "display_observer.h"
-#include "file_logger_observer.h"
 #include "pedestrian_observer.h"
 #include "timer_observer.h"
 #include "traffic_events.h"
@@ -76,13 +77,14 @@ auto create_observers(std::unique_ptr<ConsoleDisplayService> display_service,
     // Pedestrian observer
     auto pedestrian_observer = std::make_shared<PedestrianObserver>(true);
     std::cout << "   Pedestrian observer" << std::endl;
-    // File logger observer
-    auto file_logger =
-        std::make_shared<FileLoggerObserver>("traffic_observer_demo.log");
-    std::cout << "   File logger observer" << std::endl;
+    // Binary trace observer (render with traffic_trace_decoder)
+    auto trace_observer =
+        std::make_shared<TraceObserver<TrafficState, TrafficEvent>>(
+            std::make_shared<TraceWriter>("traffic_observer_demo.trace"));
+    std::cout << "   Trace observer" << std::endl;
 
     return std::make_tuple(console_logger, display_observer, timer_observer,
-                           pedestrian_observer, file_logger);
+                           pedestrian_observer, trace_observer);
 }
 
 // Setup state transitions
@@ -142,14 +144,15 @@ void attach_observers(TrafficController *controller,
                       std::shared_ptr<DisplayObserver> display_observer,
                       std::shared_ptr<TimerObserver> timer_observer,
                       std::shared_ptr<PedestrianObserver> pedestrian_observer,
-                      std::shared_ptr<FileLoggerObserver> file_logger) {
+                      std::shared_ptr<TraceObserver<TrafficState, TrafficEvent>>
+                          trace_observer) {
 
     std::cout << "Attaching observers to controller..." << std::endl;
 
     controller->add_observer(console_logger);
     controller->add_observer(display_observer);
     controller->add_observer(pedestrian_observer);
-    controller->add_observer(file_logger);
+    controller->add_observer(trace_observer);
     controller->add_observer(timer_observer);
 
     std::cout << "All observers attached" << std::endl;
@@ -293,7 +296,7 @@ int main() {
 
         std::cout << "\n Step 3: Creating observers" << std::endl;
         auto [console_logger, display_observer, timer_observer,
-              pedestrian_observer, file_logger] =
+              pedestrian_observer, trace_observer] =
             create_observers(std::move(display_service),
                              std::move(timer_service));
 
@@ -303,7 +306,7 @@ int main() {
         // Step 5: Attach observers
         std::cout << "\n Step 5: Attaching observers" << std::endl;
         attach_observers(controller.get(), console_logger, display_observer,
-                         timer_observer, pedestrian_observer, file_logger);
+                         timer_observer, pedestrian_observer, trace_observer);
 
         std::cout << "\n All components ready! Starting demos..." << std::endl;
 
@@ -1,4 +1,6 @@
 #include "file_logger_observer.h"
+#include <chrono>
+#include <ctime>
 #include <iomanip>
 #include <sstream>
 #include <stdexcept>
@@ -37,7 +39,7 @@ void FileLoggerObserver::on_state_transition(TrafficState from,
         log_file << " (no change)";
     }
 
-    log_file << std::endl;
+    log_file << '\n';
 
     if (auto_flush) {
         log_file.flush();
@@ -0,0 +1,51 @@
+#include <iostream>
+#include <state_machine/tracing/columnar_trace.h>
+#include <string>
+
+#include <sys/stat.h>
+
+using namespace state_machine;
+
+// Converts a binary trace into columnar blocks for long-term retention
+namespace {
+
+long long file_size(const std::string &filename) {
+    struct stat info;
+    return ::stat(filename.c_str(), &info) == 0 ? info.st_size : -1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 3 || argc > 4) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <trace file> <columnar file> [records per block]"
+                  << std::endl;
+        return 1;
+    }
+
+    try {
+        std::size_t block_records = ColumnarTraceWriter::DEFAULT_BLOCK_RECORDS;
+        if (argc == 4) {
+            block_records = std::stoul(argv[3]);
+        }
+
+        std::size_t records =
+            convert_trace_to_columnar(argv[1], argv[2], block_records);
+
+        long long input = file_size(argv[1]);
+        long long output = file_size(argv[2]);
+        std::cout << "Converted " << records << " records: " << input
+                  << " -> " << output << " bytes";
+        if (output > 0) {
+            std::cout << " (" << static_cast<double>(input) / output
+                      << "x smaller)";
+        }
+        std::cout << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <state_machine/tracing/columnar_trace.h>
+#include <state_machine/tracing/trace_reader.h>
+
+#include "traffic_events.h"
+#include "traffic_states.h"
+
+using namespace state_machine;
+
+// Renders a binary or columnar trace in the layout FileLoggerObserver writes
+namespace {
+
+void print_timestamp(std::ostream &os, int64_t system_ns) {
+    std::time_t seconds = static_cast<std::time_t>(system_ns / 1000000000);
+    int64_t ms = (system_ns / 1000000) % 1000;
+
+    os << std::put_time(std::localtime(&seconds), "%Y-%m-%d %H:%M:%S");
+    os << "." << std::setfill('0') << std::setw(3) << ms << std::setfill(' ');
+}
+
+void print_record(const TraceFileHeader &header, const TraceRecord &record) {
+    auto from = static_cast<TrafficState>(record.from_state);
+    auto event = static_cast<TrafficEvent>(record.event);
+    auto to = static_cast<TrafficState>(record.to_state);
+
+    print_timestamp(std::cout, trace_ticks_to_system_ns(header, record.ticks));
+    std::cout << " | #" << record.instance_id << " ";
+    std::cout << std::setw(8) << from << " --[" << std::setw(12) << event
+              << "]--> " << std::setw(8) << to;
+    if (from == to) {
+        std::cout << " (no change)";
+    }
+    std::cout << '\n';
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <trace file>" << std::endl;
+        return 1;
+    }
+
+    try {
+        if (is_columnar_trace(argv[1])) {
+            ColumnarTraceReader reader(argv[1]);
+            reader.scan_all([&reader](const TraceRecord &record) {
+                print_record(reader.get_header(), record);
+            });
+            return 0;
+        }
+
+        TraceFileReader reader(argv[1]);
+        TraceRecord record;
+        while (reader.next(record)) {
+            print_record(reader.get_header(), record);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <state_machine/tracing/trace_query.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "traffic_events.h"
+#include "traffic_states.h"
+
+using namespace state_machine;
+
+// Answers dwell-time, wait-time, path and pattern questions over traces
+// written by TraceObserver, e.g. how long pedestrians waited between
+// BUTTON_PRESSED and WALK:
+//
+//   traffic_trace_query wait BUTTON_PRESSED WALK traffic_observer_demo.trace
+namespace {
+
+int find_state(const std::string &name) {
+    for (int value = 0; value < 256; ++value) {
+        std::string candidate = to_string(static_cast<TrafficState>(value));
+        if (candidate == "UNKNOWN_STATE")
+            break;
+        if (candidate == name)
+            return value;
+    }
+    return TraceStep::ANY;
+}
+
+int find_event(const std::string &name) {
+    for (int value = 0; value < 256; ++value) {
+        std::string candidate = to_string(static_cast<TrafficEvent>(value));
+        if (candidate == "UNKNOWN_EVENT")
+            break;
+        if (candidate == name)
+            return value;
+    }
+    return TraceStep::ANY;
+}
+
+int require_state(const std::string &name) {
+    int value = find_state(name);
+    if (value == TraceStep::ANY)
+        throw std::invalid_argument("Unknown state: " + name);
+    return value;
+}
+
+int require_event(const std::string &name) {
+    int value = find_event(name);
+    if (value == TraceStep::ANY)
+        throw std::invalid_argument("Unknown event: " + name);
+    return value;
+}
+
+// An event name matches that event, a state name matches entering it
+TraceStep parse_marker(const std::string &name) {
+    TraceStep step;
+    if (find_event(name) != TraceStep::ANY) {
+        step.event = find_event(name);
+    } else {
+        step.to_state = require_state(name);
+        step.state_change = true;
+    }
+    return step;
+}
+
+// FROM:EVENT:TO with '*' as wildcard
+TraceStep parse_step(const std::string &text) {
+    std::vector<std::string> parts;
+    std::istringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, ':')) {
+        parts.push_back(part);
+    }
+    if (parts.size() != 3) {
+        throw std::invalid_argument("Expected FROM:EVENT:TO, got " + text);
+    }
+
+    TraceStep step;
+    if (parts[0] != "*")
+        step.from_state = require_state(parts[0]);
+    if (parts[1] != "*")
+        step.event = require_event(parts[1]);
+    if (parts[2] != "*")
+        step.to_state = require_state(parts[2]);
+    return step;
+}
+
+std::vector<TraceStep> parse_pattern(const std::string &text) {
+    std::vector<TraceStep> steps;
+    std::istringstream stream(text);
+    std::string step;
+    while (std::getline(stream, step, ',')) {
+        steps.push_back(parse_step(step));
+    }
+    return steps;
+}
+
+void print_stats(const DurationStats &stats) {
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "  samples: " << stats.count << "\n";
+    if (stats.count == 0)
+        return;
+    std::cout << "  mean:    " << stats.mean_ns / 1e6 << " ms\n"
+              << "  min:     " << stats.min_ns / 1e6 << " ms\n"
+              << "  p50:     " << stats.p50_ns / 1e6 << " ms\n"
+              << "  p99:     " << stats.p99_ns / 1e6 << " ms\n"
+              << "  max:     " << stats.max_ns / 1e6 << " ms\n";
+}
+
+void print_usage(const char *program) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << program << " dwell <STATE> <trace>...\n"
+        << "  " << program << " wait <EVENT|STATE> <EVENT|STATE> <trace>...\n"
+        << "  " << program << " paths <LENGTH> <trace>...\n"
+        << "  " << program << " pattern <FROM:EVENT:TO>[,...] <trace>...\n"
+        << "Use '*' as a wildcard inside pattern steps." << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string command = argv[1];
+    int first_file = command == "wait" ? 4 : 3;
+    if (argc <= first_file) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        std::vector<std::string> files(argv + first_file, argv + argc);
+        TraceQueryEngine engine(files);
+        std::cout << "Indexed " << engine.get_record_count() << " records of "
+                  << engine.get_instance_count() << " instance(s)\n";
+
+        if (command == "dwell") {
+            std::cout << "Dwell time in " << argv[2] << ":\n";
+            print_stats(engine.dwell_time(
+                static_cast<uint8_t>(require_state(argv[2]))));
+        } else if (command == "wait") {
+            std::cout << "Wait from " << argv[2] << " to " << argv[3] << ":\n";
+            print_stats(
+                engine.wait_time(parse_marker(argv[2]), parse_marker(argv[3])));
+        } else if (command == "paths") {
+            std::size_t length = std::stoul(argv[2]);
+            for (const auto &path : engine.path_frequency(length)) {
+                std::cout << std::setw(10) << path.count << "  ";
+                for (std::size_t i = 0; i < path.states.size(); ++i) {
+                    std::cout << (i ? " -> " : "")
+                              << static_cast<TrafficState>(path.states[i]);
+                }
+                std::cout << "\n";
+            }
+        } else if (command == "pattern") {
+            std::cout << "Matches: "
+                      << engine.count_sequence(parse_pattern(argv[2])) << "\n";
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,5 +1,7 @@
+#include <atomic>
 #include <iostream>
 #include <memory>
+#include <thread>
 #include <state_machine/state_machine.h>
 
 // Traffic light domain types
@@ -17,9 +19,21 @@ class TrafficLightApp {
   private:
     std::unique_ptr<TrafficLightController> controller_;
     std::unique_ptr<TrafficExecutor> executor_;
+    std::shared_ptr<MetricsRegistry> metrics_ =
+        std::make_shared<MetricsRegistry>();
+    std::shared_ptr<FlightRecorder<TrafficState, TrafficEvent>> recorder_ =
+        std::make_shared<FlightRecorder<TrafficState, TrafficEvent>>(
+            "traffic_light");
+
+    // With async_display the handler only publishes its context and a
+    // display thread renders the latest one at its own pace
+    bool async_display_;
+    std::shared_ptr<SeqlockSlot<TrafficContextSnapshot>> context_slot_ =
+        std::make_shared<SeqlockSlot<TrafficContextSnapshot>>();
 
   public:
-    TrafficLightApp() {
+    explicit TrafficLightApp(bool async_display = false)
+        : async_display_(async_display) {
         // Create timer service that integrates with TrafficExecutor
         auto timer_service = std::make_unique<FunctionTimerService>(
             [this](uint32_t duration_sec) {
@@ -27,9 +41,13 @@ class TrafficLightApp {
             });
 
         // Create controller using factory (like in demo())
+        std::unique_ptr<IDisplayService<TrafficContext>> display;
+        if (!async_display_) {
+            display = std::make_unique<AsciiDisplayService>();
+        }
         controller_ = TrafficLightFactory::create_controller(
-            TrafficLightType::STANDARD, std::make_unique<AsciiDisplayService>(),
-            std::move(timer_service));
+            TrafficLightType::STANDARD, std::move(display),
+            std::move(timer_service), context_slot_);
 
         // Create executor with event/input handlers
         executor_ = std::make_unique<TrafficExecutor>(
@@ -48,17 +66,66 @@ class TrafficLightApp {
     void run_simulation() {
         std::cout << "=== Simulation Mode (from original main.cpp) ==="
                   << std::endl;
-        std::cout << "Press any key for pedestrian button, 'q' to quit"
+        std::cout << "Press any key for pedestrian button, 'd' to dump the "
+                     "flight recorder, 'q' to quit"
                   << std::endl;
 
+        // Last transitions are written to stderr if the process crashes
+        controller_->add_transition_hook(recorder_);
+        install_flight_recorder_signal_handlers();
+
+        // Pull-based metrics: curl --unix-socket <path> http://localhost/
+        auto controller_metrics =
+            std::make_shared<ControllerMetrics<TrafficState, TrafficEvent>>();
+        controller_->add_transition_hook(controller_metrics);
+        register_controller_metrics(*metrics_, controller_metrics,
+                                    {{"controller", "traffic_light"}});
+        executor_->register_metrics(*metrics_,
+                                    {{"executor", "traffic_light"}});
+
+        // Out-of-process monitors map the board and poll the state
+        std::shared_ptr<StateBoard> board;
+        try {
+            board = StateBoard::create("/traffic_light_board", 16);
+            controller_->add_transition_hook(
+                std::make_shared<
+                    StateBoardPublisher<TrafficState, TrafficEvent>>(
+                    board, "traffic_light", TrafficState::CAR_GREEN));
+            std::cout << "State board in shared memory "
+                      << board->get_name() << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "State board disabled: " << e.what() << std::endl;
+        }
+
+        MetricsExporter exporter(metrics_, "traffic_light_metrics.sock");
+        try {
+            exporter.start();
+            std::cout << "Metrics on unix socket "
+                      << exporter.get_socket_path() << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "Metrics disabled: " << e.what() << std::endl;
+        }
+
         // Start threaded simulation (replaces original pthread code)
         executor_->start();
 
+        std::atomic<bool> displaying{async_display_};
+        std::thread display_thread([this, &displaying]() {
+            AsciiDisplayService display;
+            uint64_t seen_version = 0;
+            while (displaying) {
+                display.render_latest(*context_slot_, seen_version);
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        });
+
         // Start initial timer (replaces start_timeout(1) from main.cpp)
         executor_->start_timer(std::chrono::seconds(1));
 
         // Wait for completion (replaces pthread_join calls)
         executor_->wait_for_completion();
+        displaying = false;
+        display_thread.join();
 
         std::cout << "Simulation ended." << std::endl;
     }
@@ -77,7 +144,16 @@ class TrafficLightApp {
     }
 
     void handle_input(char input) {
-        if (input != 'q' && input != 'Q') {
+        if (input == 'd' || input == 'D') {
+            recorder_->dump(
+                std::cout,
+                [](TrafficState state) {
+                    return std::string(to_string(state));
+                },
+                [](TrafficEvent event) {
+                    return std::string(to_string(event));
+                });
+        } else if (input != 'q' && input != 'Q') {
             std::cout << "Pedestrian button pressed!" << std::endl;
             executor_->send_button_event();
         }
@@ -133,7 +209,8 @@ int main() {
     }
 
     try {
-        TrafficLightApp app;
+        // Simulation renders from a display thread, demo renders inline
+        TrafficLightApp app(choice != 1);
 
         if (choice == 1) {
             app.run_demo();
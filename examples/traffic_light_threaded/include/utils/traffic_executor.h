@@ -4,42 +4,33 @@
 
 #include <atomic>
 #include <chrono>
-#include <condition_variable>
 #include <functional>
 #include <memory>
-#include <mutex>
-#include <queue>
-#include <thread>
+#include <vector>
 
-// Domain-specific threading wrapper for Traffic Light
+// Domain-specific wrapper binding one traffic light to a generic Executor.
+// Several intersections may share one executor (and its worker pool).
 class TrafficExecutor {
   public:
     using EventHandler = std::function<void(TrafficEvent)>;
     using InputHandler = std::function<void(char)>;
+    using Stats = state_machine::ExecutorStats;
+    using SharedExecutor = std::shared_ptr<state_machine::Executor<TrafficEvent>>;
 
   private:
-    // Modern C++17 threading (replaces pthread mess from main.cpp)
-    std::atomic<bool> running_{false};
-    std::mutex event_mutex_;
-    std::condition_variable event_cv_;
-    std::queue<TrafficEvent> event_queue_;
-
-    std::thread worker_thread_;
-    std::thread input_thread_;
-    std::thread timer_thread_;
-
-    // Callbacks
-    EventHandler event_handler_;
-    InputHandler input_handler_;
+    SharedExecutor executor_;
+    bool owns_executor_;
+    state_machine::Executor<TrafficEvent>::InstanceId instance_;
+
+    // Pending timeout, 0 when none (replaces global variables from main.cpp)
+    std::atomic<state_machine::Executor<TrafficEvent>::TimerId> timer_{0};
 
-    // Timer state (replaces global variables from main.cpp)
-    std::atomic<bool> timer_active_{false};
-    std::chrono::steady_clock::duration timer_duration_;
-    std::mutex timer_mutex_;
-    std::condition_variable timer_cv_;
+    InputHandler input_handler_;
 
   public:
-    TrafficExecutor(EventHandler event_handler, InputHandler input_handler);
+    // Without an executor, a private single-worker one is created
+    TrafficExecutor(EventHandler event_handler, InputHandler input_handler,
+                    SharedExecutor executor = nullptr);
     ~TrafficExecutor();
 
     // API that replaces main.cpp functions
@@ -49,9 +40,13 @@ class TrafficExecutor {
     void wait_for_completion(); // Replaces pthread_join calls
     void send_button_event();
 
+    const Stats &get_stats() const { return *executor_->get_stats(); }
+
+    // Exposes queue depth, lag and timer occupancy through a registry
+    std::vector<std::size_t>
+    register_metrics(state_machine::MetricsRegistry &registry,
+                     const state_machine::MetricLabels &labels) const;
+
   private:
-    // Modern C++ replacements for main.cpp pthread functions
-    void worker_loop(); // Replaces worker()
-    void input_loop();  // Replaces read_char()
-    void timer_loop();  // Replaces timeout_generator()
+    bool on_input(char input); // Replaces read_char()
 };
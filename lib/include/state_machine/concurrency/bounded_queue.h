@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace state_machine {
+
+/**
+ * @brief Fixed-capacity multi-producer, multi-consumer FIFO
+ *
+ * A ring of cells, each with a sequence number telling producers and
+ * consumers whose turn it is (Vyukov's bounded queue). Both sides claim a
+ * position with one compare-and-swap and never allocate. Any capacity is
+ * allowed; positions map to cells modulo the ring size. A single cell
+ * cannot tell full from free by its sequence alone, so a capacity of one
+ * gets a ring of two and producers also check the distance to the
+ * consumer.
+ */
+template <typename T> class BoundedQueue {
+  private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    // Producers and consumers claim positions on separate cache lines
+    struct Position {
+        std::atomic<std::size_t> value{0};
+        char padding[64 - sizeof(std::atomic<std::size_t>)];
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    std::size_t capacity; // ring size, at least two
+    std::size_t limit;    // events the queue may hold
+    Position enqueue;
+    Position dequeue;
+
+  public:
+    explicit BoundedQueue(std::size_t queue_capacity)
+        : capacity(queue_capacity < 2 ? 2 : queue_capacity),
+          limit(queue_capacity == 0 ? 1 : queue_capacity) {
+        cells.reset(new Cell[capacity]);
+        for (std::size_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    // @return false if the queue is full
+    bool try_push(T value) {
+        std::size_t position = enqueue.value.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &cells[position % capacity];
+            std::size_t sequence =
+                cell->sequence.load(std::memory_order_acquire);
+            intptr_t turn = static_cast<intptr_t>(sequence) -
+                            static_cast<intptr_t>(position);
+            if (turn == 0) {
+                if (limit < capacity &&
+                    position - dequeue.value.load(std::memory_order_acquire) >=
+                        limit)
+                    return false;
+                if (enqueue.value.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed))
+                    break;
+            } else if (turn < 0) {
+                return false;
+            } else {
+                position = enqueue.value.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // @return false if the queue is empty
+    bool try_pop(T &out) {
+        std::size_t position = dequeue.value.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &cells[position % capacity];
+            std::size_t sequence =
+                cell->sequence.load(std::memory_order_acquire);
+            intptr_t turn = static_cast<intptr_t>(sequence) -
+                            static_cast<intptr_t>(position + 1);
+            if (turn == 0) {
+                if (dequeue.value.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed))
+                    break;
+            } else if (turn < 0) {
+                return false;
+            } else {
+                position = dequeue.value.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(cell->value);
+        cell->sequence.store(position + capacity, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        std::size_t position = dequeue.value.load(std::memory_order_relaxed);
+        return cells[position % capacity].sequence.load(
+                   std::memory_order_acquire) != position + 1;
+    }
+
+    // May report full while a concurrent push is mid-way
+    bool full() const {
+        std::size_t position = enqueue.value.load(std::memory_order_relaxed);
+        if (limit < capacity &&
+            position - dequeue.value.load(std::memory_order_acquire) >= limit)
+            return true;
+        return cells[position % capacity].sequence.load(
+                   std::memory_order_acquire) != position;
+    }
+
+    std::size_t get_capacity() const { return limit; }
+};
+
+} // namespace state_machine
@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+namespace state_machine {
+
+/**
+ * @brief Unbounded multi-producer, single-consumer FIFO
+ *
+ * Producers link a new node with one atomic exchange and never wait on
+ * each other or on the consumer. The consumer may be a different thread
+ * over time as long as hand-offs between consumers are synchronized.
+ * A push that has swapped the head but not yet linked its node is not
+ * visible to pop() until it finishes. T must be default constructible.
+ */
+template <typename T> class MpscQueue {
+  private:
+    struct Node {
+        std::atomic<Node *> next{nullptr};
+        T value;
+    };
+
+    std::atomic<Node *> head; // most recently pushed node
+    Node *tail;               // consumer side; its value is already taken
+
+  public:
+    MpscQueue() {
+        Node *stub = new Node();
+        head.store(stub, std::memory_order_relaxed);
+        tail = stub;
+    }
+
+    ~MpscQueue() {
+        while (tail) {
+            Node *next = tail->next.load(std::memory_order_relaxed);
+            delete tail;
+            tail = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    void push(T value) {
+        Node *node = new Node();
+        node->value = std::move(value);
+        Node *previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Consumer only
+    bool pop(T &out) {
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+        out = std::move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+    // Consumer only
+    bool empty() const {
+        return tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
+
+} // namespace state_machine
@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace state_machine {
+
+/**
+ * @brief Single-writer publication slot for a trivially copyable value
+ *
+ * The writer never blocks: publish() bumps a sequence counter to odd,
+ * stores the value as atomic words and bumps the counter to even. Any
+ * number of readers copy the words and retry if the counter moved, so
+ * they always see a complete value. Concurrent writers must serialize
+ * among themselves.
+ */
+template <typename T> class SeqlockSlot {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqlockSlot needs a trivially copyable type");
+
+  private:
+    static constexpr std::size_t WORDS =
+        (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> words[WORDS];
+
+  public:
+    SeqlockSlot() {
+        for (auto &word : words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    explicit SeqlockSlot(const T &initial) : SeqlockSlot() {
+        publish(initial);
+    }
+
+    SeqlockSlot(const SeqlockSlot &) = delete;
+    SeqlockSlot &operator=(const SeqlockSlot &) = delete;
+
+    void publish(const T &value) {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        uint64_t current = sequence.load(std::memory_order_relaxed);
+        sequence.store(current + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        sequence.store(current + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy the value unless a publish is in progress
+     * @param version Set to the number of publishes the copy reflects
+     * @return false if the copy raced with the writer; retry later
+     */
+    bool try_read(T &out, uint64_t *version = nullptr) const {
+        uint64_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            return false;
+
+        uint64_t buffer[WORDS];
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            buffer[i] = words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) != before)
+            return false;
+
+        std::memcpy(&out, buffer, sizeof(T));
+        if (version) {
+            *version = before / 2;
+        }
+        return true;
+    }
+
+    // Retries until a consistent copy is made
+    T read(uint64_t *version = nullptr) const {
+        T out;
+        while (!try_read(out, version)) {
+            std::this_thread::yield();
+        }
+        return out;
+    }
+
+    // Number of completed publishes; 0 means nothing was published yet
+    uint64_t get_version() const {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+};
+
+template <typename T> constexpr std::size_t SeqlockSlot<T>::WORDS;
+
+} // namespace state_machine
@@ -1,33 +1,74 @@
 #pragma once
+#include "../memory/memory_resource.h"
+#include "../metrics/latency_histogram.h"
 #include "action_handler.h"
 #include "state_machine.h"
+#include "transition_hook.h"
 #include <memory>
+#include <vector>
 
 namespace state_machine {
 
 /**
  * @brief Base controller providing common functionality
+ *
+ * The hook list and latency histograms allocate from the memory resource
+ * given at construction, which must outlive the controller. Histogram
+ * shards are taken at the first event, on the thread that handles it.
  */
 template <typename StateType, typename EventType> class BaseController {
   private:
+    using HookPtr = std::shared_ptr<ITransitionHook<StateType, EventType>>;
+
     std::shared_ptr<IStateMachine<StateType, EventType>> state_machine;
     std::shared_ptr<IActionHandler<StateType, EventType>> action_handler;
+    std::vector<HookPtr, pmr::polymorphic_allocator<HookPtr>> hooks;
+#ifdef STATE_MACHINE_LATENCY_HISTOGRAMS
+    std::shared_ptr<ControllerLatency> latency;
+#endif
 
   public:
-    BaseController(std::shared_ptr<IStateMachine<StateType, EventType>> sm,
-                   std::shared_ptr<IActionHandler<StateType, EventType>> ah)
-        : state_machine(sm), action_handler(ah) {}
+    BaseController(
+        std::shared_ptr<IStateMachine<StateType, EventType>> sm,
+        std::shared_ptr<IActionHandler<StateType, EventType>> ah,
+        pmr::memory_resource *resource = pmr::get_default_resource())
+        : state_machine(sm), action_handler(ah), hooks(resource) {
+#ifdef STATE_MACHINE_LATENCY_HISTOGRAMS
+        latency = allocate_shared_in<ControllerLatency>(resource, resource);
+#endif
+    }
 
     virtual ~BaseController() = default;
 
+    // Hooks run in registration order for every handled event
+    void add_transition_hook(
+        std::shared_ptr<ITransitionHook<StateType, EventType>> hook) {
+        hooks.push_back(hook);
+    }
+
+#ifdef STATE_MACHINE_LATENCY_HISTOGRAMS
+    ControllerLatencySnapshot latency_snapshot() const {
+        return latency->snapshot();
+    }
+
+    // Lets several controllers record into one set of histograms
+    void share_latency(std::shared_ptr<ControllerLatency> shared) {
+        latency = shared;
+    }
+#endif
+
   protected:
     void handle_event(EventType event) {
-        StateType current_state = state_machine->get_current_state();
-        StateType new_state = current_state;
-        bool ret = state_machine->process_event(event);
-        if (ret) { // true means that event raised state change
-            new_state = state_machine->get_current_state();
+        StateType current_state;
+        StateType new_state;
+        {
+            STATE_MACHINE_LATENCY_SCOPE(latency->lookup);
+            state_machine->apply_event(event, current_state, new_state);
+        }
+        for (const auto &hook : hooks) {
+            hook->on_transition(current_state, event, new_state);
         }
+        STATE_MACHINE_LATENCY_SCOPE(latency->handler);
         action_handler->handle(current_state, event, new_state);
     }
 
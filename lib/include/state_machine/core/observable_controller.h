@@ -1,7 +1,12 @@
 #pragma once
+#include "../memory/memory_resource.h"
+#include "../metrics/latency_histogram.h"
 #include "state_machine.h"
 #include "subject.h"
+#include "transition_hook.h"
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -9,21 +14,53 @@ namespace state_machine {
 
 /**
  * @brief Observable controller that notifies observers about state transitions
- * Alternative to BaseController for modern observer-based architecture
+ * Alternative to BaseController for modern observer-based architecture.
+ * Like BaseController, its lists allocate from the given memory resource.
  */
 template <typename StateType, typename EventType>
 class ObservableController : public ISubject<StateType, EventType> {
   private:
+    using ObserverRef = std::weak_ptr<IObserver<StateType, EventType>>;
+    using HookPtr = std::shared_ptr<ITransitionHook<StateType, EventType>>;
+
     std::shared_ptr<IStateMachine<StateType, EventType>> state_machine;
-    std::vector<std::weak_ptr<IObserver<StateType, EventType>>> observers;
+    std::vector<ObserverRef, pmr::polymorphic_allocator<ObserverRef>>
+        observers;
+    std::vector<HookPtr, pmr::polymorphic_allocator<HookPtr>> hooks;
+    std::atomic<uint64_t> dropped_observers{0};
+#ifdef STATE_MACHINE_LATENCY_HISTOGRAMS
+    std::shared_ptr<ControllerLatency> latency;
+#endif
 
   public:
     explicit ObservableController(
-        std::shared_ptr<IStateMachine<StateType, EventType>> sm)
-        : state_machine(sm) {}
+        std::shared_ptr<IStateMachine<StateType, EventType>> sm,
+        pmr::memory_resource *resource = pmr::get_default_resource())
+        : state_machine(sm), observers(resource), hooks(resource) {
+#ifdef STATE_MACHINE_LATENCY_HISTOGRAMS
+        latency = allocate_shared_in<ControllerLatency>(resource, resource);
+#endif
+    }
 
     virtual ~ObservableController() = default;
 
+    // Hooks run in registration order for every handled event
+    void add_transition_hook(
+        std::shared_ptr<ITransitionHook<StateType, EventType>> hook) {
+        hooks.push_back(hook);
+    }
+
+#ifdef STATE_MACHINE_LATENCY_HISTOGRAMS
+    ControllerLatencySnapshot latency_snapshot() const {
+        return latency->snapshot();
+    }
+
+    // Lets several controllers record into one set of histograms
+    void share_latency(std::shared_ptr<ControllerLatency> shared) {
+        latency = shared;
+    }
+#endif
+
     // ISubject implementation
     void add_observer(
         std::shared_ptr<IObserver<StateType, EventType>> observer) override {
@@ -42,17 +79,27 @@ class ObservableController : public ISubject<StateType, EventType> {
             observers.end());
     }
 
+    // Observers pruned after their owner released them
+    uint64_t get_dropped_observer_count() const {
+        return dropped_observers.load(std::memory_order_relaxed);
+    }
+
   protected:
     void handle_event(EventType event) {
-        StateType current_state = state_machine->get_current_state();
-        StateType new_state = current_state;
+        StateType current_state;
+        StateType new_state;
+
+        {
+            STATE_MACHINE_LATENCY_SCOPE(latency->lookup);
+            state_machine->apply_event(event, current_state, new_state);
+        }
 
-        bool state_changed = state_machine->process_event(event);
-        if (state_changed) {
-            new_state = state_machine->get_current_state();
+        for (const auto &hook : hooks) {
+            hook->on_transition(current_state, event, new_state);
         }
 
         // Always notify observers (even if state didn't change)
+        STATE_MACHINE_LATENCY_SCOPE(latency->dispatch);
         notify_observers(current_state, event, new_state);
     }
 
@@ -74,12 +121,16 @@ class ObservableController : public ISubject<StateType, EventType> {
 
   private:
     void cleanup_expired_observers() {
-        observers.erase(
-            std::remove_if(
-                observers.begin(), observers.end(),
-                [](const std::weak_ptr<IObserver<StateType, EventType>>
-                       &weak_obs) { return weak_obs.expired(); }),
-            observers.end());
+        auto live_end = std::remove_if(
+            observers.begin(), observers.end(),
+            [](const std::weak_ptr<IObserver<StateType, EventType>>
+                   &weak_obs) { return weak_obs.expired(); });
+        if (live_end != observers.end()) {
+            dropped_observers.fetch_add(
+                static_cast<uint64_t>(observers.end() - live_end),
+                std::memory_order_relaxed);
+            observers.erase(live_end, observers.end());
+        }
     }
 };
 
@@ -9,9 +9,27 @@ namespace state_machine {
  */
 template <typename StateType, typename EventType> class IStateMachine {
   public:
+    using state_type = StateType;
+    using event_type = EventType;
+
     virtual ~IStateMachine() = default;
     virtual StateType get_current_state() const = 0;
     virtual bool process_event(EventType event) = 0;
+
+    /**
+     * @brief Process an event and report the states it moved between
+     * Concurrent implementations override this so from/to come from the
+     * same atomic step; the default reads the state around process_event.
+     * @return true if the state changed
+     */
+    virtual bool apply_event(EventType event, StateType &from_state,
+                             StateType &to_state) {
+        from_state = get_current_state();
+        bool changed = process_event(event);
+        to_state = changed ? get_current_state() : from_state;
+        return changed;
+    }
+
     virtual StateType get_next_state(StateType current_state,
                                      EventType event) const = 0;
     virtual void add_transition(
@@ -1,6 +1,15 @@
 #pragma once
 
 namespace state_machine {
+/**
+ * @brief Result of a transition's guard when its target was resolved
+ */
+enum class GuardOutcome {
+    NONE,   // unguarded transition
+    PASSED, // guard held, conditional target taken
+    FAILED  // guard did not hold, normal target taken
+};
+
 /**
  * @brief Interface for state transitions
  */
@@ -12,5 +21,11 @@ template <typename StateType, typename EventType> class IStateTransition {
     virtual StateType get_to_state() const = 0;
     virtual bool can_transition(StateType current_state,
                                 EventType event) const = 0;
+
+    // Like get_to_state(), also reporting how a guard (if any) decided
+    virtual StateType resolve_to_state(GuardOutcome &outcome) const {
+        outcome = GuardOutcome::NONE;
+        return get_to_state();
+    }
 };
 } // namespace state_machine
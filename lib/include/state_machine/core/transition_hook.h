@@ -0,0 +1,17 @@
+#pragma once
+
+namespace state_machine {
+/**
+ * @brief Synchronous callback run by a controller for every handled event
+ *
+ * Unlike observers, hooks are held strongly, work with both BaseController
+ * and ObservableController, and run on the thread calling handle_event
+ * right after the lookup. Keep them cheap (counters, ring buffers).
+ */
+template <typename StateType, typename EventType> class ITransitionHook {
+  public:
+    virtual ~ITransitionHook() = default;
+    virtual void on_transition(StateType from_state, EventType event,
+                               StateType to_state) = 0;
+};
+} // namespace state_machine
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace state_machine {
+
+/**
+ * @brief What a mailbox does with an event whose key is already pending
+ */
+enum class CoalescePolicy : uint8_t {
+    NONE,        // queue every event
+    ONE_PENDING, // drop the new event, the pending one stands for it
+    LATEST_WINS  // keep the queue position, dispatch the newest value
+};
+
+/**
+ * @brief Per-controller coalescing rules keyed by event type
+ *
+ * Each event maps to a key below MAX_KEYS (by default its enum value);
+ * a mailbox tracks whether each key has an entry pending, so duplicates are
+ * dropped or merged on the producer side before they cost a dispatch. An
+ * event taken off the queue clears its key before it is handled, so a
+ * repeat arriving during handling is queued again.
+ */
+template <typename EventType> class CoalescingRules {
+  public:
+    static constexpr std::size_t MAX_KEYS = 64;
+    using KeyFunction = std::function<std::size_t(const EventType &)>;
+
+  private:
+    KeyFunction key_of;
+    CoalescePolicy policies[MAX_KEYS] = {};
+    uint64_t coalesced_keys = 0;
+    uint64_t latest_wins_keys = 0;
+
+  public:
+    CoalescingRules()
+        : key_of([](const EventType &event) {
+              return static_cast<std::size_t>(event);
+          }) {}
+
+    explicit CoalescingRules(KeyFunction key_function)
+        : key_of(std::move(key_function)) {}
+
+    CoalescingRules &set(const EventType &event, CoalescePolicy policy) {
+        std::size_t key = key_of(event);
+        if (key >= MAX_KEYS) {
+            throw std::runtime_error("Coalescing key " + std::to_string(key) +
+                                     " out of range");
+        }
+        uint64_t bit = uint64_t(1) << key;
+        policies[key] = policy;
+        coalesced_keys = policy == CoalescePolicy::NONE
+                             ? coalesced_keys & ~bit
+                             : coalesced_keys | bit;
+        latest_wins_keys = policy == CoalescePolicy::LATEST_WINS
+                               ? latest_wins_keys | bit
+                               : latest_wins_keys & ~bit;
+        return *this;
+    }
+
+    /**
+     * @brief Policy for an event
+     * @param key Set to the event's key unless the policy is NONE
+     */
+    CoalescePolicy policy_for(const EventType &event, std::size_t &key) const {
+        if (coalesced_keys == 0)
+            return CoalescePolicy::NONE;
+        key = key_of(event);
+        return key < MAX_KEYS ? policies[key] : CoalescePolicy::NONE;
+    }
+
+    std::size_t key(const EventType &event) const { return key_of(event); }
+
+    bool has_latest_wins() const { return latest_wins_keys != 0; }
+};
+
+template <typename EventType>
+constexpr std::size_t CoalescingRules<EventType>::MAX_KEYS;
+
+} // namespace state_machine
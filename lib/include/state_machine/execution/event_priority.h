@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace state_machine {
+
+/**
+ * @brief Mailbox lane of an event; higher lanes are drained first
+ */
+enum class EventPriority : uint8_t { NORMAL = 0, HIGH = 1, EMERGENCY = 2 };
+
+constexpr std::size_t PRIORITY_LANES = 3;
+
+inline const char *priority_to_string(EventPriority priority) {
+    switch (priority) {
+    case EventPriority::NORMAL:
+        return "normal";
+    case EventPriority::HIGH:
+        return "high";
+    case EventPriority::EMERGENCY:
+        return "emergency";
+    }
+    return "unknown";
+}
+
+} // namespace state_machine
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <istream>
+#include <thread>
+
+namespace state_machine {
+
+/**
+ * @brief Producer of events started and stopped together with an executor
+ *
+ * A source turns some outside input into Executor::post calls; how it
+ * waits for that input (its own thread, a reactor) is up to the source.
+ */
+class IEventSource {
+  public:
+    virtual ~IEventSource() = default;
+    virtual void start() = 0;
+    virtual void stop() = 0;
+};
+
+/**
+ * @brief Reads whitespace-separated characters from a stream on its own
+ *        thread and hands each to a callback
+ *
+ * The callback returns false to stop reading. A blocking read cannot be
+ * interrupted, so stop() waits for the next character or end of stream
+ * unless the callback already ended the loop.
+ */
+class StreamInputSource : public IEventSource {
+  public:
+    using InputHandler = std::function<bool(char)>;
+
+  private:
+    std::istream &input;
+    InputHandler handler;
+    std::atomic<bool> running{false};
+    std::thread input_thread;
+
+  public:
+    StreamInputSource(std::istream &stream, InputHandler input_handler);
+    ~StreamInputSource() override;
+
+    void start() override;
+    void stop() override;
+
+  private:
+    void input_loop();
+};
+
+} // namespace state_machine
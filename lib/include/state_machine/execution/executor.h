@@ -0,0 +1,425 @@
+#pragma once
+#include "event_source.h"
+#include "executor_stats.h"
+#include "mailbox.h"
+#include "timer_queue.h"
+#include "work_stealing_scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Sizing of an Executor's worker pool
+ */
+struct ExecutorOptions {
+    std::size_t worker_count = 1;
+    // Events one controller may handle before its worker moves on
+    std::size_t batch_size = 64;
+    // CPU for each worker, reused round-robin; empty disables pinning
+    std::vector<int> worker_cpus;
+    // Higher-lane events handled before a waiting lower-lane one; 0 lets
+    // higher lanes starve lower ones
+    std::size_t starvation_limit = 16;
+    // Default bound of every mailbox; unbounded unless set
+    MailboxLimits mailbox;
+};
+
+/**
+ * @brief Events gathered for one Executor::post_batch call
+ */
+template <typename EventType> class EventBatch {
+  public:
+    struct Entry {
+        std::size_t instance;
+        EventType event;
+        bool has_priority; // otherwise the executor's classifier decides
+        EventPriority priority;
+    };
+
+  private:
+    std::vector<Entry> entries;
+
+  public:
+    void add(std::size_t instance, EventType event) {
+        entries.push_back({instance, event, false, EventPriority::NORMAL});
+    }
+
+    void add(std::size_t instance, EventType event, EventPriority priority) {
+        entries.push_back({instance, event, true, priority});
+    }
+
+    void clear() { entries.clear(); }
+    bool empty() const { return entries.empty(); }
+    std::size_t size() const { return entries.size(); }
+    typename std::vector<Entry>::const_iterator begin() const {
+        return entries.begin();
+    }
+    typename std::vector<Entry>::const_iterator end() const {
+        return entries.end();
+    }
+};
+
+/**
+ * @brief Runs many controllers on a small fixed pool of worker threads
+ *
+ * Every controller registers a handler and gets a mailbox. Posting to an
+ * idle mailbox makes the controller runnable on a WorkStealingScheduler;
+ * a worker then drains up to batch_size events and requeues the
+ * controller if more arrived, and idle workers steal runnable controllers
+ * from busy ones. Each mailbox has one lane per EventPriority: emergency
+ * events overtake queued routine ones, and a controller receiving one
+ * while idle or running is scheduled ahead of other runnable controllers.
+ * One already waiting in a worker's queue keeps its place. Mailboxes may be
+ * bounded, with an OverflowPolicy deciding what a full one does; use
+ * try_post where a producer must not block. A controller is
+ * never run by two workers at once, so
+ * handlers and the state machines behind them need no locking. One timer
+ * thread serves the timeouts of all controllers and event sources feed
+ * the mailboxes.
+ */
+template <typename EventType> class Executor {
+  public:
+    using InstanceId = std::size_t;
+    using TimerId = TimerQueue::TimerId;
+    using Handler = std::function<void(EventType)>;
+    using PriorityClassifier = std::function<EventPriority(EventType)>;
+
+  private:
+    struct Instance {
+        Handler handler;
+        Mailbox<EventType> mailbox;
+
+        Instance(Handler event_handler, std::size_t starvation_limit,
+                 std::shared_ptr<const CoalescingRules<EventType>> rules,
+                 MailboxLimits limits)
+            : handler(std::move(event_handler)),
+              mailbox(starvation_limit, std::move(rules), limits) {}
+    };
+
+    // Instances live in fixed chunks so that lookups by id need no lock
+    // while add_instance grows the table
+    static constexpr std::size_t CHUNK_BITS = 10;
+    static constexpr std::size_t CHUNK_SIZE = std::size_t(1) << CHUNK_BITS;
+    static constexpr std::size_t MAX_CHUNKS = 1024;
+
+  public:
+    static constexpr std::size_t MAX_INSTANCES = CHUNK_SIZE * MAX_CHUNKS;
+
+  private:
+    ExecutorOptions options;
+    std::vector<std::unique_ptr<std::unique_ptr<Instance>[]>> chunks;
+    std::atomic<std::size_t> instance_count{0};
+    std::mutex add_mutex;
+    PriorityClassifier classify;
+
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stop_requested = false;
+
+    std::atomic<bool> running{false};
+    WorkStealingScheduler scheduler;
+    TimerQueue timers;
+    std::vector<std::shared_ptr<IEventSource>> sources;
+    std::shared_ptr<ExecutorStats> stats = std::make_shared<ExecutorStats>();
+
+  public:
+    explicit Executor(ExecutorOptions executor_options = ExecutorOptions())
+        : options(executor_options), chunks(MAX_CHUNKS),
+          scheduler(options.worker_count,
+                    [this](std::size_t id) { run_instance(id); },
+                    options.worker_cpus) {
+        if (options.batch_size == 0) {
+            options.batch_size = 1;
+        }
+    }
+
+    ~Executor() { stop(); }
+
+    Executor(const Executor &) = delete;
+    Executor &operator=(const Executor &) = delete;
+
+    /**
+     * @brief Register a controller; allowed before and after start()
+     * @param rules Duplicate events to merge in this controller's mailbox
+     * @return Id for post and schedule_event
+     */
+    InstanceId
+    add_instance(Handler handler,
+                 std::shared_ptr<const CoalescingRules<EventType>> rules =
+                     nullptr) {
+        return add_instance(std::move(handler), std::move(rules),
+                            options.mailbox);
+    }
+
+    // Same, with a mailbox bound other than ExecutorOptions::mailbox
+    InstanceId
+    add_instance(Handler handler,
+                 std::shared_ptr<const CoalescingRules<EventType>> rules,
+                 MailboxLimits limits) {
+        std::lock_guard<std::mutex> lock(add_mutex);
+        std::size_t id = instance_count.load(std::memory_order_relaxed);
+        if (id >= MAX_INSTANCES) {
+            throw std::runtime_error("Executor instance table is full");
+        }
+
+        auto &chunk = chunks[id >> CHUNK_BITS];
+        if (!chunk) {
+            chunk.reset(new std::unique_ptr<Instance>[CHUNK_SIZE]);
+        }
+        chunk[id & (CHUNK_SIZE - 1)].reset(
+            new Instance(std::move(handler), options.starvation_limit,
+                         std::move(rules), limits));
+        instance_count.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    // Event sources are started and stopped with the executor
+    void add_source(std::shared_ptr<IEventSource> source) {
+        sources.push_back(source);
+        if (running) {
+            source->start();
+        }
+    }
+
+    // Lane for events posted without an explicit priority; setup only
+    void set_priority_classifier(PriorityClassifier classifier) {
+        classify = std::move(classifier);
+    }
+
+    /**
+     * @brief Thread-safe; may be called from handlers, timers and sources
+     *
+     * Blocks while a BLOCK-policy lane is full, so a handler must not post
+     * to its own bounded mailbox this way.
+     */
+    void post(InstanceId id, EventType event) {
+        deliver(id, event, default_priority(event), true);
+    }
+
+    void post(InstanceId id, EventType event, EventPriority priority) {
+        deliver(id, event, priority, true);
+    }
+
+    /**
+     * @brief Never blocks
+     * @return false if the event was dropped because the mailbox is full;
+     *         an event merged into a pending one counts as accepted
+     */
+    bool try_post(InstanceId id, EventType event) {
+        return deliver(id, event, default_priority(event), false);
+    }
+
+    bool try_post(InstanceId id, EventType event, EventPriority priority) {
+        return deliver(id, event, priority, false);
+    }
+
+    /**
+     * @brief Post events in order, scheduling the controllers they wake
+     *        only once the whole batch is queued
+     *
+     * Each controller then handles its share in one run rather than racing
+     * the producer. Blocks like post(); a controller whose BLOCK-policy
+     * mailbox is bounded is scheduled at once so that it can make room.
+     */
+    void post_batch(const EventBatch<EventType> &batch) {
+        std::vector<std::pair<InstanceId, bool>> runnable;
+        try {
+            for (const auto &entry : batch) {
+                deliver(entry.instance, entry.event,
+                        entry.has_priority ? entry.priority
+                                           : default_priority(entry.event),
+                        true, &runnable);
+            }
+        } catch (...) {
+            // Never leave a woken controller unscheduled
+            for (const auto &instance : runnable) {
+                scheduler.schedule(instance.first, instance.second);
+            }
+            throw;
+        }
+        for (const auto &instance : runnable) {
+            scheduler.schedule(instance.first, instance.second);
+        }
+    }
+
+    // Post event to id once delay has elapsed
+    TimerId schedule_event(InstanceId id,
+                           std::chrono::steady_clock::duration delay,
+                           EventType event) {
+        get_instance(id); // reject unknown ids now rather than on expiry
+        stats->timers_pending.fetch_add(1, std::memory_order_relaxed);
+        return timers.schedule(delay, [this, id, event]() {
+            stats->timers_pending.fetch_sub(1, std::memory_order_relaxed);
+            post(id, event);
+        });
+    }
+
+    // @return false if the timer already fired or was cancelled
+    bool cancel_timer(TimerId timer) {
+        if (!timers.cancel(timer))
+            return false;
+        stats->timers_pending.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void start() {
+        if (running.exchange(true))
+            return;
+        timers.start();
+        scheduler.start();
+        for (const auto &source : sources) {
+            source->start();
+        }
+    }
+
+    // Non-blocking; safe to call from handlers and sources. Producers
+    // blocked on a full mailbox are released
+    void request_stop() {
+        {
+            std::lock_guard<std::mutex> lock(stop_mutex);
+            stop_requested = true;
+        }
+        scheduler.request_stop();
+        std::size_t count = get_instance_count();
+        for (std::size_t id = 0; id < count; ++id) {
+            get_instance(id).mailbox.close();
+        }
+        stop_cv.notify_all();
+    }
+
+    // Blocks until request_stop, then shuts down like stop()
+    void wait_for_completion() {
+        {
+            std::unique_lock<std::mutex> lock(stop_mutex);
+            stop_cv.wait(lock, [this] { return stop_requested; });
+        }
+        stop();
+    }
+
+    // Joins all threads; events still in mailboxes are discarded.
+    // Must not be called from a handler (use request_stop)
+    void stop() {
+        request_stop();
+        scheduler.stop();
+        for (const auto &source : sources) {
+            source->stop();
+        }
+        timers.stop();
+        running = false;
+    }
+
+    std::shared_ptr<const ExecutorStats> get_stats() const { return stats; }
+
+    std::size_t get_instance_count() const {
+        return instance_count.load(std::memory_order_acquire);
+    }
+    std::size_t get_worker_count() const {
+        return scheduler.get_worker_count();
+    }
+    uint64_t get_steal_count() const { return scheduler.get_steal_count(); }
+    std::size_t get_pending_events(InstanceId id) {
+        return get_instance(id).mailbox.size();
+    }
+
+  private:
+    EventPriority default_priority(const EventType &event) const {
+        return classify ? classify(event) : EventPriority::NORMAL;
+    }
+
+    // Controllers woken go to deferred, if given, instead of the scheduler
+    bool deliver(InstanceId id, EventType event, EventPriority priority,
+                 bool may_block,
+                 std::vector<std::pair<InstanceId, bool>> *deferred = nullptr) {
+        Instance &target = get_instance(id);
+        // Counted first so that the handler can never see depth below zero
+        stats->queue_depth.fetch_add(1, std::memory_order_relaxed);
+        uint64_t evicted = 0;
+        MailboxPush pushed =
+            target.mailbox.push(event, priority, may_block, &evicted);
+        if (evicted > 0) {
+            stats->queue_depth.fetch_sub(static_cast<int64_t>(evicted),
+                                         std::memory_order_relaxed);
+            stats->evicted.fetch_add(evicted, std::memory_order_relaxed);
+        }
+
+        switch (pushed) {
+        case MailboxPush::COALESCED:
+            stats->queue_depth.fetch_sub(1, std::memory_order_relaxed);
+            stats->coalesced.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        case MailboxPush::REJECTED:
+            stats->queue_depth.fetch_sub(1, std::memory_order_relaxed);
+            stats->rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        case MailboxPush::SCHEDULE: {
+            bool urgent = priority == EventPriority::EMERGENCY;
+            const MailboxLimits &limits = target.mailbox.get_limits();
+            if (deferred && !(limits.capacity > 0 &&
+                              limits.overflow == OverflowPolicy::BLOCK)) {
+                deferred->emplace_back(id, urgent);
+            } else {
+                scheduler.schedule(id, urgent);
+            }
+            break;
+        }
+        case MailboxPush::QUEUED:
+            break;
+        }
+        stats->enqueued.fetch_add(1, std::memory_order_relaxed);
+        stats->record_mailbox_size(target.mailbox.size());
+        return true;
+    }
+
+    Instance &get_instance(InstanceId id) {
+        if (id >= instance_count.load(std::memory_order_acquire)) {
+            throw std::runtime_error("Unknown executor instance " +
+                                     std::to_string(id));
+        }
+        return *chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)];
+    }
+
+    void run_instance(InstanceId id) {
+        Instance &instance = get_instance(id);
+        QueuedEvent<EventType> queued;
+        for (std::size_t handled = 0; handled < options.batch_size; ++handled) {
+            if (!instance.mailbox.pop(queued))
+                break;
+
+            stats->queue_depth.fetch_sub(1, std::memory_order_relaxed);
+            stats->record_lag(
+                queued.priority,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - queued.enqueued_at)
+                    .count());
+            instance.handler(queued.event);
+            stats->handled.fetch_add(1, std::memory_order_relaxed);
+        }
+        // Requeue at the back so busy controllers cannot starve idle ones,
+        // unless an emergency arrived while the controller was running
+        bool urgent = false;
+        if (instance.mailbox.finish_run(urgent)) {
+            scheduler.schedule(id, urgent);
+        }
+    }
+};
+
+template <typename EventType>
+constexpr std::size_t Executor<EventType>::CHUNK_BITS;
+template <typename EventType>
+constexpr std::size_t Executor<EventType>::CHUNK_SIZE;
+template <typename EventType>
+constexpr std::size_t Executor<EventType>::MAX_CHUNKS;
+template <typename EventType>
+constexpr std::size_t Executor<EventType>::MAX_INSTANCES;
+
+} // namespace state_machine
@@ -0,0 +1,59 @@
+#pragma once
+#include "../metrics/metrics_registry.h"
+#include "event_priority.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Executor runtime counters, updated with relaxed atomics and
+ *        readable at any time
+ */
+struct ExecutorStats {
+    std::atomic<uint64_t> enqueued{0};
+    std::atomic<uint64_t> handled{0};
+    std::atomic<uint64_t> coalesced{0}; // merged into a pending event
+    std::atomic<uint64_t> rejected{0};  // dropped, the mailbox was full
+    std::atomic<uint64_t> evicted{0};   // queued, then dropped as oldest
+    std::atomic<int64_t> mailbox_high_water{0}; // largest mailbox seen
+    std::atomic<int64_t> queue_depth{0};
+    std::atomic<int64_t> last_lag_ns{0}; // enqueue to dequeue
+    std::atomic<int64_t> max_lag_ns{0};
+    std::atomic<int64_t> timers_pending{0};
+    std::atomic<uint64_t> handled_by_lane[PRIORITY_LANES] = {};
+    std::atomic<int64_t> max_lag_ns_by_lane[PRIORITY_LANES] = {};
+
+    void record_lag(EventPriority priority, int64_t lag_ns) {
+        std::size_t lane = static_cast<std::size_t>(priority);
+        handled_by_lane[lane].fetch_add(1, std::memory_order_relaxed);
+        last_lag_ns.store(lag_ns, std::memory_order_relaxed);
+        raise_maximum(max_lag_ns, lag_ns);
+        raise_maximum(max_lag_ns_by_lane[lane], lag_ns);
+    }
+
+    void record_mailbox_size(std::size_t size) {
+        raise_maximum(mailbox_high_water, static_cast<int64_t>(size));
+    }
+
+  private:
+    static void raise_maximum(std::atomic<int64_t> &maximum, int64_t value) {
+        int64_t seen = maximum.load(std::memory_order_relaxed);
+        while (value > seen && !maximum.compare_exchange_weak(
+                                   seen, value, std::memory_order_relaxed)) {
+        }
+    }
+};
+
+/**
+ * @brief Expose queue depth, lag and timer occupancy through a registry
+ * @return Sample ids, for MetricsRegistry::remove
+ */
+std::vector<std::size_t>
+register_executor_metrics(MetricsRegistry &registry,
+                          std::shared_ptr<const ExecutorStats> stats,
+                          const MetricLabels &labels);
+
+} // namespace state_machine
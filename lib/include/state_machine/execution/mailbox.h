@@ -0,0 +1,449 @@
+#pragma once
+#include "../concurrency/bounded_queue.h"
+#include "../concurrency/mpsc_queue.h"
+#include "coalescing_rules.h"
+#include "event_priority.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace state_machine {
+
+/**
+ * @brief Event waiting in a mailbox, stamped for queueing-lag metrics
+ */
+template <typename EventType> struct QueuedEvent {
+    EventType event;
+    std::chrono::steady_clock::time_point enqueued_at;
+    EventPriority priority;
+};
+
+/**
+ * @brief Outcome of Mailbox::push
+ */
+enum class MailboxPush : uint8_t {
+    QUEUED,    // added behind events the controller has yet to handle
+    SCHEDULE,  // added and the controller was idle: the caller schedules it
+    COALESCED, // merged into an already pending event of the same key
+    REJECTED   // dropped because the lane is full
+};
+
+/**
+ * @brief What a full mailbox lane does with a new event
+ */
+enum class OverflowPolicy : uint8_t {
+    BLOCK,       // the producer waits for space (non-blocking pushes reject)
+    DROP_NEWEST, // the new event is rejected
+    DROP_OLDEST, // the oldest event in the lane is evicted
+    COALESCE     // absorbed if its key is pending in its lane, else rejected
+};
+
+/**
+ * @brief Mailbox bound; capacity 0 means unbounded
+ *
+ * The capacity applies to each priority lane, so a flood of routine
+ * events never evicts or blocks an emergency.
+ */
+struct MailboxLimits {
+    std::size_t capacity = 0;
+    OverflowPolicy overflow = OverflowPolicy::BLOCK;
+};
+
+/**
+ * @brief Per-controller set of lock-free FIFO lanes, one per priority
+ *
+ * Any thread may push; only the worker currently running the controller
+ * pops. pop() serves the highest non-empty lane, except that a waiting
+ * lower lane passed over starvation_limit times is served next, so an
+ * emergency waits behind at most one lower-lane event and a routine event
+ * is delayed by at most starvation_limit events per lane above it.
+ *
+ * Unbounded lanes are linked lists. Bounded lanes are preallocated rings,
+ * which also lets a producer evict the oldest event itself; only producers
+ * waiting under the BLOCK policy take a lock.
+ *
+ * Optional CoalescingRules merge an event into a pending one of the same
+ * key in the same lane, so a duplicate posted at a higher priority is
+ * queued in its own lane rather than served at the lower one. Only
+ * LATEST_WINS keys take a lock, to swap in the newest value. A
+ * key is claimed by the producer pushing its entry; a duplicate arriving
+ * meanwhile waits for that push to succeed or fail before it reports
+ * COALESCED, so it is never merged into an entry that was rejected. A
+ * producer never blocks while holding a claim.
+ *
+ * A mailbox also tracks whether its controller is scheduled (queued on a
+ * worker or being drained). push() reports the idle-to-scheduled edge and
+ * finish_run() the reverse, so a controller is enqueued at most once and
+ * only one worker drains it.
+ */
+template <typename EventType> class Mailbox {
+  private:
+    using Entry = QueuedEvent<EventType>;
+    static constexpr std::size_t MAX_KEYS = CoalescingRules<EventType>::MAX_KEYS;
+    // Keys coalesce within a lane, so a slot is a (lane, key) pair
+    static constexpr std::size_t KEY_SLOTS = MAX_KEYS * PRIORITY_LANES;
+
+    std::unique_ptr<MpscQueue<Entry>> unbounded[PRIORITY_LANES];
+    std::unique_ptr<BoundedQueue<Entry>> bounded[PRIORITY_LANES];
+    MailboxLimits limits;
+    std::atomic<int64_t> pending{0};
+    std::atomic<bool> scheduled{false};
+
+    // Per-key coalescing state
+    // CLAIMED and TAKEN are left only by the claiming producer
+    enum KeyState : uint8_t {
+        KEY_IDLE,
+        KEY_CLAIMED, // a producer is pushing the key's entry
+        KEY_PENDING, // the entry is queued
+        KEY_TAKEN    // the entry left before its producer marked it pending
+    };
+
+    std::shared_ptr<const CoalescingRules<EventType>> rules;
+    std::unique_ptr<std::atomic<uint8_t>[]> key_states;
+    std::mutex latest_mutex;
+    std::unique_ptr<EventType[]> latest; // per slot, LATEST_WINS only
+    // Queued entries per slot, COALESCE overflow only
+    std::unique_ptr<std::atomic<uint32_t>[]> key_counts;
+
+    // Producers waiting for space under the BLOCK policy
+    std::atomic<int> waiters{0};
+    std::atomic<bool> closed{false};
+    std::mutex space_mutex;
+    std::condition_variable space_cv;
+
+    // Consumer side
+    std::size_t starvation_limit;
+    std::size_t passed_over[PRIORITY_LANES] = {};
+
+  public:
+    explicit Mailbox(
+        std::size_t lower_lane_limit = 16,
+        std::shared_ptr<const CoalescingRules<EventType>> coalescing = nullptr,
+        MailboxLimits mailbox_limits = MailboxLimits())
+        : limits(mailbox_limits), rules(std::move(coalescing)),
+          starvation_limit(lower_lane_limit) {
+        for (std::size_t lane = 0; lane < PRIORITY_LANES; ++lane) {
+            if (limits.capacity > 0) {
+                bounded[lane].reset(new BoundedQueue<Entry>(limits.capacity));
+            } else {
+                unbounded[lane].reset(new MpscQueue<Entry>());
+            }
+        }
+        if (rules) {
+            key_states.reset(new std::atomic<uint8_t>[KEY_SLOTS]);
+            for (std::size_t slot = 0; slot < KEY_SLOTS; ++slot) {
+                key_states[slot].store(KEY_IDLE, std::memory_order_relaxed);
+            }
+        }
+        if (rules && rules->has_latest_wins()) {
+            latest.reset(new EventType[KEY_SLOTS]);
+        }
+        if (limits.capacity > 0 &&
+            limits.overflow == OverflowPolicy::COALESCE) {
+            if (!rules) {
+                throw std::runtime_error(
+                    "COALESCE overflow needs coalescing rules for its keys");
+            }
+            key_counts.reset(new std::atomic<uint32_t>[KEY_SLOTS]);
+            for (std::size_t slot = 0; slot < KEY_SLOTS; ++slot) {
+                key_counts[slot].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @param may_block Wait for space under the BLOCK policy; if false a
+     *        full lane rejects the event instead
+     * @param evicted Incremented per event dropped by DROP_OLDEST
+     */
+    MailboxPush push(EventType event,
+                     EventPriority priority = EventPriority::NORMAL,
+                     bool may_block = true, uint64_t *evicted = nullptr) {
+        std::size_t key = 0;
+        CoalescePolicy policy =
+            rules ? rules->policy_for(event, key) : CoalescePolicy::NONE;
+        bool keyed = policy != CoalescePolicy::NONE;
+
+        std::size_t lane = static_cast<std::size_t>(priority);
+        std::size_t slot = lane * MAX_KEYS + key;
+        Entry entry = {event, std::chrono::steady_clock::now(), priority};
+        while (true) {
+            if (keyed && !claim_key(slot, policy, event))
+                return MailboxPush::COALESCED;
+            if (try_push_lane(lane, entry))
+                break;
+            if (keyed && limits.overflow == OverflowPolicy::BLOCK &&
+                may_block && !closed) {
+                // Wait unclaimed, then start over: a duplicate may have
+                // queued the key meanwhile
+                key_states[slot].store(KEY_IDLE);
+                wait_for_space(lane);
+                continue;
+            }
+            MailboxPush outcome = overflow(lane, entry, may_block, evicted);
+            if (outcome == MailboxPush::QUEUED)
+                break;
+            if (keyed) {
+                key_states[slot].store(KEY_IDLE);
+            }
+            return outcome;
+        }
+
+        if (keyed) {
+            uint8_t claimed = KEY_CLAIMED;
+            if (!key_states[slot].compare_exchange_strong(claimed,
+                                                          KEY_PENDING)) {
+                key_states[slot].store(KEY_IDLE); // already taken
+            }
+        }
+        count_key(lane, event, 1);
+        pending.fetch_add(1);
+        return scheduled.exchange(true) ? MailboxPush::QUEUED
+                                        : MailboxPush::SCHEDULE;
+    }
+
+    // Consumer only
+    bool pop(Entry &out) {
+        // A lower lane that waited long enough goes first, lowest first
+        if (starvation_limit > 0) {
+            for (std::size_t lane = 0; lane + 1 < PRIORITY_LANES; ++lane) {
+                if (passed_over[lane] >= starvation_limit &&
+                    take(lane, out)) {
+                    return true;
+                }
+            }
+        }
+        for (std::size_t lane = PRIORITY_LANES; lane-- > 0;) {
+            if (take(lane, out)) {
+                for (std::size_t lower = 0; lower < lane; ++lower) {
+                    if (!lane_empty(lower)) {
+                        ++passed_over[lower];
+                    }
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief End a drain pass (consumer only)
+     * @param urgent Set if the controller stays scheduled with an
+     *        emergency event waiting, so it should be requeued in front
+     * @return true if events remain and the controller stays scheduled
+     */
+    bool finish_run(bool &urgent) {
+        urgent = false;
+        scheduled.store(false);
+        // Past the store another worker may already own the lanes, so only
+        // the counter is checked. A racing push either sees false and
+        // schedules the controller itself, or its count is visible here
+        if (pending.load() > 0 && !scheduled.exchange(true)) {
+            // Owned again, so the lanes are ours to look at
+            urgent = !lane_empty(
+                static_cast<std::size_t>(EventPriority::EMERGENCY));
+            return true;
+        }
+        return false;
+    }
+
+    // Releases blocked producers (their events are rejected); for shutdown
+    void close() {
+        closed = true;
+        std::lock_guard<std::mutex> lock(space_mutex);
+        space_cv.notify_all();
+    }
+
+    std::size_t size() const {
+        int64_t count = pending.load(std::memory_order_relaxed);
+        return count > 0 ? static_cast<std::size_t>(count) : 0;
+    }
+
+    const MailboxLimits &get_limits() const { return limits; }
+
+  private:
+    /**
+     * @brief false if an entry of the slot's key is already queued
+     *
+     * Under LATEST_WINS the event becomes the key's value only once it is
+     * certain to be dispatched: merged into a queued entry, or claimed
+     * and about to be queued (no entry of a claimed key is queued, so a
+     * push that then fails delivers nothing). take() marks the key idle
+     * before it reads the value, both under latest_mutex for a merge.
+     */
+    bool claim_key(std::size_t slot, CoalescePolicy policy,
+                   const EventType &event) {
+        bool latest_wins = policy == CoalescePolicy::LATEST_WINS;
+        while (true) {
+            uint8_t state = key_states[slot].load();
+            if (state == KEY_PENDING) {
+                if (!latest_wins)
+                    return false;
+                std::lock_guard<std::mutex> lock(latest_mutex);
+                if (key_states[slot].load() == KEY_PENDING) {
+                    latest[slot] = event;
+                    return false;
+                }
+                continue;
+            }
+            if (state == KEY_IDLE &&
+                key_states[slot].compare_exchange_weak(state, KEY_CLAIMED)) {
+                if (latest_wins) {
+                    std::lock_guard<std::mutex> lock(latest_mutex);
+                    latest[slot] = event;
+                }
+                return true;
+            }
+            if (state == KEY_CLAIMED || state == KEY_TAKEN) {
+                // Held only across a non-blocking push
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // BLOCK policy: sleeps until the lane may have room or the mailbox
+    // closes. waiters is raised before the check and release() reads it
+    // after freeing a cell, so a wakeup cannot be lost
+    void wait_for_space(std::size_t lane) {
+        std::unique_lock<std::mutex> lock(space_mutex);
+        waiters.fetch_add(1);
+        while (bounded[lane]->full() && !closed) {
+            space_cv.wait(lock);
+        }
+        waiters.fetch_sub(1);
+    }
+
+    bool try_push_lane(std::size_t lane, const Entry &entry) {
+        if (bounded[lane])
+            return bounded[lane]->try_push(entry);
+        unbounded[lane]->push(entry);
+        return true;
+    }
+
+    bool lane_empty(std::size_t lane) const {
+        return bounded[lane] ? bounded[lane]->empty()
+                             : unbounded[lane]->empty();
+    }
+
+    // Only reached for bounded lanes
+    MailboxPush overflow(std::size_t lane, const Entry &entry, bool may_block,
+                         uint64_t *evicted) {
+        switch (limits.overflow) {
+        case OverflowPolicy::DROP_NEWEST:
+            return MailboxPush::REJECTED;
+
+        case OverflowPolicy::COALESCE: {
+            std::size_t key = rules->key(entry.event);
+            return key < MAX_KEYS &&
+                           key_counts[lane * MAX_KEYS + key].load() > 0
+                       ? MailboxPush::COALESCED
+                       : MailboxPush::REJECTED;
+        }
+
+        case OverflowPolicy::DROP_OLDEST: {
+            Entry oldest;
+            do {
+                if (bounded[lane]->try_pop(oldest)) {
+                    release(lane, oldest.event, true);
+                    if (evicted) {
+                        ++*evicted;
+                    }
+                }
+            } while (!bounded[lane]->try_push(entry));
+            return MailboxPush::QUEUED;
+        }
+
+        case OverflowPolicy::BLOCK:
+            break;
+        }
+
+        if (!may_block || closed)
+            return MailboxPush::REJECTED;
+
+        // waiters is raised before the retry and release() reads it after
+        // freeing a cell, so a wakeup cannot be lost
+        std::unique_lock<std::mutex> lock(space_mutex);
+        waiters.fetch_add(1);
+        bool pushed;
+        while (!(pushed = bounded[lane]->try_push(entry)) && !closed) {
+            space_cv.wait(lock);
+        }
+        waiters.fetch_sub(1);
+        return pushed ? MailboxPush::QUEUED : MailboxPush::REJECTED;
+    }
+
+    bool take(std::size_t lane, Entry &out) {
+        bool taken = bounded[lane] ? bounded[lane]->try_pop(out)
+                                   : unbounded[lane]->pop(out);
+        if (!taken)
+            return false;
+        passed_over[lane] = 0;
+
+        std::size_t key = 0;
+        if (rules && rules->policy_for(out.event, key) ==
+                         CoalescePolicy::LATEST_WINS) {
+            // Cleared and read under one lock: a later push either merged
+            // its value in already or claims the key and queues afresh
+            std::size_t slot = lane * MAX_KEYS + key;
+            {
+                std::lock_guard<std::mutex> lock(latest_mutex);
+                retire_key(slot);
+                out.event = latest[slot];
+            }
+            release(lane, out.event, false);
+            return true;
+        }
+        release(lane, out.event, true);
+        return true;
+    }
+
+    // Bookkeeping for an entry leaving a lane, taken or evicted
+    void release(std::size_t lane, const EventType &event, bool clear_key) {
+        std::size_t key = 0;
+        if (clear_key && rules &&
+            rules->policy_for(event, key) != CoalescePolicy::NONE) {
+            retire_key(lane * MAX_KEYS + key);
+        }
+        count_key(lane, event, -1);
+        pending.fetch_sub(1);
+        if (waiters.load() > 0) {
+            std::lock_guard<std::mutex> lock(space_mutex);
+            space_cv.notify_all();
+        }
+    }
+
+    // An entry of the slot left its lane. Its producer may not have marked
+    // it pending yet; a plain reset would then let that producer's late
+    // mark land on a newer claim and strand the slot pending
+    void retire_key(std::size_t slot) {
+        uint8_t state = key_states[slot].load();
+        while (state == KEY_PENDING || state == KEY_CLAIMED) {
+            uint8_t next = state == KEY_PENDING ? KEY_IDLE : KEY_TAKEN;
+            if (key_states[slot].compare_exchange_weak(state, next))
+                return;
+        }
+    }
+
+    void count_key(std::size_t lane, const EventType &event, int delta) {
+        if (!key_counts)
+            return;
+        std::size_t key = rules->key(event);
+        if (key < MAX_KEYS) {
+            key_counts[lane * MAX_KEYS + key].fetch_add(
+                static_cast<uint32_t>(delta));
+        }
+    }
+};
+
+template <typename EventType>
+constexpr std::size_t Mailbox<EventType>::MAX_KEYS;
+template <typename EventType>
+constexpr std::size_t Mailbox<EventType>::KEY_SLOTS;
+
+} // namespace state_machine
@@ -0,0 +1,145 @@
+#pragma once
+#include "event_source.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Single-threaded epoll loop multiplexing file descriptors
+ *
+ * Sources are watched descriptors (pipes, Unix sockets, eventfds) and
+ * timerfds the reactor creates itself. One wakeup runs the handler of
+ * every ready source, then the wakeup handlers, which is where per-wakeup
+ * batches are flushed. Handlers run on the reactor thread and must not
+ * block; watching is level-triggered, so a handler that leaves input
+ * unread is called again on the next wakeup. An exception thrown by a
+ * handler is caught and counted, and the loop goes on with the next one.
+ * watch, add_timer and remove may be called from any thread, handlers
+ * included.
+ *
+ * As an IEventSource the reactor runs on its own thread, started and
+ * stopped with an executor; run() drives it on the calling thread instead.
+ */
+class Reactor : public IEventSource {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using SourceId = uint64_t;
+    using WakeupId = uint64_t;
+    using ReadyHandler = std::function<void(int fd, uint32_t events)>;
+    // For handlers that remove their own source
+    using SourceHandler =
+        std::function<void(SourceId id, int fd, uint32_t events)>;
+    using TimerHandler = std::function<void(uint64_t expirations)>;
+    using WakeupHandler = std::function<void()>;
+
+    // Ready descriptors taken per epoll_wait
+    static constexpr int MAX_READY = 64;
+
+  private:
+    struct Source {
+        int fd;
+        bool owned; // timerfds are closed on removal
+        std::shared_ptr<SourceHandler> handler;
+    };
+
+    struct Wakeup {
+        WakeupId id;
+        WakeupHandler handler;
+    };
+
+    int epoll_fd = -1;
+    int stop_fd = -1; // eventfd that interrupts epoll_wait
+    std::mutex mutex;
+    std::unordered_map<SourceId, Source> sources;
+    std::vector<int> closing; // owned fds removed while the loop runs
+    SourceId next_id = 1;
+    // Held while the wakeup handlers run, so removal waits for them
+    std::mutex wakeup_mutex;
+    std::vector<Wakeup> wakeup_handlers;
+    WakeupId next_wakeup_id = 1;
+
+    std::atomic<bool> looping{false};
+    std::atomic<bool> stop_requested{false};
+    std::thread loop_thread;
+    std::atomic<uint64_t> wakeups{0};
+    std::atomic<uint64_t> dispatches{0};
+    std::atomic<uint64_t> handler_errors{0};
+
+  public:
+    // Throws if epoll or the stop eventfd cannot be created
+    Reactor();
+    ~Reactor() override;
+
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    /**
+     * @brief Watch a descriptor the caller keeps open until removal
+     * @param events epoll mask, e.g. EPOLLIN; hangups and errors are
+     *        always reported
+     */
+    SourceId watch(int fd, uint32_t events, ReadyHandler handler);
+
+    // As watch, with the handler told its source id
+    SourceId watch_source(int fd, uint32_t events, SourceHandler handler);
+
+    /**
+     * @brief Arm a timerfd
+     * @param interval Period after the first expiry; zero fires once and
+     *        removes the source
+     */
+    SourceId add_timer(Clock::duration first, Clock::duration interval,
+                       TimerHandler handler);
+
+    // @return false if the source was already removed
+    bool remove(SourceId id);
+
+    // Runs after the ready handlers of each wakeup
+    WakeupId on_wakeup(WakeupHandler handler);
+
+    /**
+     * @brief Unregister a wakeup handler
+     *
+     * Waits for a wakeup pass in progress, so the handler does not run
+     * once this returns. Must not be called from a wakeup handler.
+     * @return false if the handler was already removed
+     */
+    bool remove_wakeup(WakeupId id);
+
+    // Runs the loop on a thread of its own
+    void start() override;
+    // Stops and joins the loop thread; sources stay registered
+    void stop() override;
+
+    // Runs the loop on the calling thread until request_stop
+    void run();
+    // Non-blocking; safe to call from handlers
+    void request_stop();
+
+    std::size_t get_source_count();
+    uint64_t get_wakeup_count() const {
+        return wakeups.load(std::memory_order_relaxed);
+    }
+    // Ready-handler calls over all wakeups
+    uint64_t get_dispatch_count() const {
+        return dispatches.load(std::memory_order_relaxed);
+    }
+    // Ready and wakeup handler calls that threw
+    uint64_t get_handler_error_count() const {
+        return handler_errors.load(std::memory_order_relaxed);
+    }
+
+  private:
+    SourceId add(int fd, uint32_t events, bool owned, SourceHandler handler);
+    void close_removed();
+};
+
+} // namespace state_machine
@@ -0,0 +1,133 @@
+#pragma once
+#include "executor.h"
+#include "reactor.h"
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+/**
+ * @brief Turns reactor sources into typed events for an executor's
+ *        controllers
+ *
+ * Every source maps its raw input (bytes, timer expirations, eventfd
+ * counts) to events addressed to specific controllers by adding them to
+ * a batch. The batch of one reactor wakeup is handed to
+ * Executor::post_batch after all ready sources have run, so a burst is
+ * one delivery rather than one post per event. A post that throws drops
+ * the rest of that batch; it, like a throwing mapper, shows in the
+ * reactor's handler error count. Destroying the dispatcher unregisters
+ * its flush; its sources must be removed, or the loop stopped, before
+ * that.
+ */
+template <typename EventType> class ReactorDispatcher {
+  public:
+    using Target = Executor<EventType>;
+    using Batch = EventBatch<EventType>;
+    using SourceId = Reactor::SourceId;
+    using StreamDecoder =
+        std::function<void(const char *data, std::size_t size, Batch &batch)>;
+    using StreamEnd = std::function<void(Batch &batch)>;
+    using CountMapper = std::function<void(uint64_t count, Batch &batch)>;
+    using ReadyMapper =
+        std::function<void(int fd, uint32_t events, Batch &batch)>;
+
+    // Bytes one stream source reads per wakeup
+    static constexpr std::size_t READ_SIZE = 4096;
+
+  private:
+    Reactor &reactor;
+    Target &executor;
+    Batch batch; // reactor thread only
+    Reactor::WakeupId flush_hook;
+
+  public:
+    ReactorDispatcher(Reactor &event_reactor, Target &target)
+        : reactor(event_reactor), executor(target) {
+        flush_hook = reactor.on_wakeup([this]() { flush(); });
+    }
+
+    ~ReactorDispatcher() { reactor.remove_wakeup(flush_hook); }
+
+    ReactorDispatcher(const ReactorDispatcher &) = delete;
+    ReactorDispatcher &operator=(const ReactorDispatcher &) = delete;
+
+    /**
+     * @brief Read a pipe or connected socket, decoding whatever arrived
+     *
+     * The decoder keeps any partial record for the next call. At end of
+     * stream or on a read error the source is removed and on_end runs;
+     * the descriptor stays the caller's to close.
+     */
+    SourceId add_stream(int fd, StreamDecoder decoder,
+                        StreamEnd on_end = nullptr) {
+        return reactor.watch_source(
+            fd, EPOLLIN,
+            [this, decoder, on_end](SourceId id, int ready_fd, uint32_t) {
+                char buffer[READ_SIZE];
+                ssize_t bytes = ::read(ready_fd, buffer, sizeof(buffer));
+                if (bytes > 0) {
+                    decoder(buffer, static_cast<std::size_t>(bytes), batch);
+                    return;
+                }
+                if (bytes < 0 && (errno == EINTR || errno == EAGAIN))
+                    return;
+                reactor.remove(id);
+                if (on_end) {
+                    on_end(batch);
+                }
+            });
+    }
+
+    // Timer on the reactor; the mapper learns how many periods elapsed
+    SourceId add_timer(Reactor::Clock::duration first,
+                       Reactor::Clock::duration interval, CountMapper mapper) {
+        return reactor.add_timer(
+            first, interval,
+            [this, mapper](uint64_t expirations) { mapper(expirations, batch); });
+    }
+
+    // eventfd written by other threads or processes; read in full
+    SourceId add_counter(int fd, CountMapper mapper) {
+        return reactor.watch(fd, EPOLLIN, [this, mapper](int ready_fd, uint32_t) {
+            uint64_t count = 0;
+            if (::read(ready_fd, &count, sizeof(count)) ==
+                    static_cast<ssize_t>(sizeof(count)) &&
+                count > 0) {
+                mapper(count, batch);
+            }
+        });
+    }
+
+    // Any other descriptor, e.g. a listening socket; the mapper does the I/O
+    SourceId add_descriptor(int fd, uint32_t events, ReadyMapper mapper) {
+        return reactor.watch(fd, events,
+                             [this, mapper](int ready_fd, uint32_t ready) {
+                                 mapper(ready_fd, ready, batch);
+                             });
+    }
+
+  private:
+    void flush() {
+        if (batch.empty())
+            return;
+        // Cleared even if a post throws, so a bad event is not retried on
+        // the next wakeup; the reactor counts the failure
+        struct Clear {
+            Batch &target;
+            ~Clear() { target.clear(); }
+        } clear{batch};
+        executor.post_batch(batch);
+    }
+};
+
+template <typename EventType>
+constexpr std::size_t ReactorDispatcher<EventType>::READ_SIZE;
+
+} // namespace state_machine
@@ -0,0 +1,68 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief One thread serving any number of one-shot timers
+ *
+ * Deadlines sit in a min-heap; the thread sleeps until the earliest one
+ * and runs its callback outside the lock. Cancelled timers are dropped
+ * lazily when they reach the top of the heap.
+ */
+class TimerQueue {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+  private:
+    struct Deadline {
+        Clock::time_point when;
+        TimerId id;
+        bool operator>(const Deadline &other) const {
+            return when > other.when ||
+                   (when == other.when && id > other.id);
+        }
+    };
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>>
+        deadlines;
+    std::unordered_map<TimerId, Callback> callbacks; // armed timers only
+    TimerId next_id = 1;
+    bool running = false;
+    std::thread timer_thread;
+
+  public:
+    TimerQueue() = default;
+    ~TimerQueue();
+
+    TimerQueue(const TimerQueue &) = delete;
+    TimerQueue &operator=(const TimerQueue &) = delete;
+
+    void start();
+    // Pending timers are discarded
+    void stop();
+
+    TimerId schedule(Clock::duration delay, Callback callback);
+
+    // @return false if the timer already fired or was cancelled
+    bool cancel(TimerId id);
+
+    std::size_t get_pending_count();
+
+  private:
+    void timer_loop();
+};
+
+} // namespace state_machine
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Worker pool running task ids from per-worker deques
+ *
+ * A task scheduled from a worker goes to that worker's own deque, one
+ * scheduled from outside is spread round-robin. Owners take tasks from
+ * the front, so a task requeued at the back waits its turn; a worker
+ * whose deque is empty steals half of another worker's deque from the
+ * back. Idle workers sleep until work is scheduled. The scheduler does
+ * not deduplicate: callers must not schedule a task that is already
+ * queued or running.
+ */
+class WorkStealingScheduler {
+  public:
+    using TaskId = std::size_t;
+    using RunTask = std::function<void(TaskId)>;
+
+  private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<TaskId> tasks;
+        std::thread thread;
+    };
+
+    RunTask run_task;
+    std::vector<int> worker_cpus;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<std::size_t> next_worker{0};
+
+    // Sleep/wake protocol: producers bump queued then check sleeping,
+    // sleepers bump sleeping then check queued (both seq_cst)
+    std::atomic<std::size_t> queued{0};
+    std::atomic<std::size_t> sleeping{0};
+    std::atomic<bool> stop_requested{false};
+    std::mutex idle_mutex;
+    std::condition_variable idle_cv;
+
+    std::atomic<uint64_t> steals{0};
+
+  public:
+    /**
+     * @param cpus CPU for each worker, reused round-robin if shorter than
+     *        worker_count; empty leaves placement to the OS
+     */
+    WorkStealingScheduler(std::size_t worker_count, RunTask task_runner,
+                          std::vector<int> cpus = {});
+    ~WorkStealingScheduler();
+
+    WorkStealingScheduler(const WorkStealingScheduler &) = delete;
+    WorkStealingScheduler &operator=(const WorkStealingScheduler &) = delete;
+
+    // Throws if a worker cannot be pinned to its CPU
+    void start();
+    void request_stop();
+    // Joins the workers; tasks still queued are discarded
+    void stop();
+
+    // Urgent tasks go to the front of their deque, ahead of queued ones
+    void schedule(TaskId task, bool urgent = false);
+
+    std::size_t get_worker_count() const { return workers.size(); }
+    uint64_t get_steal_count() const {
+        return steals.load(std::memory_order_relaxed);
+    }
+
+  private:
+    void worker_loop(std::size_t self);
+    bool next_task(std::size_t self, TaskId &task);
+    bool steal_into(std::size_t self, std::size_t victim);
+    void push(std::size_t worker, TaskId task, bool urgent);
+};
+
+} // namespace state_machine
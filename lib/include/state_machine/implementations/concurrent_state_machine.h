@@ -0,0 +1,134 @@
+#pragma once
+#include "../core/state_machine.h"
+#include "../core/state_transition.h"
+#include "../metrics/transition_counters.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Runtime configurable state machine safe for concurrent producers
+ *
+ * The current state is a std::atomic and events are applied with a
+ * compare-and-swap loop over the transition table, so any number of
+ * threads may call process_event while others read get_current_state
+ * (wait-free). Transitions must all be added before the machine is shared;
+ * guards may run more than once per event under contention and must be
+ * thread-safe.
+ */
+template <typename StateType, typename EventType>
+class ConcurrentStateMachine : public IStateMachine<StateType, EventType> {
+  private:
+    std::atomic<StateType> current_state;
+    std::vector<std::unique_ptr<IStateTransition<StateType, EventType>>>
+        transitions;
+    std::set<StateType> states;
+    std::set<EventType> events;
+    std::shared_ptr<TransitionCounters<StateType, EventType>> counters;
+
+  public:
+    explicit ConcurrentStateMachine(StateType initial_state)
+        : current_state(initial_state) {
+        states.insert(initial_state);
+    }
+
+    StateType get_current_state() const override {
+        return current_state.load(std::memory_order_acquire);
+    }
+
+    // Not synchronized with get_all_states; call during setup or recovery
+    void set_state(StateType state) override {
+        states.insert(state);
+        current_state.store(state, std::memory_order_release);
+    }
+
+    // Setup only: the table is read without locks once events flow
+    void add_transition(std::unique_ptr<IStateTransition<StateType, EventType>>
+                            transition) override {
+        states.insert(transition->get_from_state());
+        states.insert(transition->get_to_state());
+        events.insert(transition->get_trigger_event());
+        if (counters) {
+            counters->declare(transition->get_from_state(),
+                              transition->get_trigger_event());
+        }
+        transitions.push_back(std::move(transition));
+    }
+
+    // Setup only, see RuntimeStateMachine::set_counters
+    void set_counters(
+        std::shared_ptr<TransitionCounters<StateType, EventType>> shared) {
+        counters = shared;
+        if (counters) {
+            for (const auto &transition : transitions) {
+                counters->declare(transition->get_from_state(),
+                                  transition->get_trigger_event());
+            }
+        }
+    }
+
+    StateType get_next_state(StateType state, EventType event) const override {
+        const auto *transition = find_transition(state, event);
+        if (transition) {
+            return transition->get_to_state();
+        }
+        return state;
+    }
+
+    bool process_event(EventType event) override {
+        StateType from_state;
+        StateType to_state;
+        return apply_event(event, from_state, to_state);
+    }
+
+    bool apply_event(EventType event, StateType &from_state,
+                     StateType &to_state) override {
+        StateType observed = current_state.load(std::memory_order_acquire);
+        while (true) {
+            GuardOutcome guard = GuardOutcome::NONE;
+            StateType next = observed;
+            const auto *transition = find_transition(observed, event);
+            if (transition) {
+                next = transition->resolve_to_state(guard);
+            }
+
+            // A no-change step needs no write; observed is the linearization
+            if (next == observed ||
+                current_state.compare_exchange_weak(
+                    observed, next, std::memory_order_acq_rel,
+                    std::memory_order_acquire)) {
+                if (counters) {
+                    counters->record(observed, event, next != observed, guard);
+                }
+                from_state = observed;
+                to_state = next;
+                return next != observed;
+            }
+            // observed now holds the state another producer installed
+        }
+    }
+
+    std::vector<StateType> get_all_states() const override {
+        return std::vector<StateType>(states.begin(), states.end());
+    }
+
+    std::vector<EventType> get_all_events() const override {
+        return std::vector<EventType>(events.begin(), events.end());
+    }
+
+  private:
+    const IStateTransition<StateType, EventType> *
+    find_transition(StateType state, EventType event) const {
+        auto it = std::find_if(
+            transitions.begin(), transitions.end(),
+            [&state, &event](
+                const std::unique_ptr<IStateTransition<StateType, EventType>>
+                    &t) { return t->can_transition(state, event); });
+        return it != transitions.end() ? it->get() : nullptr;
+    }
+};
+} // namespace state_machine
@@ -32,6 +32,12 @@ class ConditionalStateTransition
                                                       : to_state_normal;
     }
 
+    StateType resolve_to_state(GuardOutcome &outcome) const override {
+        bool passed = condition_check && condition_check();
+        outcome = passed ? GuardOutcome::PASSED : GuardOutcome::FAILED;
+        return passed ? to_state_conditional : to_state_normal;
+    }
+
     bool can_transition(StateType current_state,
                         EventType event) const override {
         return this->from_state == current_state &&
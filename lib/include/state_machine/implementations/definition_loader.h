@@ -0,0 +1,195 @@
+#pragma once
+#include "machine_definition.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Machine definition read from its declarative JSON form
+ *
+ * Everything is still named; states, events and guards are referenced by
+ * their index in the declaration lists. Layout of the source text:
+ *
+ *     {
+ *       "name": "traffic_light", "version": 2, "initial": "GREEN",
+ *       "events": ["TIME_EXPIRED", "BUTTON_PRESSED"],
+ *       "guards": ["pedestrian_waiting"],
+ *       "states": [
+ *         {"name": "GREEN", "timeout": 10, "display": {"cars": "green"}},
+ *         ...
+ *       ],
+ *       "transitions": [
+ *         {"from": "GREEN", "event": "TIME_EXPIRED", "to": "YELLOW"},
+ *         {"from": "YELLOW", "event": "TIME_EXPIRED", "to": "RED",
+ *          "guard": "pedestrian_waiting", "guarded_to": "WALK"},
+ *         ...
+ *       ],
+ *       "map_states": {"RED_YELLOW": "GREEN"}
+ *     }
+ *
+ * "version" defaults to 1, "timeout" to 0 and "initial" to the first
+ * state; "guards", "display" and "map_states" are optional. Display
+ * values are strings, numbers or booleans and are kept as text.
+ * "map_states" says where machines in a state this version dropped go on
+ * a hot reload.
+ */
+struct DefinitionDocument {
+    struct State {
+        std::string name;
+        uint32_t timeout = 0;
+        std::map<std::string, std::string> display;
+    };
+
+    struct Transition {
+        std::size_t from_state;
+        std::size_t event;
+        std::size_t to_state;
+        std::size_t guarded_state; // to_state unless guarded
+        int guard;                 // index into guards, or -1
+    };
+
+    std::string name;
+    uint64_t version = 1;
+    std::size_t initial_state = 0;
+    std::vector<State> states;
+    std::vector<std::string> events;
+    std::vector<std::string> guards;
+    std::vector<Transition> transitions;
+    std::map<std::string, std::size_t> state_map; // dropped name -> state
+};
+
+/**
+ * @brief Parse and validate a definition
+ *
+ * Rejects malformed JSON, unknown keys, duplicate names, references to
+ * undeclared states, events or guards, guards no transition uses, and a
+ * second transition for the same state and event. Errors are thrown as
+ * std::runtime_error naming the line and column or the offending entry.
+ */
+DefinitionDocument parse_definition(const std::string &text);
+
+// parse_definition on a file's contents
+DefinitionDocument read_definition_file(const std::string &path);
+
+/**
+ * @brief Compiles definition documents into MachineDefinitions of an
+ *        application's enums
+ *
+ * Names are matched against the enums' own names. Parse a definition once
+ * and share the result: every machine running it, e.g. through a
+ * DefinitionSlot, then reads the same packed table.
+ */
+template <typename StateType, typename EventType> class DefinitionLoader {
+  public:
+    using Definition = MachineDefinition<StateType, EventType>;
+    using StateNamer = std::function<std::string(StateType)>;
+    using EventNamer = std::function<std::string(EventType)>;
+
+  private:
+    std::map<std::string, StateType> state_values;
+    std::map<std::string, EventType> event_values;
+
+  public:
+    /**
+     * @param state_count Number of enum values, which must be 0..count-1
+     */
+    DefinitionLoader(StateNamer state_name, std::size_t state_count,
+                     EventNamer event_name, std::size_t event_count) {
+        for (std::size_t i = 0; i < state_count; ++i) {
+            auto state = static_cast<StateType>(i);
+            state_values[state_name(state)] = state;
+        }
+        for (std::size_t i = 0; i < event_count; ++i) {
+            auto event = static_cast<EventType>(i);
+            event_values[event_name(event)] = event;
+        }
+    }
+
+    // Throws if the document names a state or event the enums lack
+    std::shared_ptr<const Definition>
+    compile(const DefinitionDocument &document) const {
+        std::vector<StateType> states;
+        for (const auto &state : document.states) {
+            states.push_back(lookup(state_values, state.name, document,
+                                    "state"));
+        }
+
+        typename Definition::Builder builder(
+            document.version, states[document.initial_state]);
+        for (std::size_t i = 0; i < states.size(); ++i) {
+            StateAttributes attributes;
+            attributes.timeout = document.states[i].timeout;
+            attributes.display = document.states[i].display;
+            builder.set_attributes(states[i], std::move(attributes));
+        }
+
+        for (const auto &transition : document.transitions) {
+            EventType event = lookup(
+                event_values, document.events[transition.event], document,
+                "event");
+            if (transition.guard < 0) {
+                builder.add(states[transition.from_state], event,
+                            states[transition.to_state]);
+            } else {
+                builder.add_guarded(
+                    states[transition.from_state], event,
+                    states[transition.to_state],
+                    states[transition.guarded_state],
+                    document.guards[static_cast<std::size_t>(
+                        transition.guard)]);
+            }
+        }
+
+        if (!document.state_map.empty()) {
+            std::map<StateType, StateType> renamed;
+            for (const auto &entry : document.state_map) {
+                renamed[lookup(state_values, entry.first, document,
+                               "state")] = states[entry.second];
+            }
+            std::set<StateType> kept(states.begin(), states.end());
+            StateType initial = states[document.initial_state];
+            builder.map_states(
+                [renamed, kept, initial](StateType state, uint64_t) {
+                    auto it = renamed.find(state);
+                    if (it != renamed.end())
+                        return it->second;
+                    return kept.count(state) != 0 ? state : initial;
+                });
+        }
+        return builder.build();
+    }
+
+    std::shared_ptr<const Definition> parse(const std::string &text) const {
+        return compile(parse_definition(text));
+    }
+
+    std::shared_ptr<const Definition> load_file(const std::string &path) const {
+        return compile(read_definition_file(path));
+    }
+
+  private:
+    template <typename Value>
+    static Value lookup(const std::map<std::string, Value> &values,
+                        const std::string &name,
+                        const DefinitionDocument &document, const char *kind) {
+        auto it = values.find(name);
+        if (it == values.end()) {
+            std::string definition =
+                document.name.empty() ? "Definition"
+                                      : "Definition '" + document.name + "'";
+            throw std::runtime_error(definition + " names unknown " + kind +
+                                     " '" + name + "'");
+        }
+        return it->second;
+    }
+};
+
+} // namespace state_machine
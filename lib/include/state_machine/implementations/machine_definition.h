@@ -0,0 +1,286 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Per-state data a definition carries besides its transitions
+ * The display entries are free-form; each application reads its own keys.
+ */
+struct StateAttributes {
+    uint32_t timeout = 0; // seconds spent in the state, 0 for none
+    std::map<std::string, std::string> display;
+};
+
+/**
+ * @brief Immutable, versioned transition table shared by many machines
+ *
+ * Guards are named rather than bound: each machine supplies its own guard
+ * functions by name, so one definition serves every instance. A newer
+ * version may map states of older versions (renamed or removed ones) to
+ * its own; by default a state it still has is kept and any other falls
+ * back to its initial state.
+ *
+ * Once built, transitions of dense enums are looked up in a packed
+ * [state][event] index instead of by scanning the rows.
+ */
+template <typename StateType, typename EventType> class MachineDefinition {
+  public:
+    // Maps a state of version from_version to a state of this definition
+    using StateMapper =
+        std::function<StateType(StateType state, uint64_t from_version)>;
+
+    static constexpr int NO_GUARD = -1;
+    // Largest dimension indexed by the packed table
+    static constexpr std::size_t MAX_PACKED_SPAN = 1024;
+
+    struct Row {
+        StateType from_state;
+        EventType event;
+        StateType to_state;      // target when unguarded or the guard fails
+        StateType guarded_state; // target when the guard holds
+        int guard;               // index into get_guard_names(), or NO_GUARD
+    };
+
+    class Builder;
+
+  private:
+    uint64_t version;
+    StateType initial_state;
+    std::vector<Row> rows;
+    std::vector<std::string> guard_names;
+    std::set<StateType> states;
+    std::set<EventType> events;
+    std::map<StateType, StateAttributes> attributes;
+    StateMapper mapper;
+    // Row index per [state][event], NO_GUARD for none; empty if unpacked
+    std::vector<int> packed;
+    std::size_t state_span = 0;
+    std::size_t event_span = 0;
+
+    MachineDefinition(uint64_t definition_version, StateType initial)
+        : version(definition_version), initial_state(initial) {
+        states.insert(initial);
+    }
+
+  public:
+    uint64_t get_version() const { return version; }
+    StateType get_initial_state() const { return initial_state; }
+    const std::vector<Row> &get_rows() const { return rows; }
+    const std::vector<std::string> &get_guard_names() const {
+        return guard_names;
+    }
+
+    // nullptr if the event is ignored in state
+    const Row *find(StateType state, EventType event) const {
+        if (!packed.empty()) {
+            auto s = static_cast<std::size_t>(state);
+            auto e = static_cast<std::size_t>(event);
+            if (s >= state_span || e >= event_span)
+                return nullptr;
+            int row = packed[s * event_span + e];
+            return row == NO_GUARD ? nullptr
+                                   : &rows[static_cast<std::size_t>(row)];
+        }
+        auto it = std::find_if(rows.begin(), rows.end(),
+                               [&state, &event](const Row &row) {
+                                   return row.from_state == state &&
+                                          row.event == event;
+                               });
+        return it != rows.end() ? &*it : nullptr;
+    }
+
+    bool has_state(StateType state) const { return states.count(state) != 0; }
+
+    bool is_packed() const { return !packed.empty(); }
+
+    // nullptr if the definition says nothing about state
+    const StateAttributes *get_attributes(StateType state) const {
+        auto it = attributes.find(state);
+        return it != attributes.end() ? &it->second : nullptr;
+    }
+
+    StateType map_state(StateType state, uint64_t from_version) const {
+        if (mapper)
+            return mapper(state, from_version);
+        return has_state(state) ? state : initial_state;
+    }
+
+    std::vector<StateType> get_all_states() const {
+        return std::vector<StateType>(states.begin(), states.end());
+    }
+
+    std::vector<EventType> get_all_events() const {
+        return std::vector<EventType>(events.begin(), events.end());
+    }
+};
+
+template <typename StateType, typename EventType>
+constexpr int MachineDefinition<StateType, EventType>::NO_GUARD;
+template <typename StateType, typename EventType>
+constexpr std::size_t MachineDefinition<StateType, EventType>::MAX_PACKED_SPAN;
+
+/**
+ * @brief Assembles a MachineDefinition; each (state, event) pair may have
+ *        one transition
+ */
+template <typename StateType, typename EventType>
+class MachineDefinition<StateType, EventType>::Builder {
+  private:
+    std::shared_ptr<MachineDefinition> definition;
+
+  public:
+    Builder(uint64_t version, StateType initial_state)
+        : definition(new MachineDefinition(version, initial_state)) {}
+
+    Builder &add(StateType from_state, EventType event, StateType to_state) {
+        return add_row({from_state, event, to_state, to_state, NO_GUARD});
+    }
+
+    // Goes to guarded_state if the named guard holds, else to to_state
+    Builder &add_guarded(StateType from_state, EventType event,
+                         StateType to_state, StateType guarded_state,
+                         const std::string &guard) {
+        check_open();
+        auto &names = definition->guard_names;
+        auto it = std::find(names.begin(), names.end(), guard);
+        int index = static_cast<int>(it - names.begin());
+        if (it == names.end()) {
+            names.push_back(guard);
+        }
+        definition->states.insert(guarded_state);
+        return add_row({from_state, event, to_state, guarded_state, index});
+    }
+
+    Builder &map_states(StateMapper mapper) {
+        check_open();
+        definition->mapper = std::move(mapper);
+        return *this;
+    }
+
+    // Declares state even if no transition names it
+    Builder &set_attributes(StateType state, StateAttributes attributes) {
+        check_open();
+        definition->states.insert(state);
+        definition->attributes[state] = std::move(attributes);
+        return *this;
+    }
+
+    // The builder is spent afterwards
+    std::shared_ptr<const MachineDefinition> build() {
+        check_open();
+        pack();
+        std::shared_ptr<const MachineDefinition> built = std::move(definition);
+        return built;
+    }
+
+  private:
+    void check_open() const {
+        if (!definition) {
+            throw std::runtime_error("Machine definition already built");
+        }
+    }
+
+    // Leaves sparse or negative enums to the row scan
+    void pack() {
+        std::size_t state_span = 0;
+        std::size_t event_span = 0;
+        for (const auto &row : definition->rows) {
+            auto state = static_cast<std::size_t>(row.from_state);
+            auto event = static_cast<std::size_t>(row.event);
+            if (state >= MAX_PACKED_SPAN || event >= MAX_PACKED_SPAN)
+                return;
+            state_span = std::max(state_span, state + 1);
+            event_span = std::max(event_span, event + 1);
+        }
+        if (state_span == 0)
+            return;
+
+        definition->packed.assign(state_span * event_span, NO_GUARD);
+        for (std::size_t i = 0; i < definition->rows.size(); ++i) {
+            const Row &row = definition->rows[i];
+            definition->packed[static_cast<std::size_t>(row.from_state) *
+                                   event_span +
+                               static_cast<std::size_t>(row.event)] =
+                static_cast<int>(i);
+        }
+        definition->state_span = state_span;
+        definition->event_span = event_span;
+    }
+
+    Builder &add_row(const Row &row) {
+        check_open();
+        if (definition->find(row.from_state, row.event)) {
+            throw std::runtime_error(
+                "Duplicate transition in machine definition version " +
+                std::to_string(definition->version));
+        }
+        definition->states.insert(row.from_state);
+        definition->states.insert(row.to_state);
+        definition->events.insert(row.event);
+        definition->rows.push_back(row);
+        return *this;
+    }
+};
+
+/**
+ * @brief Publication point for the current version of a definition
+ *
+ * Machines keep a reference to the definition they run and compare its
+ * version against get_version() on every event, a single atomic load;
+ * only after a publish do they fetch the new definition. An old version
+ * is freed once the last machine holding it has moved on, so publishing
+ * never waits for readers.
+ */
+template <typename StateType, typename EventType> class DefinitionSlot {
+  public:
+    using Definition = MachineDefinition<StateType, EventType>;
+
+  private:
+    std::shared_ptr<const Definition> current;
+    std::atomic<uint64_t> version;
+    std::mutex publish_mutex;
+
+  public:
+    explicit DefinitionSlot(std::shared_ptr<const Definition> initial)
+        : current(std::move(initial)), version(current->get_version()) {}
+
+    DefinitionSlot(const DefinitionSlot &) = delete;
+    DefinitionSlot &operator=(const DefinitionSlot &) = delete;
+
+    // Throws unless next is newer than the current version
+    void publish(std::shared_ptr<const Definition> next) {
+        std::lock_guard<std::mutex> lock(publish_mutex);
+        if (next->get_version() <= version.load(std::memory_order_relaxed)) {
+            throw std::runtime_error(
+                "Machine definition version " +
+                std::to_string(next->get_version()) + " is not newer than " +
+                std::to_string(version.load(std::memory_order_relaxed)));
+        }
+        // The pointer goes first, so a reader that sees the new version
+        // loads at least that definition
+        std::atomic_store(&current, std::move(next));
+        version.store(std::atomic_load(&current)->get_version(),
+                      std::memory_order_release);
+    }
+
+    std::shared_ptr<const Definition> load() const {
+        return std::atomic_load(&current);
+    }
+
+    uint64_t get_version() const {
+        return version.load(std::memory_order_acquire);
+    }
+};
+
+} // namespace state_machine
@@ -1,7 +1,10 @@
 #pragma once
 #include "../core/state_machine.h"
 #include "../core/state_transition.h"
+#include "../memory/memory_resource.h"
+#include "../metrics/transition_counters.h"
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <set>
 #include <vector>
@@ -10,19 +13,34 @@ namespace state_machine {
 
 /**
  * @brief Runtime configurable state machine
+ *
+ * The transition list and state and event sets allocate from the memory
+ * resource given at construction; the transitions themselves are
+ * whatever the caller allocated.
  */
 template <typename StateType, typename EventType>
 class RuntimeStateMachine : public IStateMachine<StateType, EventType> {
   private:
+    using TransitionPtr =
+        std::unique_ptr<IStateTransition<StateType, EventType>>;
+
     StateType current_state;
-    std::vector<std::unique_ptr<IStateTransition<StateType, EventType>>>
+    std::vector<TransitionPtr, pmr::polymorphic_allocator<TransitionPtr>>
         transitions;
-    std::set<StateType> states;
-    std::set<EventType> events;
+    std::set<StateType, std::less<StateType>,
+             pmr::polymorphic_allocator<StateType>>
+        states;
+    std::set<EventType, std::less<EventType>,
+             pmr::polymorphic_allocator<EventType>>
+        events;
+    std::shared_ptr<TransitionCounters<StateType, EventType>> counters;
 
   public:
-    explicit RuntimeStateMachine(StateType initial_state)
-        : current_state(initial_state) {
+    explicit RuntimeStateMachine(
+        StateType initial_state,
+        pmr::memory_resource *resource = pmr::get_default_resource())
+        : current_state(initial_state), transitions(resource),
+          states(resource), events(resource) {
         states.insert(initial_state);
     }
 
@@ -38,28 +56,53 @@ class RuntimeStateMachine : public IStateMachine<StateType, EventType> {
         states.insert((transition->get_from_state()));
         states.insert((transition->get_to_state()));
         events.insert((transition->get_trigger_event()));
+        if (counters) {
+            counters->declare(transition->get_from_state(),
+                              transition->get_trigger_event());
+        }
         transitions.push_back(std::move(transition));
     }
 
+    /**
+     * @brief Count every processed event into a per-edge matrix
+     * Typically shared by all machines built from one definition
+     */
+    void set_counters(
+        std::shared_ptr<TransitionCounters<StateType, EventType>> shared) {
+        counters = shared;
+        if (counters) {
+            for (const auto &transition : transitions) {
+                counters->declare(transition->get_from_state(),
+                                  transition->get_trigger_event());
+            }
+        }
+    }
+
+    std::shared_ptr<TransitionCounters<StateType, EventType>>
+    get_counters() const {
+        return counters;
+    }
+
     StateType get_next_state(StateType current_state,
                              EventType event) const override {
-        auto it = std::find_if(
-            transitions.begin(), transitions.end(),
-            [&current_state, &event](
-                const std::unique_ptr<IStateTransition<StateType, EventType>>
-                    &t) {
-                return t->can_transition(static_cast<StateType>(current_state),
-                                         static_cast<EventType>(event));
-            });
-
-        if (it != transitions.end()) {
-            return static_cast<StateType>((*it)->get_to_state());
+        const auto *transition = find_transition(current_state, event);
+        if (transition) {
+            return static_cast<StateType>(transition->get_to_state());
         }
         return current_state;
     }
 
     bool process_event(EventType event) override {
-        StateType next_state = get_next_state(current_state, event);
+        StateType next_state = current_state;
+        GuardOutcome guard = GuardOutcome::NONE;
+        const auto *transition = find_transition(current_state, event);
+        if (transition) {
+            next_state = transition->resolve_to_state(guard);
+        }
+        if (counters) {
+            counters->record(current_state, event, next_state != current_state,
+                             guard);
+        }
         if (next_state != current_state) {
             current_state = next_state;
             return true;
@@ -67,6 +110,14 @@ class RuntimeStateMachine : public IStateMachine<StateType, EventType> {
         return false;
     }
 
+    bool apply_event(EventType event, StateType &from_state,
+                     StateType &to_state) override {
+        from_state = current_state;
+        bool changed = process_event(event);
+        to_state = current_state;
+        return changed;
+    }
+
     std::vector<StateType> get_all_states() const override {
         return std::vector<StateType>(states.begin(), states.end());
     }
@@ -74,5 +125,16 @@ class RuntimeStateMachine : public IStateMachine<StateType, EventType> {
     std::vector<EventType> get_all_events() const override {
         return std::vector<EventType>(events.begin(), events.end());
     }
+
+  private:
+    const IStateTransition<StateType, EventType> *
+    find_transition(StateType state, EventType event) const {
+        auto it = std::find_if(
+            transitions.begin(), transitions.end(),
+            [&state, &event](
+                const std::unique_ptr<IStateTransition<StateType, EventType>>
+                    &t) { return t->can_transition(state, event); });
+        return it != transitions.end() ? it->get() : nullptr;
+    }
 };
 } // namespace state_machine
@@ -0,0 +1,55 @@
+#pragma once
+#include "../memory/memory_resource.h"
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Per-state configuration (timing, display) indexed by state
+ *
+ * Meant to be built once per definition and shared read-only, through
+ * std::shared_ptr<const StateContextTable>, by every handler running it;
+ * a handler that needs a different entry copies the table first. States
+ * are indexed through static_cast<std::size_t>, so the enum should be
+ * dense and start at zero. A copy allocates from the default resource,
+ * not the original's.
+ */
+template <typename StateType, typename ContextType> class StateContextTable {
+  private:
+    std::vector<ContextType, pmr::polymorphic_allocator<ContextType>>
+        contexts;
+    std::vector<bool, pmr::polymorphic_allocator<bool>> present;
+
+  public:
+    explicit StateContextTable(
+        std::size_t state_count,
+        pmr::memory_resource *resource = pmr::get_default_resource())
+        : contexts(state_count, ContextType(), resource),
+          present(state_count, false, resource) {}
+
+    void set(StateType state, ContextType context) {
+        auto index = static_cast<std::size_t>(state);
+        if (index >= contexts.size()) {
+            throw std::runtime_error("State " + std::to_string(index) +
+                                     " outside a context table of " +
+                                     std::to_string(contexts.size()));
+        }
+        contexts[index] = std::move(context);
+        present[index] = true;
+    }
+
+    // nullptr if the state has no context
+    const ContextType *find(StateType state) const {
+        auto index = static_cast<std::size_t>(state);
+        return index < contexts.size() && present[index] ? &contexts[index]
+                                                         : nullptr;
+    }
+
+    std::size_t get_state_count() const { return contexts.size(); }
+};
+
+} // namespace state_machine
@@ -0,0 +1,212 @@
+#pragma once
+#include "../core/state_machine.h"
+#include "../core/state_transition.h"
+#include "../memory/memory_resource.h"
+#include "../metrics/transition_counters.h"
+#include "machine_definition.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief State machine running whatever definition a DefinitionSlot holds
+ *
+ * The machine owns only its current state and guard bindings, each guard
+ * stored once, so thousands of machines can share one definition. Before
+ * each event it checks the slot's version; after a publish it maps its
+ * state into the new definition and rebinds its guards, so live machines
+ * switch at their next event without being paused. Like RuntimeStateMachine it
+ * expects one thread at a time. The guard lists allocate from the memory
+ * resource given at construction; a guard's own captures stay inside its
+ * std::function when they fit, e.g. a single pointer.
+ */
+template <typename StateType, typename EventType>
+class VersionedStateMachine : public IStateMachine<StateType, EventType> {
+  public:
+    using Definition = MachineDefinition<StateType, EventType>;
+    using Slot = DefinitionSlot<StateType, EventType>;
+    using Guard = std::function<bool()>;
+
+  private:
+    using NamedGuard = std::pair<std::string, Guard>;
+
+    std::shared_ptr<const Slot> slot;
+    std::shared_ptr<const Definition> definition;
+    StateType current_state;
+    // Indexed like the definition's guard names
+    std::vector<Guard, pmr::polymorphic_allocator<Guard>> bound;
+    // Guards bound to names the current definition does not use
+    std::vector<NamedGuard, pmr::polymorphic_allocator<NamedGuard>> unused;
+    std::shared_ptr<TransitionCounters<StateType, EventType>> counters;
+    std::shared_ptr<const void> guard_owner;
+
+  public:
+    explicit VersionedStateMachine(
+        std::shared_ptr<const Slot> source,
+        pmr::memory_resource *resource = pmr::get_default_resource())
+        : slot(std::move(source)), definition(slot->load()),
+          current_state(definition->get_initial_state()),
+          bound(definition->get_guard_names().size(), Guard(), resource),
+          unused(resource) {}
+
+    /**
+     * @brief Supply the function behind a named guard
+     * A guard the machine leaves unbound never holds.
+     */
+    void bind_guard(const std::string &name, Guard guard) {
+        bind(name, std::move(guard));
+    }
+
+    // Spares building a std::string for a name the definition uses
+    void bind_guard(const char *name, Guard guard) {
+        bind(name, std::move(guard));
+    }
+
+    /**
+     * @brief Keep the object the guards point into alive with the machine
+     * Lets guards capture a plain pointer, which fits inside the
+     * std::function, and stay valid however long the machine is shared.
+     */
+    void keep_alive(std::shared_ptr<const void> owner) {
+        guard_owner = std::move(owner);
+    }
+
+    StateType get_current_state() const override { return current_state; }
+
+    void set_state(StateType state) override { current_state = state; }
+
+    void add_transition(
+        std::unique_ptr<IStateTransition<StateType, EventType>>) override {
+        throw std::runtime_error("Versioned machine definitions are "
+                                 "immutable; publish a new version instead");
+    }
+
+    // See RuntimeStateMachine::set_counters
+    void set_counters(
+        std::shared_ptr<TransitionCounters<StateType, EventType>> shared) {
+        counters = shared;
+        declare();
+    }
+
+    StateType get_next_state(StateType state, EventType event) const override {
+        const auto *row = definition->find(state, event);
+        if (!row)
+            return state;
+        GuardOutcome guard;
+        return resolve(*row, guard);
+    }
+
+    bool process_event(EventType event) override {
+        refresh();
+        StateType next_state = current_state;
+        GuardOutcome guard = GuardOutcome::NONE;
+        const auto *row = definition->find(current_state, event);
+        if (row) {
+            next_state = resolve(*row, guard);
+        }
+        if (counters) {
+            counters->record(current_state, event, next_state != current_state,
+                             guard);
+        }
+        if (next_state != current_state) {
+            current_state = next_state;
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<StateType> get_all_states() const override {
+        return definition->get_all_states();
+    }
+
+    std::vector<EventType> get_all_events() const override {
+        return definition->get_all_events();
+    }
+
+    // Version the machine currently runs, possibly behind the slot's
+    uint64_t get_version() const { return definition->get_version(); }
+
+    /**
+     * @brief Switch to the slot's current definition if it changed
+     * @return true if the machine moved to a new version
+     */
+    bool refresh() {
+        if (slot->get_version() == definition->get_version())
+            return false;
+        auto next = slot->load();
+        current_state =
+            next->map_state(current_state, definition->get_version());
+        rebind(*definition, *next);
+        definition = std::move(next);
+        declare();
+        return true;
+    }
+
+  private:
+    template <typename Name> void bind(const Name &name, Guard guard) {
+        const auto &names = definition->get_guard_names();
+        auto it = std::find(names.begin(), names.end(), name);
+        if (it != names.end()) {
+            bound[static_cast<std::size_t>(it - names.begin())] =
+                std::move(guard);
+            return;
+        }
+        for (auto &entry : unused) {
+            if (entry.first == name) {
+                entry.second = std::move(guard);
+                return;
+            }
+        }
+        unused.emplace_back(name, std::move(guard));
+    }
+
+    StateType resolve(const typename Definition::Row &row,
+                      GuardOutcome &outcome) const {
+        if (row.guard == Definition::NO_GUARD) {
+            outcome = GuardOutcome::NONE;
+            return row.to_state;
+        }
+        const Guard &guard = bound[static_cast<std::size_t>(row.guard)];
+        bool passed = guard && guard();
+        outcome = passed ? GuardOutcome::PASSED : GuardOutcome::FAILED;
+        return passed ? row.guarded_state : row.to_state;
+    }
+
+    // Moves every guard to its index in next, or aside if next lacks it
+    void rebind(const Definition &previous, const Definition &next) {
+        const auto &old_names = previous.get_guard_names();
+        for (std::size_t i = 0; i < bound.size(); ++i) {
+            if (bound[i]) {
+                unused.emplace_back(old_names[i], std::move(bound[i]));
+            }
+        }
+        const auto &names = next.get_guard_names();
+        bound.assign(names.size(), Guard());
+        for (auto it = unused.begin(); it != unused.end();) {
+            auto found = std::find(names.begin(), names.end(), it->first);
+            if (found == names.end()) {
+                ++it;
+                continue;
+            }
+            bound[static_cast<std::size_t>(found - names.begin())] =
+                std::move(it->second);
+            it = unused.erase(it);
+        }
+    }
+
+    void declare() {
+        if (!counters)
+            return;
+        for (const auto &row : definition->get_rows()) {
+            counters->declare(row.from_state, row.event);
+        }
+    }
+};
+
+} // namespace state_machine
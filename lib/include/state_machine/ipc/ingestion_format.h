@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace state_machine {
+
+/**
+ * @brief Header of one ingestion message, followed by frame_count frames
+ *
+ * A message is a single SOCK_SEQPACKET datagram. Requests carry
+ * EventFrames, replies StateFrames; all fields are in host byte order,
+ * since both ends share a machine.
+ */
+struct FrameBatchHeader {
+    uint32_t magic; // FRAME_BATCH_MAGIC or STATE_BATCH_MAGIC
+    uint16_t version;
+    uint16_t flags; // FRAME_BATCH_* bits
+    uint32_t frame_count;
+    uint32_t sequence; // chosen by the sender, echoed in the reply
+
+    static constexpr uint16_t FORMAT_VERSION = 1;
+};
+
+static_assert(sizeof(FrameBatchHeader) == 16,
+              "FrameBatchHeader layout is part of the wire format");
+
+constexpr uint32_t FRAME_BATCH_MAGIC = 0x56454d53; // "SMEV"
+constexpr uint32_t STATE_BATCH_MAGIC = 0x54534d53; // "SMST"
+
+// Request flag: answer with one StateFrame per EventFrame. The reply is
+// sent before the batch is handled, so it reports each frame's status and
+// the state published before the batch, not its outcome
+constexpr uint16_t FRAME_BATCH_REPLY = 1;
+
+/**
+ * @brief One event for one controller
+ *
+ * The timestamp is CLOCK_MONOTONIC (std::chrono::steady_clock on Linux)
+ * nanoseconds when the sender produced the event, so the server can
+ * measure transit time; 0 skips the measurement.
+ */
+struct EventFrame {
+    uint32_t instance_id; // executor instance id
+    uint16_t event;       // application event code
+    uint8_t priority;     // EventPriority value
+    uint8_t flags;        // reserved, 0
+    uint64_t timestamp_ns;
+};
+
+static_assert(sizeof(EventFrame) == 16,
+              "EventFrame layout is part of the wire format");
+
+/**
+ * @brief Outcome of one EventFrame
+ */
+enum class FrameStatus : uint8_t {
+    ACCEPTED,         // handed to the controller's mailbox
+    UNKNOWN_INSTANCE, // no such controller
+    UNKNOWN_EVENT,    // the event code or priority is invalid
+};
+
+/**
+ * @brief Reply entry for the EventFrame at the same position
+ */
+struct StateFrame {
+    uint32_t instance_id;
+    // State before this batch; STATE_UNKNOWN unless the server reads states
+    uint32_t last_published_state;
+    uint8_t status; // FrameStatus
+    uint8_t reserved[7];
+};
+
+static_assert(sizeof(StateFrame) == 16,
+              "StateFrame layout is part of the wire format");
+
+constexpr uint32_t STATE_UNKNOWN = 0xffffffffu;
+
+// Frames per message, so that one message fits 64 KiB
+constexpr std::size_t MAX_BATCH_FRAMES =
+    (65536 - sizeof(FrameBatchHeader)) / sizeof(EventFrame);
+constexpr std::size_t MAX_BATCH_BYTES =
+    sizeof(FrameBatchHeader) + MAX_BATCH_FRAMES * sizeof(EventFrame);
+
+} // namespace state_machine
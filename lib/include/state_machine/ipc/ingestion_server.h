@@ -0,0 +1,256 @@
+#pragma once
+#include "../execution/reactor_dispatcher.h"
+#include "ingestion_format.h"
+#include "ingestion_socket.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+/**
+ * @brief Counters of an IngestionServer, readable from any thread
+ */
+struct IngestionStats {
+    std::atomic<uint64_t> messages{0};
+    std::atomic<uint64_t> frames_accepted{0};
+    std::atomic<uint64_t> frames_rejected{0};  // unknown instance or event
+    std::atomic<uint64_t> malformed_messages{0}; // connection was closed
+    std::atomic<uint64_t> replies_dropped{0};  // client not reading
+    std::atomic<uint64_t> connections{0};      // currently open
+    std::atomic<int64_t> max_transit_ns{0};    // frame timestamp to receipt
+};
+
+/**
+ * @brief Accepts binary event batches on a Unix socket and routes them to
+ *        an executor's controllers
+ *
+ * Gateways connect with SOCK_SEQPACKET and send messages of fixed-size
+ * EventFrames (see ingestion_format.h), e.g. through IngestionClient.
+ * Frames are validated and decoded where they landed in the receive
+ * buffer; everything received in one reactor wakeup reaches the mailboxes
+ * as one Executor::post_batch. A message flagged FRAME_BATCH_REPLY is
+ * answered at once with one StateFrame per frame: its status and, given
+ * a state reader, the controller's last published state. The reply goes
+ * out before the batch is handled, so that state never reflects the
+ * batch itself.
+ *
+ * Runs on the reactor thread. The server must outlive the reactor loop
+ * and be destroyed only while the loop is stopped.
+ */
+template <typename EventType> class IngestionServer {
+  public:
+    using Target = Executor<EventType>;
+    using Batch = EventBatch<EventType>;
+    // false rejects the frame
+    using EventDecoder = std::function<bool(uint16_t code, EventType &event)>;
+    // Last state the instance published; false if it has none to report
+    using StateReader =
+        std::function<bool(uint32_t instance_id, uint32_t &state)>;
+
+    // Messages read from one connection per wakeup, for fairness
+    static constexpr int MESSAGES_PER_WAKEUP = 16;
+
+  private:
+    Reactor &reactor;
+    Target &executor;
+    ReactorDispatcher<EventType> dispatcher;
+    EventDecoder decode;
+    StateReader read_state;
+    std::string socket_path;
+    int listener = -1;
+    Reactor::SourceId listener_source = 0;
+    std::unordered_map<int, Reactor::SourceId> connections;
+    std::vector<uint64_t> receive_buffer; // 8-byte aligned frames
+    std::vector<uint64_t> reply_buffer;
+    IngestionStats stats;
+
+  public:
+    /**
+     * @param decoder Maps wire event codes to events; by default the code
+     *        is cast to EventType
+     */
+    IngestionServer(Reactor &event_reactor, Target &target,
+                    const std::string &path, EventDecoder decoder = nullptr,
+                    StateReader state_reader = nullptr)
+        : reactor(event_reactor), executor(target),
+          dispatcher(event_reactor, target), decode(std::move(decoder)),
+          read_state(std::move(state_reader)), socket_path(path),
+          receive_buffer(MAX_BATCH_BYTES / sizeof(uint64_t)),
+          reply_buffer(MAX_BATCH_BYTES / sizeof(uint64_t)) {
+        if (!decode) {
+            decode = [](uint16_t code, EventType &event) {
+                event = static_cast<EventType>(code);
+                return true;
+            };
+        }
+        listener = listen_ingestion_socket(socket_path);
+        try {
+            listener_source = dispatcher.add_descriptor(
+                listener, EPOLLIN,
+                [this](int, uint32_t, Batch &) { accept_connections(); });
+        } catch (...) {
+            ::close(listener);
+            ::unlink(socket_path.c_str());
+            throw;
+        }
+    }
+
+    ~IngestionServer() {
+        reactor.remove(listener_source);
+        for (const auto &connection : connections) {
+            reactor.remove(connection.second);
+            ::close(connection.first);
+        }
+        ::close(listener);
+        ::unlink(socket_path.c_str());
+    }
+
+    IngestionServer(const IngestionServer &) = delete;
+    IngestionServer &operator=(const IngestionServer &) = delete;
+
+    const IngestionStats &get_stats() const { return stats; }
+    const std::string &get_path() const { return socket_path; }
+
+  private:
+    void accept_connections() {
+        while (true) {
+            int fd = ::accept4(listener, nullptr, nullptr,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR)
+                    continue;
+                return; // EAGAIN, or a connection that died while queued
+            }
+            connections[fd] = dispatcher.add_descriptor(
+                fd, EPOLLIN, [this](int ready_fd, uint32_t, Batch &batch) {
+                    receive(ready_fd, batch);
+                });
+            stats.connections.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void receive(int fd, Batch &batch) {
+        for (int message = 0; message < MESSAGES_PER_WAKEUP; ++message) {
+            iovec part = {receive_buffer.data(), MAX_BATCH_BYTES};
+            msghdr header = {};
+            header.msg_iov = &part;
+            header.msg_iovlen = 1;
+            ssize_t bytes = ::recvmsg(fd, &header, 0);
+            if (bytes < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    close_connection(fd);
+                }
+                return;
+            }
+            if (bytes == 0) {
+                close_connection(fd);
+                return;
+            }
+
+            FrameBatchView view;
+            if ((header.msg_flags & MSG_TRUNC) ||
+                !parse_frame_batch(receive_buffer.data(),
+                                   static_cast<std::size_t>(bytes), view)) {
+                // A peer that breaks framing cannot be resynchronised
+                stats.malformed_messages.fetch_add(1,
+                                                   std::memory_order_relaxed);
+                close_connection(fd);
+                return;
+            }
+            stats.messages.fetch_add(1, std::memory_order_relaxed);
+            route(fd, view, batch);
+        }
+    }
+
+    void route(int fd, const FrameBatchView &view, Batch &batch) {
+        bool reply = (view.header->flags & FRAME_BATCH_REPLY) != 0;
+        auto *header = reinterpret_cast<FrameBatchHeader *>(reply_buffer.data());
+        auto *states = reinterpret_cast<StateFrame *>(header + 1);
+        int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now().time_since_epoch())
+                             .count();
+        std::size_t instance_count = executor.get_instance_count();
+
+        uint64_t accepted = 0;
+        for (std::size_t i = 0; i < view.count; ++i) {
+            const EventFrame &frame = view.frames[i];
+            FrameStatus status = FrameStatus::ACCEPTED;
+            EventType event = EventType();
+            if (frame.instance_id >= instance_count) {
+                status = FrameStatus::UNKNOWN_INSTANCE;
+            } else if (frame.priority >= PRIORITY_LANES ||
+                       !decode(frame.event, event)) {
+                status = FrameStatus::UNKNOWN_EVENT;
+            } else {
+                batch.add(frame.instance_id, event,
+                          static_cast<EventPriority>(frame.priority));
+                ++accepted;
+                if (frame.timestamp_ns != 0) {
+                    record_transit(now_ns -
+                                   static_cast<int64_t>(frame.timestamp_ns));
+                }
+            }
+
+            if (reply) {
+                StateFrame &entry = states[i];
+                entry = StateFrame();
+                entry.instance_id = frame.instance_id;
+                entry.status = static_cast<uint8_t>(status);
+                if (!read_state || status == FrameStatus::UNKNOWN_INSTANCE ||
+                    !read_state(frame.instance_id,
+                                entry.last_published_state)) {
+                    entry.last_published_state = STATE_UNKNOWN;
+                }
+            }
+        }
+        stats.frames_accepted.fetch_add(accepted, std::memory_order_relaxed);
+        stats.frames_rejected.fetch_add(view.count - accepted,
+                                        std::memory_order_relaxed);
+
+        if (reply) {
+            *header = *view.header;
+            header->magic = STATE_BATCH_MAGIC;
+            header->flags = 0;
+            std::size_t size =
+                sizeof(FrameBatchHeader) + view.count * sizeof(StateFrame);
+            // Never block the reactor on a client that stopped reading
+            if (::send(fd, header, size, MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+                stats.replies_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void record_transit(int64_t ns) {
+        int64_t seen = stats.max_transit_ns.load(std::memory_order_relaxed);
+        while (ns > seen && !stats.max_transit_ns.compare_exchange_weak(
+                                seen, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    void close_connection(int fd) {
+        auto found = connections.find(fd);
+        if (found == connections.end())
+            return;
+        reactor.remove(found->second);
+        connections.erase(found);
+        ::close(fd);
+        stats.connections.fetch_sub(1, std::memory_order_relaxed);
+    }
+};
+
+template <typename EventType>
+constexpr int IngestionServer<EventType>::MESSAGES_PER_WAKEUP;
+
+} // namespace state_machine
@@ -0,0 +1,69 @@
+#pragma once
+#include "ingestion_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Frames of a received message, pointing into the receive buffer
+ */
+struct FrameBatchView {
+    const FrameBatchHeader *header;
+    const EventFrame *frames;
+    std::size_t count;
+};
+
+/**
+ * @brief Validate a request in place without copying its frames
+ * @param data Start of the message, aligned to 8 bytes
+ * @return false if the header or the size is wrong
+ */
+bool parse_frame_batch(const void *data, std::size_t size,
+                       FrameBatchView &view);
+
+/**
+ * @brief Bind a non-blocking SOCK_SEQPACKET listener, replacing a stale
+ *        socket file at path; throws on failure
+ */
+int listen_ingestion_socket(const std::string &path);
+
+/**
+ * @brief Gateway side of the ingestion protocol
+ *
+ * Sends batches of EventFrames over one connection and, for batches sent
+ * with a reply requested, reads back the StateFrames. Blocking.
+ */
+class IngestionClient {
+  private:
+    int fd = -1;
+    uint32_t next_sequence = 1;
+    std::vector<uint64_t> buffer; // one message, 8-byte aligned
+
+  public:
+    // Throws if the server cannot be reached
+    explicit IngestionClient(const std::string &path);
+    ~IngestionClient();
+
+    IngestionClient(const IngestionClient &) = delete;
+    IngestionClient &operator=(const IngestionClient &) = delete;
+
+    /**
+     * @brief Send up to MAX_BATCH_FRAMES frames as one message
+     * @return Sequence number the reply will carry
+     */
+    uint32_t send(const EventFrame *frames, std::size_t count,
+                  bool want_reply = false);
+
+    /**
+     * @brief Wait for the next reply
+     * @return Its sequence number
+     */
+    uint32_t receive_reply(std::vector<StateFrame> &states);
+
+    int get_fd() const { return fd; }
+};
+
+} // namespace state_machine
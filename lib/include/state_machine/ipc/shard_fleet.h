@@ -0,0 +1,267 @@
+#pragma once
+#include "../execution/reactor_dispatcher.h"
+#include "../metrics/metrics_registry.h"
+#include "../metrics/state_board.h"
+#include "shm_frame_ring.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+namespace state_machine {
+
+/**
+ * @brief Per-shard counters in memory shared with the coordinator
+ */
+struct alignas(64) ShardControl {
+    std::atomic<uint64_t> pid;
+    std::atomic<uint64_t> received; // frames taken off the ring
+    std::atomic<uint64_t> unrouted; // frames for instances not on the shard
+    std::atomic<uint64_t> handled;  // events the shard's executor handled
+    std::atomic<uint64_t> heartbeat_ns; // steady clock of the last update
+    std::atomic<uint32_t> stop;         // set by the coordinator
+};
+
+/**
+ * @brief What a shard process gets to build and run its controllers
+ */
+struct ShardContext {
+    std::size_t index;
+    std::size_t shard_count;
+    std::vector<uint32_t> instance_ids; // fleet-wide ids owned by the shard
+    ShmFrameRing *ring;
+    ShardControl *control;
+    // Slot i holds instance i; null unless FleetOptions::board_name is set
+    std::shared_ptr<StateBoard> board;
+
+    bool stop_requested() const {
+        return control->stop.load(std::memory_order_acquire) != 0;
+    }
+};
+
+/**
+ * @brief Shape of a sharded fleet
+ */
+struct FleetOptions {
+    std::size_t shard_count = 2;
+    std::size_t instance_count = 0; // fleet-wide ids are 0..instance_count-1
+    std::size_t ring_capacity = 65536; // frames per shard
+    // POSIX shm name of a StateBoard sized for every instance; empty for
+    // none
+    std::string board_name;
+    // How long stop() waits for shards before killing them
+    std::chrono::milliseconds stop_timeout{5000};
+};
+
+/**
+ * @brief Runs a fleet of controllers as several forked shard processes
+ *
+ * Instance ids are hash-partitioned over the shards. Each shard is a
+ * child process running shard_main with a ShardContext; it typically
+ * builds its controllers with the usual factories on an Executor and
+ * feeds them with a ShardIngress. The coordinator routes batches of
+ * EventFrames into one shared-memory ring per shard, answers state
+ * queries from a StateBoard every shard publishes into, aggregates shard
+ * counters as metrics, and restarts shards that died. A crashed shard
+ * loses its controllers' state but not the frames still in its ring.
+ *
+ * Shards are forked: start the coordinator before other threads where
+ * possible, and keep shard_main self-contained.
+ */
+class FleetCoordinator {
+  public:
+    using ShardMain = std::function<int(ShardContext &context)>;
+
+  private:
+    FleetOptions options;
+    ShardMain shard_main;
+    std::vector<std::unique_ptr<ShmFrameRing>> rings;
+    void *control_mapping = nullptr;
+    ShardControl *controls = nullptr;
+    std::shared_ptr<StateBoard> board;
+    std::vector<std::vector<uint32_t>> owned; // instance ids per shard
+    std::vector<int> pids;
+    // Read by metrics readers on other threads
+    std::unique_ptr<std::atomic<uint64_t>[]> restarts;
+
+    std::mutex route_mutex; // one producer per ring
+    std::vector<std::vector<EventFrame>> outgoing;
+
+  public:
+    // Creates the rings, counters and board; throws on failure
+    FleetCoordinator(FleetOptions fleet_options, ShardMain main);
+    ~FleetCoordinator();
+
+    FleetCoordinator(const FleetCoordinator &) = delete;
+    FleetCoordinator &operator=(const FleetCoordinator &) = delete;
+
+    // Forks every shard
+    void start();
+
+    /**
+     * @brief Asks shards to stop, then waits for them
+     *
+     * Shards still running after stop_timeout are killed.
+     */
+    void stop();
+
+    /**
+     * @brief Split frames by shard and push each share as one batch
+     * @return Frames accepted; the rest did not fit a full ring or named
+     *         an unknown instance
+     */
+    std::size_t route(const EventFrame *frames, std::size_t count);
+
+    /**
+     * @brief Reap shards that exited and fork replacements
+     * @return Shards restarted
+     */
+    std::size_t restart_failed();
+
+    // Latest state of an instance, false if unknown or never published
+    bool query(uint32_t instance_id, StateBoardEntry &entry) const;
+
+    // Per-shard counters labelled shard="<index>"
+    std::vector<std::size_t> register_metrics(MetricsRegistry &registry,
+                                              const MetricLabels &labels = {});
+
+    std::size_t shard_of(uint32_t instance_id) const;
+    std::size_t get_shard_count() const { return options.shard_count; }
+    const ShardControl &get_control(std::size_t shard) const {
+        return controls[shard];
+    }
+    const ShmFrameRing &get_ring(std::size_t shard) const {
+        return *rings[shard];
+    }
+    int get_pid(std::size_t shard) const { return pids[shard]; }
+    uint64_t get_restarts(std::size_t shard) const {
+        return restarts[shard].load(std::memory_order_relaxed);
+    }
+    std::shared_ptr<const StateBoard> get_board() const { return board; }
+
+  private:
+    void spawn(std::size_t shard);
+};
+
+/**
+ * @brief Shard side: drains the shard's ring into its executor
+ *
+ * Frames carry fleet-wide instance ids; route() maps each id the shard
+ * owns to the executor instance that runs it. Everything drained in one
+ * reactor wakeup is posted as one batch. Handled counts and a heartbeat
+ * are copied to the coordinator every publish_interval, and on_stop runs
+ * on the reactor thread once the coordinator asks the shard to stop.
+ */
+template <typename EventType> class ShardIngress {
+  public:
+    using Target = Executor<EventType>;
+    using Batch = EventBatch<EventType>;
+    using EventDecoder = std::function<bool(uint16_t code, EventType &event)>;
+
+    // Frames drained per wakeup before yielding to other sources
+    static constexpr std::size_t DRAIN_LIMIT = 4096;
+
+  private:
+    ShardContext &context;
+    Target &executor;
+    ReactorDispatcher<EventType> dispatcher;
+    EventDecoder decode;
+    std::function<void()> stop_handler;
+    std::unordered_map<uint32_t, typename Target::InstanceId> routes;
+    std::vector<EventFrame> frames;
+    bool stopping = false;
+
+  public:
+    ShardIngress(ShardContext &shard, Reactor &reactor, Target &target,
+                 EventDecoder decoder = nullptr,
+                 std::chrono::milliseconds publish_interval =
+                     std::chrono::milliseconds(500))
+        : context(shard), executor(target), dispatcher(reactor, target),
+          decode(std::move(decoder)), frames(256) {
+        if (!decode) {
+            decode = [](uint16_t code, EventType &event) {
+                event = static_cast<EventType>(code);
+                return true;
+            };
+        }
+        context.control->pid.store(static_cast<uint64_t>(::getpid()));
+        dispatcher.add_counter(context.ring->get_event_fd(),
+                               [this](uint64_t, Batch &batch) { drain(batch); });
+        dispatcher.add_timer(publish_interval, publish_interval,
+                             [this](uint64_t, Batch &) { publish(); });
+    }
+
+    // Setup only
+    void route(uint32_t instance_id, typename Target::InstanceId local_id) {
+        routes[instance_id] = local_id;
+    }
+
+    void on_stop(std::function<void()> handler) {
+        stop_handler = std::move(handler);
+    }
+
+  private:
+    void drain(Batch &batch) {
+        if (context.stop_requested()) {
+            if (!stopping && stop_handler) {
+                stopping = true;
+                publish();
+                stop_handler();
+            }
+            return;
+        }
+
+        std::size_t drained = 0;
+        std::size_t count;
+        while (drained < DRAIN_LIMIT &&
+               (count = context.ring->pop(frames.data(), frames.size())) > 0) {
+            uint64_t unrouted = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                const EventFrame &frame = frames[i];
+                auto found = routes.find(frame.instance_id);
+                EventType event = EventType();
+                if (found == routes.end() || frame.priority >= PRIORITY_LANES ||
+                    !decode(frame.event, event)) {
+                    ++unrouted;
+                    continue;
+                }
+                batch.add(found->second, event,
+                          static_cast<EventPriority>(frame.priority));
+            }
+            context.control->received.fetch_add(count,
+                                                std::memory_order_relaxed);
+            context.control->unrouted.fetch_add(unrouted,
+                                                std::memory_order_relaxed);
+            drained += count;
+        }
+        // The eventfd is already reset, so come back for the rest
+        if (drained >= DRAIN_LIMIT && context.ring->size() > 0) {
+            context.ring->notify();
+        }
+    }
+
+    void publish() {
+        context.control->handled.store(
+            executor.get_stats()->handled.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+        context.control->heartbeat_ns.store(
+            static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count()),
+            std::memory_order_relaxed);
+    }
+};
+
+template <typename EventType>
+constexpr std::size_t ShardIngress<EventType>::DRAIN_LIMIT;
+
+} // namespace state_machine
@@ -0,0 +1,65 @@
+#pragma once
+#include "ingestion_format.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace state_machine {
+
+/**
+ * @brief Single-producer, single-consumer ring of EventFrames shared
+ *        with a forked child process
+ *
+ * The ring lives in an anonymous shared mapping and comes with an eventfd,
+ * both inherited across fork(), so a parent and a child need no names to
+ * share them. The producer copies frames in and bumps its position, the
+ * consumer copies them out and bumps its own; notify() wakes a consumer
+ * waiting on the eventfd (e.g. through a Reactor). A full ring takes what
+ * fits and counts the rest as dropped.
+ */
+class ShmFrameRing {
+  private:
+    struct Header {
+        alignas(64) std::atomic<uint64_t> head; // next frame to write
+        alignas(64) std::atomic<uint64_t> tail; // next frame to read
+        alignas(64) uint64_t capacity;
+        std::atomic<uint64_t> dropped;
+    };
+
+    void *mapping = nullptr;
+    std::size_t mapping_size = 0;
+    Header *header = nullptr;
+    EventFrame *frames = nullptr;
+    int event_fd = -1;
+
+  public:
+    // Throws if the mapping or the eventfd cannot be created
+    explicit ShmFrameRing(std::size_t capacity);
+    ~ShmFrameRing();
+
+    ShmFrameRing(const ShmFrameRing &) = delete;
+    ShmFrameRing &operator=(const ShmFrameRing &) = delete;
+
+    // Producer only; @return frames written
+    std::size_t push(const EventFrame *source, std::size_t count);
+
+    // Consumer only; @return frames read, at most max_count
+    std::size_t pop(EventFrame *out, std::size_t max_count);
+
+    // Producer: wake the consumer after one or more pushes
+    void notify();
+
+    // Consumer: reset the eventfd; @return notifications since last time
+    uint64_t take_notifications();
+
+    std::size_t size() const;
+    std::size_t get_capacity() const {
+        return static_cast<std::size_t>(header->capacity);
+    }
+    uint64_t get_dropped() const {
+        return header->dropped.load(std::memory_order_relaxed);
+    }
+    int get_event_fd() const { return event_fd; }
+};
+
+} // namespace state_machine
@@ -0,0 +1,218 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Defined by the build (CMake option ENABLE_STD_PMR) for the library and
+// everything linking it, so every translation unit sees the same pmr
+#ifdef STATE_MACHINE_STD_PMR
+#if __cplusplus < 201703L
+#error "STATE_MACHINE_STD_PMR needs C++17"
+#endif
+#include <memory_resource>
+#endif
+
+namespace state_machine {
+
+/**
+ * @brief Polymorphic memory resources, std::pmr where the standard library
+ *        has it
+ *
+ * Built with ENABLE_STD_PMR (C++17) these are the std::pmr names
+ * themselves; otherwise a shim with the same interface stands in, so code
+ * written against state_machine::pmr works in both. The shim covers what the library
+ * needs: memory_resource, new_delete_resource(), the default resource,
+ * polymorphic_allocator and monotonic_buffer_resource. Its
+ * polymorphic_allocator does not pass itself on to the elements it
+ * constructs (no uses-allocator construction), so a std::string inside a
+ * pmr vector still allocates from the global heap.
+ */
+namespace pmr {
+
+#ifdef STATE_MACHINE_STD_PMR
+
+using std::pmr::get_default_resource;
+using std::pmr::memory_resource;
+using std::pmr::monotonic_buffer_resource;
+using std::pmr::new_delete_resource;
+using std::pmr::polymorphic_allocator;
+using std::pmr::set_default_resource;
+
+#else
+
+class memory_resource {
+  public:
+    static constexpr std::size_t max_align = alignof(std::max_align_t);
+
+    virtual ~memory_resource() = default;
+
+    void *allocate(std::size_t bytes, std::size_t alignment = max_align) {
+        return do_allocate(bytes, alignment);
+    }
+
+    void deallocate(void *p, std::size_t bytes,
+                    std::size_t alignment = max_align) {
+        do_deallocate(p, bytes, alignment);
+    }
+
+    bool is_equal(const memory_resource &other) const noexcept {
+        return do_is_equal(other);
+    }
+
+  private:
+    virtual void *do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+    virtual void do_deallocate(void *p, std::size_t bytes,
+                               std::size_t alignment) = 0;
+    virtual bool do_is_equal(const memory_resource &other) const noexcept = 0;
+};
+
+inline bool operator==(const memory_resource &a, const memory_resource &b) {
+    return &a == &b || a.is_equal(b);
+}
+
+inline bool operator!=(const memory_resource &a, const memory_resource &b) {
+    return !(a == b);
+}
+
+// Forwards to ::operator new and ::operator delete
+memory_resource *new_delete_resource() noexcept;
+
+// new_delete_resource() unless set_default_resource() replaced it
+memory_resource *get_default_resource() noexcept;
+
+// Null restores new_delete_resource(); returns the previous default
+memory_resource *set_default_resource(memory_resource *resource) noexcept;
+
+/**
+ * @brief Allocator handing every request to a memory_resource
+ *
+ * Copies share the resource; a container copy goes back to the default
+ * resource, as with std::pmr.
+ */
+template <typename T> class polymorphic_allocator {
+  private:
+    memory_resource *source;
+
+  public:
+    using value_type = T;
+
+    polymorphic_allocator() noexcept : source(get_default_resource()) {}
+
+    polymorphic_allocator(memory_resource *resource) noexcept
+        : source(resource) {}
+
+    template <typename U>
+    polymorphic_allocator(const polymorphic_allocator<U> &other) noexcept
+        : source(other.resource()) {}
+
+    polymorphic_allocator &operator=(const polymorphic_allocator &) = delete;
+    polymorphic_allocator(const polymorphic_allocator &) = default;
+
+    T *allocate(std::size_t n) {
+        if (n > static_cast<std::size_t>(-1) / sizeof(T))
+            throw std::bad_alloc();
+        return static_cast<T *>(source->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) {
+        source->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    polymorphic_allocator select_on_container_copy_construction() const {
+        return polymorphic_allocator();
+    }
+
+    memory_resource *resource() const noexcept { return source; }
+};
+
+template <typename T, typename U>
+bool operator==(const polymorphic_allocator<T> &a,
+                const polymorphic_allocator<U> &b) noexcept {
+    return *a.resource() == *b.resource();
+}
+
+template <typename T, typename U>
+bool operator!=(const polymorphic_allocator<T> &a,
+                const polymorphic_allocator<U> &b) noexcept {
+    return !(a == b);
+}
+
+/**
+ * @brief Bump allocator that frees nothing until release() or destruction
+ *
+ * Takes memory from its upstream resource in chunks, each twice the size
+ * of the last, and ignores deallocate(). Meant for graphs of objects that
+ * die together: build them all in one resource, destroy them, then
+ * release() hands every chunk back at once. Not thread-safe.
+ */
+class monotonic_buffer_resource : public memory_resource {
+  private:
+    struct Chunk {
+        Chunk *next;
+        std::size_t size; // including this header
+    };
+
+    memory_resource *upstream;
+    Chunk *chunks = nullptr;
+    void *initial_buffer = nullptr;
+    std::size_t initial_size = 0;
+    char *current = nullptr;
+    std::size_t remaining = 0;
+    std::size_t first_size; // next_size after construction or release()
+    std::size_t next_size;
+
+  public:
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE = 1024;
+
+    explicit monotonic_buffer_resource(
+        memory_resource *upstream = get_default_resource());
+
+    // First chunk size; later chunks grow from it
+    explicit monotonic_buffer_resource(
+        std::size_t initial_size,
+        memory_resource *upstream = get_default_resource());
+
+    // Serves requests from buffer before going upstream
+    monotonic_buffer_resource(
+        void *buffer, std::size_t buffer_size,
+        memory_resource *upstream = get_default_resource());
+
+    monotonic_buffer_resource(const monotonic_buffer_resource &) = delete;
+    monotonic_buffer_resource &
+    operator=(const monotonic_buffer_resource &) = delete;
+
+    ~monotonic_buffer_resource() override;
+
+    // Returns every chunk upstream and restarts chunk growth; objects still
+    // in them are lost
+    void release();
+
+    memory_resource *upstream_resource() const { return upstream; }
+
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *, std::size_t, std::size_t) override {}
+    bool do_is_equal(const memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+#endif // STATE_MACHINE_STD_PMR
+
+} // namespace pmr
+
+/**
+ * @brief std::allocate_shared from a memory resource
+ *
+ * The object and its control block share one allocation from resource,
+ * which must outlive every copy of the returned pointer.
+ */
+template <typename T, typename... Args>
+std::shared_ptr<T> allocate_shared_in(pmr::memory_resource *resource,
+                                      Args &&...args) {
+    return std::allocate_shared<T>(pmr::polymorphic_allocator<T>(resource),
+                                   std::forward<Args>(args)...);
+}
+
+} // namespace state_machine
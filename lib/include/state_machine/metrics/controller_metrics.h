@@ -0,0 +1,94 @@
+#pragma once
+#include "../core/observable_controller.h"
+#include "../core/transition_hook.h"
+#include "metrics_registry.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Transition hook counting handled events with relaxed atomics
+ */
+template <typename StateType, typename EventType>
+class ControllerMetrics : public ITransitionHook<StateType, EventType> {
+  private:
+    std::atomic<uint64_t> events{0};
+    std::atomic<uint64_t> transitions{0};
+    std::atomic<uint64_t> noop_events{0};
+
+  public:
+    void on_transition(StateType from_state, EventType,
+                       StateType to_state) override {
+        events.fetch_add(1, std::memory_order_relaxed);
+        (from_state != to_state ? transitions : noop_events)
+            .fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t get_event_count() const {
+        return events.load(std::memory_order_relaxed);
+    }
+    uint64_t get_transition_count() const {
+        return transitions.load(std::memory_order_relaxed);
+    }
+    uint64_t get_noop_count() const {
+        return noop_events.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Expose a ControllerMetrics hook through a registry
+ * @return Sample ids, for MetricsRegistry::remove
+ */
+template <typename StateType, typename EventType>
+std::vector<std::size_t> register_controller_metrics(
+    MetricsRegistry &registry,
+    std::shared_ptr<ControllerMetrics<StateType, EventType>> metrics,
+    const MetricLabels &labels) {
+    return {
+        registry.add("state_machine_events_total",
+                     "Events handled by the controller", MetricType::COUNTER,
+                     labels,
+                     [metrics]() {
+                         return static_cast<double>(metrics->get_event_count());
+                     }),
+        registry.add("state_machine_transitions_total",
+                     "Handled events that changed the state",
+                     MetricType::COUNTER, labels,
+                     [metrics]() {
+                         return static_cast<double>(
+                             metrics->get_transition_count());
+                     }),
+        registry.add("state_machine_noop_events_total",
+                     "Handled events that left the state unchanged",
+                     MetricType::COUNTER, labels, [metrics]() {
+                         return static_cast<double>(metrics->get_noop_count());
+                     })};
+}
+
+/**
+ * @brief As above, plus the observers an ObservableController pruned
+ *
+ * The reader points into controller, which must outlive the samples.
+ */
+template <typename StateType, typename EventType>
+std::vector<std::size_t> register_controller_metrics(
+    MetricsRegistry &registry,
+    std::shared_ptr<ControllerMetrics<StateType, EventType>> metrics,
+    const ObservableController<StateType, EventType> &controller,
+    const MetricLabels &labels) {
+    std::vector<std::size_t> ids =
+        register_controller_metrics(registry, std::move(metrics), labels);
+    const auto *observed = &controller;
+    ids.push_back(registry.add(
+        "state_machine_observers_dropped_total",
+        "Observers pruned after their owner released them",
+        MetricType::COUNTER, labels, [observed]() {
+            return static_cast<double>(observed->get_dropped_observer_count());
+        }));
+    return ids;
+}
+
+} // namespace state_machine
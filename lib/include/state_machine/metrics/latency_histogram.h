@@ -0,0 +1,181 @@
+#pragma once
+#include "../memory/memory_resource.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace state_machine {
+
+/**
+ * @brief Percentiles of one latency histogram, in nanoseconds
+ */
+struct LatencySnapshot {
+    uint64_t count = 0;
+    double mean_ns = 0.0;
+    uint64_t p50_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+/**
+ * @brief Log-bucketed latency histogram with per-thread shards
+ *
+ * Values below 16ns get exact buckets; above that every power of two is
+ * split into 16 sub-buckets, so a recorded value is off by at most 1/16.
+ * Each recording thread is pinned to one of SHARDS shards and only does
+ * relaxed, uncontended increments; snapshot() merges the shards. The
+ * shards take about 77 KB and are allocated by the first record(), so a
+ * histogram nothing records into costs a pointer. They come from the
+ * memory resource given at construction, on the recording thread, so a
+ * resource that is not thread-safe must not be in use elsewhere then.
+ */
+class LatencyHistogram {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr std::size_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr unsigned MAX_EXPONENT = 39; // ~550s, larger values clamp
+    static constexpr std::size_t BUCKET_COUNT =
+        (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+    static constexpr std::size_t SHARDS = 16;
+
+  private:
+    struct Shard {
+        std::atomic<uint64_t> buckets[BUCKET_COUNT];
+        std::atomic<uint64_t> total_ns;
+        std::atomic<uint64_t> max_ns;
+        char padding[64]; // keeps neighbouring shards off one cache line
+    };
+
+    pmr::memory_resource *resource;
+    std::atomic<Shard *> shards{nullptr};
+
+  public:
+    explicit LatencyHistogram(
+        pmr::memory_resource *source = pmr::get_default_resource())
+        : resource(source) {}
+    ~LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    void record(uint64_t ns) {
+        Shard *all = shards.load(std::memory_order_acquire);
+        if (!all) {
+            all = allocate_shards();
+        }
+        Shard &shard = all[shard_index()];
+        shard.buckets[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+        shard.total_ns.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t seen = shard.max_ns.load(std::memory_order_relaxed);
+        while (ns > seen && !shard.max_ns.compare_exchange_weak(
+                                seen, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    void record(clock::duration elapsed) {
+        auto ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                .count();
+        record(static_cast<uint64_t>(ns < 0 ? 0 : ns));
+    }
+
+    // Merges all shards; safe to call while other threads record
+    LatencySnapshot snapshot() const;
+
+    void reset();
+
+    static std::size_t bucket_of(uint64_t ns) {
+        if (ns < SUB_BUCKETS)
+            return static_cast<std::size_t>(ns);
+        unsigned exponent = 63 - __builtin_clzll(ns);
+        if (exponent > MAX_EXPONENT)
+            return BUCKET_COUNT - 1;
+        return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS +
+               ((ns >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    }
+
+    // Highest value that maps to bucket
+    static uint64_t bucket_upper_bound(std::size_t bucket);
+
+  private:
+    // Installs the shards; a thread losing the race uses the winner's
+    Shard *allocate_shards();
+
+    static std::size_t shard_index() {
+        static std::atomic<std::size_t> next_shard{0};
+        static thread_local std::size_t index =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return index;
+    }
+};
+
+/**
+ * @brief Per-phase snapshot of one controller's handle_event
+ */
+struct ControllerLatencySnapshot {
+    LatencySnapshot lookup;   // state_machine->process_event
+    LatencySnapshot handler;  // IActionHandler::handle (BaseController)
+    LatencySnapshot dispatch; // observer notification (ObservableController)
+};
+
+/**
+ * @brief Histograms for the phases of a controller's handle_event
+ * Up to about 231 KB once all three record; factories share one per
+ * controller type through share_latency().
+ */
+struct ControllerLatency {
+    LatencyHistogram lookup;
+    LatencyHistogram handler;
+    LatencyHistogram dispatch;
+
+    explicit ControllerLatency(
+        pmr::memory_resource *resource = pmr::get_default_resource())
+        : lookup(resource), handler(resource), dispatch(resource) {}
+
+    ControllerLatencySnapshot snapshot() const {
+        return {lookup.snapshot(), handler.snapshot(), dispatch.snapshot()};
+    }
+
+    void reset() {
+        lookup.reset();
+        handler.reset();
+        dispatch.reset();
+    }
+};
+
+/**
+ * @brief Records the lifetime of the scope into a histogram
+ */
+class LatencyScope {
+  private:
+    LatencyHistogram &histogram;
+    LatencyHistogram::clock::time_point started;
+
+  public:
+    explicit LatencyScope(LatencyHistogram &target)
+        : histogram(target), started(LatencyHistogram::clock::now()) {}
+
+    ~LatencyScope() {
+        histogram.record(LatencyHistogram::clock::now() - started);
+    }
+
+    LatencyScope(const LatencyScope &) = delete;
+    LatencyScope &operator=(const LatencyScope &) = delete;
+};
+
+} // namespace state_machine
+
+// Controllers time their phases only when built with
+// STATE_MACHINE_LATENCY_HISTOGRAMS (CMake option ENABLE_LATENCY_HISTOGRAMS);
+// otherwise the macro expands to nothing and costs nothing.
+#ifdef STATE_MACHINE_LATENCY_HISTOGRAMS
+#define STATE_MACHINE_LATENCY_SCOPE(histogram)                                 \
+    ::state_machine::LatencyScope latency_scope(histogram)
+#else
+#define STATE_MACHINE_LATENCY_SCOPE(histogram)
+#endif
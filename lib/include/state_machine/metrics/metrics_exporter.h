@@ -0,0 +1,50 @@
+#pragma once
+#include "metrics_registry.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace state_machine {
+
+/**
+ * @brief Serves a MetricsRegistry in Prometheus text format on a Unix socket
+ *
+ * Every connection gets one rendering of the registry. Clients that send
+ * an HTTP request (e.g. curl --unix-socket) get an HTTP/1.0 response,
+ * anything else (e.g. socat) gets the bare text. Scrapes run on the
+ * exporter's own thread.
+ */
+class MetricsExporter {
+  private:
+    std::shared_ptr<MetricsRegistry> registry;
+    std::string socket_path;
+    int listen_fd = -1;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> scrapes{0};
+    std::thread server_thread;
+
+  public:
+    MetricsExporter(std::shared_ptr<MetricsRegistry> metrics_registry,
+                    std::string path);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter &) = delete;
+    MetricsExporter &operator=(const MetricsExporter &) = delete;
+
+    // Binds the socket (replacing a stale one) and starts serving
+    void start();
+    void stop();
+
+    const std::string &get_socket_path() const { return socket_path; }
+    uint64_t get_scrape_count() const {
+        return scrapes.load(std::memory_order_relaxed);
+    }
+
+  private:
+    void serve_loop();
+    void serve_client(int client_fd);
+};
+
+} // namespace state_machine
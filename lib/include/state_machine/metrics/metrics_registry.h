@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace state_machine {
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+enum class MetricType { COUNTER, GAUGE };
+
+/**
+ * @brief Pull-based registry of named metrics backed by reader callbacks
+ *
+ * Readers are called only while rendering and should just load relaxed
+ * atomics, so a scrape never blocks the code that updates them. The
+ * internal mutex only orders rendering against (un)registration.
+ */
+class MetricsRegistry {
+  public:
+    using Reader = std::function<double()>;
+
+  private:
+    struct Sample {
+        std::size_t id;
+        MetricLabels labels;
+        Reader reader;
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        MetricType type;
+        std::vector<Sample> samples;
+    };
+
+    mutable std::mutex mutex;
+    std::vector<Family> families;
+    std::size_t next_id = 1;
+
+  public:
+    /**
+     * @brief Register one sample of a metric family
+     * @return Id for remove(); throws std::runtime_error on a bad name or
+     *         a type that conflicts with an existing family
+     */
+    std::size_t add(const std::string &name, const std::string &help,
+                    MetricType type, MetricLabels labels, Reader reader);
+
+    void remove(std::size_t id);
+
+    void remove(const std::vector<std::size_t> &ids) {
+        for (std::size_t id : ids) {
+            remove(id);
+        }
+    }
+
+    // Prometheus text exposition format, version 0.0.4
+    void render(std::ostream &os) const;
+    std::string render() const;
+};
+
+} // namespace state_machine
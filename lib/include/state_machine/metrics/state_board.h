@@ -0,0 +1,144 @@
+#pragma once
+#include "../core/transition_hook.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Consistent copy of one state board slot
+ */
+struct StateBoardEntry {
+    std::size_t slot;
+    uint32_t owner_pid;
+    uint32_t state;
+    uint64_t transitions;
+    uint64_t updated_ns; // steady clock of the last publish
+    char name[24];
+};
+
+/**
+ * @brief Per-instance current state in a POSIX shared-memory segment
+ *
+ * The segment is a fixed header followed by one cache-line slot per
+ * instance. Writers claim a slot, then publish the state and transition
+ * count under a per-slot seqlock; monitors in other processes open the
+ * segment read-only and poll slots without any system calls. Each slot
+ * must have a single writer at a time.
+ */
+class StateBoard {
+  public:
+    static constexpr uint64_t MAGIC = 0x314452414f424d53ULL; // "SMBOARD1"
+    static constexpr uint32_t VERSION = 1;
+
+  private:
+    struct Header {
+        std::atomic<uint64_t> magic; // stored last by the creator
+        uint32_t version;
+        uint32_t slot_count;
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> owner; // pid, 0 while the slot is free
+        std::atomic<uint64_t> sequence; // odd while a publish is in flight
+        std::atomic<uint64_t> state;
+        std::atomic<uint64_t> transitions;
+        std::atomic<uint64_t> updated_ns;
+        std::atomic<uint64_t> name[3];
+    };
+
+    std::string segment_name;
+    void *mapping = nullptr;
+    std::size_t mapping_size = 0;
+    Header *header = nullptr;
+    Slot *slots = nullptr;
+    bool owner = false;
+    bool writable = false;
+
+    StateBoard(const std::string &name, bool create, bool writable,
+               std::size_t slot_count);
+
+  public:
+    /**
+     * @brief Create the segment, replacing a stale one of the same name
+     *
+     * The creating board unlinks the segment when destroyed.
+     * @param name POSIX shm name, e.g. "/traffic_light_board"
+     */
+    static std::unique_ptr<StateBoard> create(const std::string &name,
+                                              std::size_t slot_count);
+
+    /**
+     * @brief Attach to an existing segment
+     * @param writable Map read-write so this process can claim slots too
+     */
+    static std::unique_ptr<StateBoard> open(const std::string &name,
+                                            bool writable = false);
+
+    ~StateBoard();
+
+    StateBoard(const StateBoard &) = delete;
+    StateBoard &operator=(const StateBoard &) = delete;
+
+    /**
+     * @brief Reserve a free slot for an instance
+     * @param first_slot Where the search starts, so that an instance with a
+     *        stable index can land on the slot of that index
+     * @return Slot index for publish and release_slot
+     */
+    std::size_t claim_slot(const std::string &instance_name,
+                           std::size_t first_slot = 0);
+    void release_slot(std::size_t slot);
+
+    void publish(std::size_t slot, uint32_t state, uint64_t transitions);
+
+    // false if the slot is free
+    bool read(std::size_t slot, StateBoardEntry &entry) const;
+
+    // All claimed slots, in slot order
+    std::vector<StateBoardEntry> snapshot() const;
+
+    std::size_t get_slot_count() const { return header->slot_count; }
+    const std::string &get_name() const { return segment_name; }
+};
+
+/**
+ * @brief Transition hook publishing a controller's state to a StateBoard
+ *
+ * Claims a slot on construction and frees it on destruction. The state is
+ * stored as its underlying integer value and republished on every
+ * transition, along with the number of transitions so far.
+ */
+template <typename StateType, typename EventType>
+class StateBoardPublisher : public ITransitionHook<StateType, EventType> {
+  private:
+    std::shared_ptr<StateBoard> board;
+    std::size_t slot;
+    uint64_t transitions = 0;
+
+  public:
+    StateBoardPublisher(std::shared_ptr<StateBoard> state_board,
+                        const std::string &instance_name,
+                        StateType initial_state, std::size_t first_slot = 0)
+        : board(std::move(state_board)),
+          slot(board->claim_slot(instance_name, first_slot)) {
+        board->publish(slot, static_cast<uint32_t>(initial_state), 0);
+    }
+
+    ~StateBoardPublisher() override { board->release_slot(slot); }
+
+    void on_transition(StateType from_state, EventType,
+                       StateType to_state) override {
+        if (from_state == to_state)
+            return;
+        board->publish(slot, static_cast<uint32_t>(to_state), ++transitions);
+    }
+
+    std::size_t get_slot() const { return slot; }
+};
+
+} // namespace state_machine
@@ -0,0 +1,163 @@
+#pragma once
+#include "../core/state_transition.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Hit counts of one [from][event] cell of a TransitionCounters matrix
+ */
+struct EdgeCount {
+    std::size_t from_state;
+    std::size_t event;
+    bool declared;       // the definition has a transition for this cell
+    uint64_t taken;      // events that changed the state
+    uint64_t no_change;  // events that left the state as it was
+    uint64_t guard_passed;
+    uint64_t guard_failed;
+
+    uint64_t total() const { return taken + no_change; }
+};
+
+/**
+ * @brief Per-edge hit counters for one machine definition
+ *
+ * Indexed by [from state][event] through static_cast<std::size_t>, so both
+ * enums should be dense and start at zero; values outside the matrix are
+ * counted in get_out_of_range(). One instance is meant to be shared by
+ * every RuntimeStateMachine built from the same definition. Counters are
+ * relaxed atomics, cheap enough to leave on in production.
+ */
+template <typename StateType, typename EventType> class TransitionCounters {
+  private:
+    struct Cell {
+        std::atomic<uint64_t> taken;
+        std::atomic<uint64_t> no_change;
+        std::atomic<uint64_t> guard_passed;
+        std::atomic<uint64_t> guard_failed;
+        std::atomic<bool> declared;
+    };
+
+    std::size_t state_count;
+    std::size_t event_count;
+    std::unique_ptr<Cell[]> cells;
+    std::atomic<uint64_t> out_of_range{0};
+
+  public:
+    TransitionCounters(std::size_t states, std::size_t events)
+        : state_count(states), event_count(events),
+          cells(new Cell[states * events]()) {}
+
+    TransitionCounters(const TransitionCounters &) = delete;
+    TransitionCounters &operator=(const TransitionCounters &) = delete;
+
+    std::size_t get_state_count() const { return state_count; }
+    std::size_t get_event_count() const { return event_count; }
+
+    // Marks a cell as backed by a transition of the definition
+    void declare(StateType from, EventType event) {
+        if (Cell *cell = cell_for(from, event)) {
+            cell->declared.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    void record(StateType from, EventType event, bool state_changed,
+                GuardOutcome guard) {
+        Cell *cell = cell_for(from, event);
+        if (!cell) {
+            out_of_range.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        (state_changed ? cell->taken : cell->no_change)
+            .fetch_add(1, std::memory_order_relaxed);
+        if (guard == GuardOutcome::PASSED) {
+            cell->guard_passed.fetch_add(1, std::memory_order_relaxed);
+        } else if (guard == GuardOutcome::FAILED) {
+            cell->guard_failed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t get_out_of_range() const {
+        return out_of_range.load(std::memory_order_relaxed);
+    }
+
+    // Every cell, row-major by from state
+    std::vector<EdgeCount> snapshot() const {
+        std::vector<EdgeCount> edges;
+        edges.reserve(state_count * event_count);
+        for (std::size_t from = 0; from < state_count; ++from) {
+            for (std::size_t event = 0; event < event_count; ++event) {
+                const Cell &cell = cells[from * event_count + event];
+                edges.push_back(
+                    {from, event, cell.declared.load(std::memory_order_relaxed),
+                     cell.taken.load(std::memory_order_relaxed),
+                     cell.no_change.load(std::memory_order_relaxed),
+                     cell.guard_passed.load(std::memory_order_relaxed),
+                     cell.guard_failed.load(std::memory_order_relaxed)});
+            }
+        }
+        return edges;
+    }
+
+    void reset() {
+        for (std::size_t i = 0; i < state_count * event_count; ++i) {
+            cells[i].taken.store(0, std::memory_order_relaxed);
+            cells[i].no_change.store(0, std::memory_order_relaxed);
+            cells[i].guard_passed.store(0, std::memory_order_relaxed);
+            cells[i].guard_failed.store(0, std::memory_order_relaxed);
+        }
+        out_of_range.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Writes the matrix as CSV, hottest edges first
+     *
+     * Cells that were never hit and have no transition are skipped.
+     * Declared cells that were never hit are flagged as dead.
+     */
+    void dump(std::ostream &os,
+              const std::function<std::string(StateType)> &state_name,
+              const std::function<std::string(EventType)> &event_name) const {
+        std::vector<EdgeCount> edges = snapshot();
+        std::stable_sort(edges.begin(), edges.end(),
+                         [](const EdgeCount &a, const EdgeCount &b) {
+                             return a.total() > b.total();
+                         });
+
+        os << "from,event,taken,no_change,guard_passed,guard_failed,status\n";
+        for (const auto &edge : edges) {
+            if (!edge.declared && edge.total() == 0)
+                continue;
+            const char *status = !edge.declared      ? "undeclared"
+                                 : edge.total() == 0 ? "dead"
+                                                     : "live";
+            os << state_name(static_cast<StateType>(edge.from_state)) << ","
+               << event_name(static_cast<EventType>(edge.event)) << ","
+               << edge.taken << "," << edge.no_change << ","
+               << edge.guard_passed << "," << edge.guard_failed << ","
+               << status << "\n";
+        }
+        if (get_out_of_range() > 0) {
+            os << "# out of range: " << get_out_of_range() << "\n";
+        }
+    }
+
+  private:
+    Cell *cell_for(StateType from, EventType event) const {
+        auto from_index = static_cast<std::size_t>(from);
+        auto event_index = static_cast<std::size_t>(event);
+        if (from_index >= state_count || event_index >= event_count)
+            return nullptr;
+        return &cells[from_index * event_count + event_index];
+    }
+};
+
+} // namespace state_machine
@@ -0,0 +1,119 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Fixed-size binary record describing one event applied to a machine
+ */
+struct JournalRecord {
+    uint64_t timestamp_ns; // system_clock nanoseconds since epoch
+    uint32_t instance_id;
+    uint16_t event;
+    uint16_t from_state;
+    uint16_t to_state;
+    uint16_t marker;   // JOURNAL_RECORD_MARKER once written
+    uint32_t checksum; // covers every field above
+
+    static constexpr uint16_t JOURNAL_RECORD_MARKER = 0x4A52; // "JR"
+};
+
+static_assert(sizeof(JournalRecord) == 24, "JournalRecord must stay packed");
+
+/**
+ * @brief Tuning knobs for segment size and group commit
+ */
+struct JournalOptions {
+    std::size_t segment_size = 64 * 1024 * 1024; // preallocated bytes
+    std::size_t group_commit_events = 256;       // commit after N events
+    std::chrono::microseconds group_commit_budget{2000}; // or after this long
+};
+
+/**
+ * @brief Append-only write-ahead journal with group commit
+ *
+ * append() only copies the record into memory; a background committer writes
+ * batches into preallocated segment files and issues one fdatasync() per
+ * batch, so the caller never waits for the disk.
+ */
+class EventJournal {
+  private:
+    std::string directory;
+    JournalOptions options;
+
+    // Records waiting for the committer (guarded by mutex)
+    std::mutex mutex;
+    std::condition_variable commit_cv;
+    std::condition_variable durable_cv;
+    std::vector<JournalRecord> pending;
+    std::chrono::steady_clock::time_point first_pending_time;
+    uint64_t appended_count = 0;
+    uint64_t durable_count = 0;
+    bool flush_requested = false;
+    bool stopping = false;
+    std::exception_ptr failure; // set when the committer hits an I/O error
+
+    // Owned by the committer thread
+    std::vector<JournalRecord> writing;
+    int segment_fd = -1;
+    uint64_t segment_index = 0;
+    std::size_t segment_offset = 0;
+
+    std::thread committer;
+
+  public:
+    explicit EventJournal(const std::string &journal_directory,
+                          const JournalOptions &journal_options = {});
+    ~EventJournal();
+
+    EventJournal(const EventJournal &) = delete;
+    EventJournal &operator=(const EventJournal &) = delete;
+
+    void append(uint32_t instance_id, uint16_t event, uint16_t from_state,
+                uint16_t to_state);
+
+    // Block until everything appended so far is on disk. append() and
+    // flush() rethrow the committer's I/O error once one has occurred.
+    void flush();
+
+    uint64_t get_appended_count();
+    uint64_t get_durable_count();
+
+  private:
+    void committer_loop();
+    void write_batch(const std::vector<JournalRecord> &batch);
+    void open_next_segment();
+    void close_segment();
+};
+
+/**
+ * @brief Sequential reader over all segments of a journal directory
+ */
+class EventJournalReader {
+  private:
+    std::vector<std::string> segment_paths;
+
+  public:
+    explicit EventJournalReader(const std::string &journal_directory);
+
+    const std::vector<std::string> &get_segments() const {
+        return segment_paths;
+    }
+
+    // Visits valid records in append order, returns how many were visited
+    std::size_t
+    for_each(const std::function<void(const JournalRecord &)> &visitor) const;
+};
+
+uint32_t journal_checksum(const JournalRecord &record);
+
+} // namespace state_machine
@@ -0,0 +1,102 @@
+#pragma once
+#include "../core/action_handler.h"
+#include "../core/state_machine.h"
+#include "../core/subject.h"
+#include "event_journal.h"
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace state_machine {
+
+/**
+ * @brief Observer that appends every notified event to an EventJournal
+ */
+template <typename StateType, typename EventType>
+class JournalObserver : public IObserver<StateType, EventType> {
+  private:
+    std::shared_ptr<EventJournal> journal;
+    uint32_t instance_id;
+
+  public:
+    JournalObserver(std::shared_ptr<EventJournal> event_journal, uint32_t id)
+        : journal(std::move(event_journal)), instance_id(id) {}
+
+    void on_state_transition(StateType from_state, EventType event,
+                             StateType to_state) override {
+        journal->append(instance_id, static_cast<uint16_t>(event),
+                        static_cast<uint16_t>(from_state),
+                        static_cast<uint16_t>(to_state));
+    }
+};
+
+/**
+ * @brief Action handler decorator journaling events for BaseController users
+ */
+template <typename StateType, typename EventType>
+class JournalActionHandler : public IActionHandler<StateType, EventType> {
+  private:
+    std::shared_ptr<IActionHandler<StateType, EventType>> inner;
+    std::shared_ptr<EventJournal> journal;
+    uint32_t instance_id;
+
+  public:
+    JournalActionHandler(
+        std::shared_ptr<IActionHandler<StateType, EventType>> handler,
+        std::shared_ptr<EventJournal> event_journal, uint32_t id)
+        : inner(std::move(handler)), journal(std::move(event_journal)),
+          instance_id(id) {}
+
+    void handle(StateType current_state, EventType event,
+                StateType next_state) override {
+        journal->append(instance_id, static_cast<uint16_t>(event),
+                        static_cast<uint16_t>(current_state),
+                        static_cast<uint16_t>(next_state));
+        if (inner) {
+            inner->handle(current_state, event, next_state);
+        }
+    }
+};
+
+/**
+ * @brief Rebuild machine states by streaming a journal through the engine
+ *
+ * Fleet is any associative container mapping instance ids to (smart)
+ * pointers of IStateMachine, e.g. std::map<uint32_t,
+ * std::shared_ptr<IStateMachine<S, E>>>. Each record is re-applied with
+ * process_event(); when guards now evaluate differently than when the
+ * record was written, the journaled state wins.
+ *
+ * @return Number of records applied to a machine of the fleet
+ */
+template <typename Fleet>
+std::size_t replay(const EventJournalReader &journal, Fleet &fleet) {
+    using Machine = typename std::remove_reference<decltype(
+        *std::declval<typename Fleet::mapped_type>())>::type;
+    using StateType = typename Machine::state_type;
+    using EventType = typename Machine::event_type;
+
+    std::size_t applied = 0;
+    journal.for_each([&fleet, &applied](const JournalRecord &record) {
+        auto it = fleet.find(record.instance_id);
+        if (it == fleet.end() || !it->second)
+            return;
+
+        auto &machine = *it->second;
+        auto from_state = static_cast<StateType>(record.from_state);
+        auto to_state = static_cast<StateType>(record.to_state);
+
+        if (machine.get_current_state() != from_state) {
+            machine.set_state(from_state);
+        }
+        machine.process_event(static_cast<EventType>(record.event));
+        if (machine.get_current_state() != to_state) {
+            machine.set_state(to_state);
+        }
+        ++applied;
+    });
+    return applied;
+}
+
+} // namespace state_machine
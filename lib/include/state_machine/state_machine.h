@@ -7,17 +7,72 @@
 #include "core/state_machine.h"
 #include "core/state_transition.h"
 #include "core/subject.h"
+#include "core/transition_hook.h"
+
+// Concurrency
+#include "concurrency/bounded_queue.h"
+#include "concurrency/mpsc_queue.h"
+#include "concurrency/seqlock_slot.h"
+
+// Execution
+#include "execution/coalescing_rules.h"
+#include "execution/event_priority.h"
+#include "execution/event_source.h"
+#include "execution/executor.h"
+#include "execution/executor_stats.h"
+#include "execution/mailbox.h"
+#include "execution/reactor.h"
+#include "execution/reactor_dispatcher.h"
+#include "execution/timer_queue.h"
+#include "execution/work_stealing_scheduler.h"
+
+// IPC
+#include "ipc/ingestion_format.h"
+#include "ipc/ingestion_server.h"
+#include "ipc/ingestion_socket.h"
+#include "ipc/shard_fleet.h"
+#include "ipc/shm_frame_ring.h"
 
 // Implementations
+#include "implementations/concurrent_state_machine.h"
 #include "implementations/conditional_state_transition.h"
+#include "implementations/definition_loader.h"
+#include "implementations/machine_definition.h"
 #include "implementations/runtime_state_machine.h"
 #include "implementations/simple_state_transition.h"
+#include "implementations/state_context_table.h"
+#include "implementations/versioned_state_machine.h"
+
+// Memory
+#include "memory/memory_resource.h"
+
+// Metrics
+#include "metrics/controller_metrics.h"
+#include "metrics/latency_histogram.h"
+#include "metrics/metrics_exporter.h"
+#include "metrics/metrics_registry.h"
+#include "metrics/state_board.h"
+#include "metrics/transition_counters.h"
 
 // Services
 #include "services/display_service.h"
 #include "services/function_timer_service.h"
 #include "services/timer_service.h"
 
+// Persistence
+#include "persistence/event_journal.h"
+#include "persistence/journal_replay.h"
+
+// Tracing
+#include "tracing/columnar_trace.h"
+#include "tracing/flight_recorder.h"
+#include "tracing/mapped_trace.h"
+#include "tracing/trace_format.h"
+#include "tracing/trace_observer.h"
+#include "tracing/trace_query.h"
+#include "tracing/trace_reader.h"
+#include "tracing/trace_writer.h"
+
 namespace state_machine {
 // Convenience aliases
 template <typename StateType, typename EventType>
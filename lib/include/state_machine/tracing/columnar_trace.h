@@ -0,0 +1,118 @@
+#pragma once
+#include "trace_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Block index entry of a columnar trace file
+ */
+struct ColumnarBlockInfo {
+    uint64_t offset; // file offset of the encoded block
+    uint64_t first_ticks;
+    uint64_t last_ticks;
+    uint32_t record_count;
+    uint32_t byte_size;
+};
+
+/**
+ * @brief Writes TraceRecords as compressed columnar blocks
+ *
+ * Each block stores instance ids, from states, events and to states as
+ * separate columns, every one run-length encoded or bit-packed (whichever
+ * is smaller), plus zigzag varint timestamp deltas. A block index at the
+ * end of the file lets readers skip blocks outside a time range.
+ */
+class ColumnarTraceWriter {
+  private:
+    int fd = -1;
+    std::string filename;
+    std::size_t block_records;
+    uint64_t file_offset = 0;
+    std::vector<TraceRecord> block;
+    std::vector<ColumnarBlockInfo> index;
+    std::vector<uint8_t> encoded;
+
+  public:
+    static constexpr std::size_t DEFAULT_BLOCK_RECORDS = 65536;
+
+    ColumnarTraceWriter(const std::string &columnar_filename,
+                        const TraceFileHeader &source_header,
+                        std::size_t records_per_block = DEFAULT_BLOCK_RECORDS);
+    ~ColumnarTraceWriter();
+
+    ColumnarTraceWriter(const ColumnarTraceWriter &) = delete;
+    ColumnarTraceWriter &operator=(const ColumnarTraceWriter &) = delete;
+
+    void append(const TraceRecord &record) {
+        block.push_back(record);
+        if (block.size() == block_records) {
+            write_block();
+        }
+    }
+
+    // Writes the pending block and the block index; called by the destructor
+    void finish();
+
+    uint64_t get_bytes_written() const { return file_offset; }
+
+  private:
+    void write_block();
+    void write_bytes(const void *data, std::size_t size);
+};
+
+/**
+ * @brief Reads columnar trace files, skipping blocks by time range
+ */
+class ColumnarTraceReader {
+  private:
+    int fd = -1;
+    std::string filename;
+    TraceFileHeader header;
+    std::vector<ColumnarBlockInfo> index;
+
+  public:
+    explicit ColumnarTraceReader(const std::string &columnar_filename);
+    ~ColumnarTraceReader();
+
+    ColumnarTraceReader(const ColumnarTraceReader &) = delete;
+    ColumnarTraceReader &operator=(const ColumnarTraceReader &) = delete;
+
+    const TraceFileHeader &get_header() const { return header; }
+    const std::vector<ColumnarBlockInfo> &get_blocks() const { return index; }
+
+    uint64_t get_record_count() const;
+
+    // Visits records with min_ticks <= ticks <= max_ticks, decoding only the
+    // blocks that overlap the range. Returns the number of records visited.
+    std::size_t
+    scan(uint64_t min_ticks, uint64_t max_ticks,
+         const std::function<void(const TraceRecord &)> &visitor) const;
+
+    std::size_t
+    scan_all(const std::function<void(const TraceRecord &)> &visitor) const {
+        return scan(0, UINT64_MAX, visitor);
+    }
+
+    void decode_block(const ColumnarBlockInfo &info,
+                      std::vector<TraceRecord> &records) const;
+};
+
+/**
+ * @brief True if the file starts with the columnar trace magic
+ */
+bool is_columnar_trace(const std::string &filename);
+
+/**
+ * @brief Stream-convert a TraceWriter file into a columnar trace file
+ * @return Number of records converted
+ */
+std::size_t convert_trace_to_columnar(
+    const std::string &trace_filename, const std::string &columnar_filename,
+    std::size_t records_per_block = ColumnarTraceWriter::DEFAULT_BLOCK_RECORDS);
+
+} // namespace state_machine
@@ -0,0 +1,156 @@
+#pragma once
+#include "../core/transition_hook.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief One transition kept by a flight recorder
+ */
+struct FlightRecord {
+    uint64_t sequence; // 0-based position in the stream of recorded events
+    uint64_t timestamp_ns; // steady clock
+    uint16_t from_state;
+    uint16_t event;
+    uint16_t to_state;
+};
+
+/**
+ * @brief Fixed-size, single-writer ring of the most recent transitions
+ *
+ * record() does three relaxed stores and one release store and never
+ * allocates. Readers (snapshot, dump, a fatal-signal handler) may run
+ * concurrently and skip slots that are being overwritten. Rings created
+ * with crash_dump set are written out by the fatal-signal handler.
+ */
+class FlightRing {
+  private:
+    struct Slot {
+        // 2 * (sequence + 1) once written; odd while a write is in flight
+        std::atomic<uint64_t> version;
+        std::atomic<uint64_t> timestamp_ns;
+        std::atomic<uint64_t> transition; // from | event << 16 | to << 32
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t mask;
+    std::atomic<uint64_t> head{0};
+    char name[32];
+    bool crash_dump;
+
+  public:
+    // capacity is rounded up to a power of two
+    FlightRing(std::size_t capacity, const std::string &ring_name,
+               bool crash_dump = true);
+    ~FlightRing();
+
+    FlightRing(const FlightRing &) = delete;
+    FlightRing &operator=(const FlightRing &) = delete;
+
+    void record(uint16_t from_state, uint16_t event, uint16_t to_state) {
+        uint64_t sequence = head.load(std::memory_order_relaxed);
+        Slot &slot = slots[sequence & mask];
+        slot.version.store(2 * sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.timestamp_ns.store(now_ns(), std::memory_order_relaxed);
+        slot.transition.store(uint64_t(from_state) | uint64_t(event) << 16 |
+                                  uint64_t(to_state) << 32,
+                              std::memory_order_relaxed);
+        slot.version.store(2 * sequence + 2, std::memory_order_release);
+        head.store(sequence + 1, std::memory_order_release);
+    }
+
+    std::size_t get_capacity() const { return mask + 1; }
+    uint64_t get_recorded_count() const {
+        return head.load(std::memory_order_acquire);
+    }
+    const char *get_name() const { return name; }
+
+    // Oldest first; allocates, so not for signal handlers
+    std::vector<FlightRecord> snapshot() const;
+
+    // Async-signal-safe: formats on the stack and writes with write(2)
+    void dump(int fd) const;
+
+  private:
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+    // Copies a slot if it is stable and still holds sequence
+    bool read_slot(uint64_t sequence, FlightRecord &record) const;
+};
+
+/**
+ * @brief Dump every crash-dump ring to fd (async-signal-safe)
+ */
+void dump_all_flight_recorders(int fd);
+
+/**
+ * @brief Install handlers that dump all rings on SIGSEGV, SIGBUS, SIGFPE,
+ *        SIGILL and SIGABRT, then re-raise with the default action
+ */
+void install_flight_recorder_signal_handlers(int fd = 2);
+
+/**
+ * @brief Transition hook recording into a FlightRing
+ *
+ * States and events are stored as their underlying integer values.
+ */
+template <typename StateType, typename EventType>
+class FlightRecorder : public ITransitionHook<StateType, EventType> {
+  private:
+    FlightRing ring;
+
+  public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 256;
+
+    explicit FlightRecorder(const std::string &name,
+                            std::size_t capacity = DEFAULT_CAPACITY,
+                            bool crash_dump = true)
+        : ring(capacity, name, crash_dump) {}
+
+    void on_transition(StateType from_state, EventType event,
+                       StateType to_state) override {
+        ring.record(static_cast<uint16_t>(from_state),
+                    static_cast<uint16_t>(event),
+                    static_cast<uint16_t>(to_state));
+    }
+
+    const FlightRing &get_ring() const { return ring; }
+
+    void dump(int fd) const { ring.dump(fd); }
+
+    // On-demand dump with symbolic names
+    void dump(std::ostream &os,
+              const std::function<std::string(StateType)> &state_name,
+              const std::function<std::string(EventType)> &event_name) const {
+        std::vector<FlightRecord> records = ring.snapshot();
+        os << "flight recorder " << ring.get_name() << ": last "
+           << records.size() << " of " << ring.get_recorded_count()
+           << " transitions\n";
+        for (const auto &record : records) {
+            os << "  #" << record.sequence << " t=" << record.timestamp_ns
+               << "ns " << state_name(static_cast<StateType>(record.from_state))
+               << " --[" << event_name(static_cast<EventType>(record.event))
+               << "]--> " << state_name(static_cast<StateType>(record.to_state))
+               << "\n";
+        }
+    }
+};
+
+template <typename StateType, typename EventType>
+constexpr std::size_t FlightRecorder<StateType, EventType>::DEFAULT_CAPACITY;
+
+} // namespace state_machine
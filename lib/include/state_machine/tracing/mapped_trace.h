@@ -0,0 +1,41 @@
+#pragma once
+#include "trace_format.h"
+#include <cstddef>
+#include <string>
+
+namespace state_machine {
+
+/**
+ * @brief Read-only mmap() view of a binary trace file
+ */
+class MappedTrace {
+  private:
+    std::string filename;
+    void *mapping = nullptr;
+    std::size_t mapping_size = 0;
+    const TraceRecord *records = nullptr;
+    std::size_t record_count = 0;
+
+  public:
+    explicit MappedTrace(const std::string &trace_filename);
+    ~MappedTrace();
+
+    MappedTrace(const MappedTrace &) = delete;
+    MappedTrace &operator=(const MappedTrace &) = delete;
+
+    const TraceFileHeader &get_header() const {
+        return *static_cast<const TraceFileHeader *>(mapping);
+    }
+
+    const std::string &get_filename() const { return filename; }
+
+    const TraceRecord *begin() const { return records; }
+    const TraceRecord *end() const { return records + record_count; }
+    std::size_t size() const { return record_count; }
+
+    const TraceRecord &operator[](std::size_t index) const {
+        return records[index];
+    }
+};
+
+} // namespace state_machine
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+
+namespace state_machine {
+
+/**
+ * @brief Header written once at the start of every binary trace file
+ *
+ * Records carry raw steady_clock ticks; the header stores the tick period
+ * and one steady/system clock pair so decoders can render wall time.
+ */
+struct TraceFileHeader {
+    char magic[8]; // TRACE_MAGIC
+    uint32_t version;
+    uint32_t record_size;
+    int64_t tick_num; // steady_clock::period::num
+    int64_t tick_den; // steady_clock::period::den
+    int64_t steady_origin_ticks;
+    int64_t system_origin_ns;
+
+    static constexpr uint32_t TRACE_VERSION = 1;
+};
+
+static_assert(sizeof(TraceFileHeader) == 48,
+              "TraceFileHeader layout is part of the file format");
+
+constexpr char TRACE_MAGIC[8] = {'S', 'M', 'T', 'R', 'A', 'C', 'E', '\0'};
+
+/**
+ * @brief Fixed-size record for one handled event
+ *
+ * States and events are stored as their underlying enum value, which
+ * limits traced enums to 256 values.
+ */
+struct TraceRecord {
+    uint64_t ticks; // steady_clock ticks
+    uint32_t instance_id;
+    uint8_t from_state;
+    uint8_t event;
+    uint8_t to_state;
+    uint8_t flags; // reserved
+};
+
+static_assert(sizeof(TraceRecord) == 16,
+              "TraceRecord layout is part of the file format");
+
+/**
+ * @brief Convert a record's steady ticks to system_clock nanoseconds
+ */
+inline int64_t trace_ticks_to_system_ns(const TraceFileHeader &header,
+                                        uint64_t ticks) {
+    long double elapsed =
+        static_cast<long double>(static_cast<int64_t>(ticks) -
+                                 header.steady_origin_ticks) *
+        header.tick_num * 1000000000.0L / header.tick_den;
+    return header.system_origin_ns + static_cast<int64_t>(elapsed);
+}
+
+} // namespace state_machine
@@ -0,0 +1,35 @@
+#pragma once
+#include "../core/subject.h"
+#include "trace_writer.h"
+#include <cstdint>
+#include <memory>
+
+namespace state_machine {
+
+/**
+ * @brief Observer writing binary TraceRecords instead of formatted text
+ *
+ * Several observers may share one TraceWriter as long as their controllers
+ * run on the same thread; instance_id tells their records apart.
+ */
+template <typename StateType, typename EventType>
+class TraceObserver : public IObserver<StateType, EventType> {
+  private:
+    std::shared_ptr<TraceWriter> writer;
+    uint32_t instance_id;
+
+  public:
+    TraceObserver(std::shared_ptr<TraceWriter> trace_writer, uint32_t id = 0)
+        : writer(std::move(trace_writer)), instance_id(id) {}
+
+    void on_state_transition(StateType from_state, EventType event,
+                             StateType to_state) override {
+        writer->append(instance_id, static_cast<uint8_t>(from_state),
+                       static_cast<uint8_t>(event),
+                       static_cast<uint8_t>(to_state));
+    }
+
+    void flush() { writer->flush(); }
+};
+
+} // namespace state_machine
@@ -0,0 +1,122 @@
+#pragma once
+#include "mapped_trace.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Record matcher; fields left at ANY match every value
+ */
+struct TraceStep {
+    static constexpr int ANY = -1;
+
+    int from_state = ANY;
+    int event = ANY;
+    int to_state = ANY;
+    bool state_change = false; // only records where from != to
+
+    bool matches(const TraceRecord &record) const {
+        return (from_state == ANY || from_state == record.from_state) &&
+               (event == ANY || event == record.event) &&
+               (to_state == ANY || to_state == record.to_state) &&
+               (!state_change || record.from_state != record.to_state);
+    }
+};
+
+/**
+ * @brief Summary of measured durations, in nanoseconds
+ */
+struct DurationStats {
+    uint64_t count = 0;
+    double mean_ns = 0.0;
+    int64_t min_ns = 0;
+    int64_t p50_ns = 0;
+    int64_t p99_ns = 0;
+    int64_t max_ns = 0;
+};
+
+/**
+ * @brief Path of consecutive states and how often it was taken
+ */
+struct PathCount {
+    std::vector<uint8_t> states;
+    uint64_t count;
+};
+
+/**
+ * @brief Indexed, parallel queries over one or more mapped trace files
+ *
+ * Construction maps every file and builds a per-instance index (records of
+ * each instance in time order) and a per-state index (positions where an
+ * instance entered a state). Queries split instances across worker threads.
+ */
+class TraceQueryEngine {
+  private:
+    struct RecordRef {
+        uint32_t trace;
+        uint32_t index;
+    };
+
+    struct InstancePosition {
+        uint32_t instance_slot;
+        uint32_t position;
+    };
+
+    std::vector<std::unique_ptr<MappedTrace>> traces;
+    std::vector<uint32_t> instance_ids;
+    std::vector<std::vector<RecordRef>> by_instance;
+    std::vector<std::vector<InstancePosition>> by_state; // state entries
+    unsigned worker_count;
+
+  public:
+    static constexpr std::size_t STATE_LIMIT = 256;
+
+    explicit TraceQueryEngine(const std::vector<std::string> &trace_files,
+                              unsigned threads = 0);
+
+    std::size_t get_record_count() const;
+    std::size_t get_instance_count() const { return instance_ids.size(); }
+
+    // Time spent in state between entering and leaving it
+    DurationStats dwell_time(uint8_t state) const;
+
+    // Time from a record matching start to the next one matching end, per
+    // instance; repeated starts while one is pending are ignored
+    DurationStats wait_time(const TraceStep &start,
+                            const TraceStep &end) const;
+
+    // Most frequent runs of `length` consecutive state changes
+    std::vector<PathCount> path_frequency(std::size_t length,
+                                          std::size_t top = 10) const;
+
+    // Occurrences of steps matching consecutive records of one instance
+    uint64_t count_sequence(const std::vector<TraceStep> &steps) const;
+
+  private:
+    const TraceRecord &record_at(const RecordRef &ref) const {
+        return (*traces[ref.trace])[ref.index];
+    }
+
+    int64_t time_ns(const RecordRef &ref) const {
+        return trace_ticks_to_system_ns(traces[ref.trace]->get_header(),
+                                        record_at(ref).ticks);
+    }
+
+    void build_indexes();
+
+    // Splits [0, count) across workers, runs fn(worker, begin, end) on each
+    void for_each_range(
+        std::size_t count,
+        const std::function<void(unsigned, std::size_t, std::size_t)> &fn)
+        const;
+
+    static DurationStats summarize(std::vector<int64_t> &durations);
+};
+
+} // namespace state_machine
@@ -0,0 +1,40 @@
+#pragma once
+#include "trace_format.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Sequential, buffered reader for files produced by TraceWriter
+ */
+class TraceFileReader {
+  private:
+    int fd = -1;
+    std::string filename;
+    TraceFileHeader header;
+    std::vector<TraceRecord> buffer;
+    std::size_t buffer_pos = 0;
+    std::size_t buffer_fill = 0;
+
+  public:
+    explicit TraceFileReader(const std::string &trace_filename);
+    ~TraceFileReader();
+
+    TraceFileReader(const TraceFileReader &) = delete;
+    TraceFileReader &operator=(const TraceFileReader &) = delete;
+
+    const TraceFileHeader &get_header() const { return header; }
+
+    // Returns false once the end of the file is reached
+    bool next(TraceRecord &record);
+};
+
+/**
+ * @brief Throws std::runtime_error if header is not a supported trace header
+ */
+void validate_trace_header(const TraceFileHeader &header,
+                           const std::string &filename);
+
+} // namespace state_machine
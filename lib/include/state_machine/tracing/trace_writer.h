@@ -0,0 +1,79 @@
+#pragma once
+#include "trace_format.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace state_machine {
+
+/**
+ * @brief Buffering and flush thresholds for TraceWriter
+ */
+struct TraceWriterOptions {
+    std::size_t buffer_size = 4 * 1024 * 1024; // total user-space buffer
+    std::size_t chunk_size = 64 * 1024;        // unit handed to writev()
+    std::chrono::milliseconds flush_interval{1000};
+};
+
+/**
+ * @brief Appends TraceRecords to a binary trace file
+ *
+ * Records are copied into preallocated chunks and written with a single
+ * writev() once the buffer is full or the flush interval has passed since
+ * the last flush. The interval is checked on append, so an idle writer
+ * keeps its tail until the next record, flush() or destruction.
+ * Not thread-safe: use one writer per thread.
+ */
+class TraceWriter {
+  private:
+    int fd = -1;
+    std::string filename;
+    std::size_t chunk_records;
+    std::vector<std::unique_ptr<TraceRecord[]>> chunks;
+    std::size_t active_chunk = 0;
+    std::size_t active_fill = 0;
+    uint64_t flush_interval_ticks;
+    uint64_t last_flush_ticks;
+
+  public:
+    explicit TraceWriter(const std::string &trace_filename,
+                         const TraceWriterOptions &options = {});
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter &) = delete;
+    TraceWriter &operator=(const TraceWriter &) = delete;
+
+    void append(uint32_t instance_id, uint8_t from_state, uint8_t event,
+                uint8_t to_state) {
+        auto ticks = static_cast<uint64_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+
+        TraceRecord &record = chunks[active_chunk][active_fill];
+        record.ticks = ticks;
+        record.instance_id = instance_id;
+        record.from_state = from_state;
+        record.event = event;
+        record.to_state = to_state;
+        record.flags = 0;
+
+        if (++active_fill == chunk_records) {
+            active_fill = 0;
+            if (++active_chunk == chunks.size()) {
+                flush();
+                return;
+            }
+        }
+        if (ticks - last_flush_ticks >= flush_interval_ticks) {
+            flush();
+        }
+    }
+
+    void flush();
+
+    const std::string &get_filename() const { return filename; }
+};
+
+} // namespace state_machine
@@ -0,0 +1,108 @@
+#include "state_machine/execution/executor_stats.h"
+
+namespace state_machine {
+
+std::vector<std::size_t>
+register_executor_metrics(MetricsRegistry &registry,
+                          std::shared_ptr<const ExecutorStats> stats,
+                          const MetricLabels &labels) {
+    // Readers hold the stats, so a scrape stays valid after the executor
+    auto seconds = [](int64_t ns) { return static_cast<double>(ns) / 1e9; };
+
+    std::vector<std::size_t> ids = {
+        registry.add("state_machine_executor_events_enqueued_total",
+                     "Events posted to the executor queue",
+                     MetricType::COUNTER, labels,
+                     [stats]() {
+                         return static_cast<double>(
+                             stats->enqueued.load(std::memory_order_relaxed));
+                     }),
+        registry.add("state_machine_executor_events_handled_total",
+                     "Events taken off the executor queue and handled",
+                     MetricType::COUNTER, labels,
+                     [stats]() {
+                         return static_cast<double>(
+                             stats->handled.load(std::memory_order_relaxed));
+                     }),
+        registry.add("state_machine_executor_events_coalesced_total",
+                     "Events merged into an already pending event",
+                     MetricType::COUNTER, labels,
+                     [stats]() {
+                         return static_cast<double>(
+                             stats->coalesced.load(std::memory_order_relaxed));
+                     }),
+        registry.add("state_machine_executor_mailbox_high_water",
+                     "Most events seen pending in one mailbox",
+                     MetricType::GAUGE, labels,
+                     [stats]() {
+                         return static_cast<double>(
+                             stats->mailbox_high_water.load(
+                                 std::memory_order_relaxed));
+                     }),
+        registry.add("state_machine_executor_queue_depth",
+                     "Events waiting in the executor queue", MetricType::GAUGE,
+                     labels,
+                     [stats]() {
+                         return static_cast<double>(stats->queue_depth.load(
+                             std::memory_order_relaxed));
+                     }),
+        registry.add("state_machine_executor_queue_lag_seconds",
+                     "Queueing delay of the most recently dequeued event",
+                     MetricType::GAUGE, labels,
+                     [stats, seconds]() {
+                         return seconds(stats->last_lag_ns.load(
+                             std::memory_order_relaxed));
+                     }),
+        registry.add("state_machine_executor_queue_lag_max_seconds",
+                     "Largest queueing delay seen", MetricType::GAUGE, labels,
+                     [stats, seconds]() {
+                         return seconds(stats->max_lag_ns.load(
+                             std::memory_order_relaxed));
+                     }),
+        registry.add("state_machine_executor_timers_pending",
+                     "Armed timers that have not fired yet", MetricType::GAUGE,
+                     labels, [stats]() {
+                         return static_cast<double>(stats->timers_pending.load(
+                             std::memory_order_relaxed));
+                     })};
+
+    // Drops by cause: full mailbox rejected the event, or evicted it later
+    const std::pair<const char *, const std::atomic<uint64_t> ExecutorStats::*>
+        drops[] = {{"rejected", &ExecutorStats::rejected},
+                   {"evicted", &ExecutorStats::evicted}};
+    for (const auto &drop : drops) {
+        MetricLabels drop_labels = labels;
+        drop_labels.emplace_back("reason", drop.first);
+        auto counter = drop.second;
+        ids.push_back(registry.add(
+            "state_machine_executor_events_dropped_total",
+            "Events lost to mailbox overflow", MetricType::COUNTER,
+            drop_labels, [stats, counter]() {
+                return static_cast<double>(
+                    ((*stats).*counter).load(std::memory_order_relaxed));
+            }));
+    }
+
+    for (std::size_t lane = 0; lane < PRIORITY_LANES; ++lane) {
+        MetricLabels lane_labels = labels;
+        lane_labels.emplace_back(
+            "lane", priority_to_string(static_cast<EventPriority>(lane)));
+        ids.push_back(registry.add(
+            "state_machine_executor_lane_events_handled_total",
+            "Events handled per mailbox priority lane", MetricType::COUNTER,
+            lane_labels, [stats, lane]() {
+                return static_cast<double>(stats->handled_by_lane[lane].load(
+                    std::memory_order_relaxed));
+            }));
+        ids.push_back(registry.add(
+            "state_machine_executor_lane_lag_max_seconds",
+            "Largest queueing delay seen per mailbox priority lane",
+            MetricType::GAUGE, lane_labels, [stats, lane, seconds]() {
+                return seconds(stats->max_lag_ns_by_lane[lane].load(
+                    std::memory_order_relaxed));
+            }));
+    }
+    return ids;
+}
+
+} // namespace state_machine
@@ -0,0 +1,285 @@
+#include "state_machine/execution/reactor.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+constexpr int Reactor::MAX_READY;
+
+namespace {
+
+std::string system_error(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+timespec to_timespec(Reactor::Clock::duration duration) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+                  .count();
+    if (ns < 0) {
+        ns = 0;
+    }
+    timespec spec;
+    spec.tv_sec = static_cast<time_t>(ns / 1000000000);
+    spec.tv_nsec = static_cast<long>(ns % 1000000000);
+    return spec;
+}
+
+// Reads an eventfd or timerfd counter; 0 if nothing was pending
+uint64_t read_counter(int fd) {
+    uint64_t value = 0;
+    while (::read(fd, &value, sizeof(value)) < 0) {
+        if (errno != EINTR)
+            return 0;
+    }
+    return value;
+}
+
+} // namespace
+
+Reactor::Reactor() {
+    epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        throw std::runtime_error(system_error("Cannot create epoll instance"));
+    }
+    stop_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stop_fd < 0) {
+        std::string message = system_error("Cannot create reactor eventfd");
+        ::close(epoll_fd);
+        throw std::runtime_error(message);
+    }
+
+    // Id 0 marks the stop eventfd, source ids start at 1
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+    if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &event) < 0) {
+        std::string message = system_error("Cannot watch reactor eventfd");
+        ::close(stop_fd);
+        ::close(epoll_fd);
+        throw std::runtime_error(message);
+    }
+}
+
+Reactor::~Reactor() {
+    stop();
+    for (const auto &entry : sources) {
+        if (entry.second.owned) {
+            ::close(entry.second.fd);
+        }
+    }
+    close_removed();
+    ::close(stop_fd);
+    ::close(epoll_fd);
+}
+
+Reactor::SourceId Reactor::watch(int fd, uint32_t events,
+                                 ReadyHandler handler) {
+    return add(fd, events, false,
+               [handler](SourceId, int ready_fd, uint32_t ready) {
+                   handler(ready_fd, ready);
+               });
+}
+
+Reactor::SourceId Reactor::watch_source(int fd, uint32_t events,
+                                        SourceHandler handler) {
+    return add(fd, events, false, std::move(handler));
+}
+
+Reactor::SourceId Reactor::add_timer(Clock::duration first,
+                                     Clock::duration interval,
+                                     TimerHandler handler) {
+    int fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd < 0) {
+        throw std::runtime_error(system_error("Cannot create timerfd"));
+    }
+    itimerspec spec = {};
+    spec.it_value = to_timespec(first);
+    spec.it_interval = to_timespec(interval);
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+        spec.it_value.tv_nsec = 1; // zero would disarm the timer
+    }
+    bool one_shot = spec.it_interval.tv_sec == 0 && spec.it_interval.tv_nsec == 0;
+
+    SourceId added;
+    try {
+        added = add(fd, EPOLLIN, true,
+                    [this, handler, one_shot](SourceId id, int timer_fd,
+                                              uint32_t) {
+                        uint64_t expirations = read_counter(timer_fd);
+                        if (expirations == 0)
+                            return;
+                        if (one_shot) {
+                            remove(id);
+                        }
+                        handler(expirations);
+                    });
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    if (::timerfd_settime(fd, 0, &spec, nullptr) < 0) {
+        std::string message = system_error("Cannot arm timerfd");
+        remove(added);
+        throw std::runtime_error(message);
+    }
+    return added;
+}
+
+bool Reactor::remove(SourceId id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = sources.find(id);
+    if (found == sources.end())
+        return false;
+
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, found->second.fd, nullptr);
+    if (found->second.owned) {
+        // The loop may be reading it right now; it closes it after the
+        // current wakeup
+        closing.push_back(found->second.fd);
+    }
+    sources.erase(found);
+    return true;
+}
+
+Reactor::WakeupId Reactor::on_wakeup(WakeupHandler handler) {
+    std::lock_guard<std::mutex> lock(wakeup_mutex);
+    WakeupId id = next_wakeup_id++;
+    wakeup_handlers.push_back(Wakeup{id, std::move(handler)});
+    return id;
+}
+
+bool Reactor::remove_wakeup(WakeupId id) {
+    std::lock_guard<std::mutex> lock(wakeup_mutex);
+    for (auto it = wakeup_handlers.begin(); it != wakeup_handlers.end();
+         ++it) {
+        if (it->id == id) {
+            wakeup_handlers.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Reactor::start() {
+    if (looping)
+        return;
+    stop_requested = false;
+    loop_thread = std::thread(&Reactor::run, this);
+}
+
+void Reactor::stop() {
+    request_stop();
+    if (loop_thread.joinable() &&
+        loop_thread.get_id() != std::this_thread::get_id()) {
+        loop_thread.join();
+    }
+}
+
+void Reactor::run() {
+    if (looping.exchange(true))
+        throw std::runtime_error("Reactor is already running");
+
+    epoll_event ready[MAX_READY];
+    while (!stop_requested) {
+        int count = ::epoll_wait(epoll_fd, ready, MAX_READY, -1);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            looping = false;
+            throw std::runtime_error(system_error("epoll_wait failed"));
+        }
+        wakeups.fetch_add(1, std::memory_order_relaxed);
+
+        // Handlers are looked up by id, so a source removed earlier in
+        // this wakeup is skipped even if its fd number was reused
+        for (int i = 0; i < count; ++i) {
+            SourceId id = ready[i].data.u64;
+            if (id == 0) {
+                read_counter(stop_fd);
+                continue;
+            }
+            int fd;
+            std::shared_ptr<SourceHandler> handler;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto found = sources.find(id);
+                if (found == sources.end())
+                    continue;
+                fd = found->second.fd;
+                handler = found->second.handler;
+            }
+            // A throwing handler must not end the loop, and with it the
+            // thread it runs on
+            try {
+                (*handler)(id, fd, ready[i].events);
+            } catch (...) {
+                handler_errors.fetch_add(1, std::memory_order_relaxed);
+            }
+            dispatches.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(wakeup_mutex);
+            for (const auto &wakeup : wakeup_handlers) {
+                try {
+                    wakeup.handler();
+                } catch (...) {
+                    handler_errors.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        close_removed();
+    }
+    looping = false;
+}
+
+void Reactor::request_stop() {
+    stop_requested = true;
+    uint64_t one = 1;
+    while (::write(stop_fd, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+}
+
+std::size_t Reactor::get_source_count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sources.size();
+}
+
+Reactor::SourceId Reactor::add(int fd, uint32_t events, bool owned,
+                               SourceHandler handler) {
+    std::lock_guard<std::mutex> lock(mutex);
+    SourceId id = next_id++;
+    epoll_event event = {};
+    event.events = events;
+    event.data.u64 = id;
+    if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        throw std::runtime_error(
+            system_error("Cannot watch fd " + std::to_string(fd)));
+    }
+    sources.emplace(
+        id, Source{fd, owned,
+                   std::make_shared<SourceHandler>(std::move(handler))});
+    return id;
+}
+
+void Reactor::close_removed() {
+    std::vector<int> fds;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fds.swap(closing);
+    }
+    for (int fd : fds) {
+        ::close(fd);
+    }
+}
+
+} // namespace state_machine
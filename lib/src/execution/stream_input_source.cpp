@@ -0,0 +1,34 @@
+#include "state_machine/execution/event_source.h"
+
+namespace state_machine {
+
+StreamInputSource::StreamInputSource(std::istream &stream,
+                                     InputHandler input_handler)
+    : input(stream), handler(std::move(input_handler)) {}
+
+StreamInputSource::~StreamInputSource() { stop(); }
+
+void StreamInputSource::start() {
+    if (running.exchange(true))
+        return;
+    input_thread = std::thread(&StreamInputSource::input_loop, this);
+}
+
+void StreamInputSource::stop() {
+    running = false;
+    if (input_thread.joinable() &&
+        input_thread.get_id() != std::this_thread::get_id()) {
+        input_thread.join();
+    }
+}
+
+void StreamInputSource::input_loop() {
+    char character;
+    while (running && input >> character) {
+        if (!handler(character))
+            break;
+    }
+    running = false;
+}
+
+} // namespace state_machine
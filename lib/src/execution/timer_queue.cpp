@@ -0,0 +1,86 @@
+#include "state_machine/execution/timer_queue.h"
+
+namespace state_machine {
+
+TimerQueue::~TimerQueue() { stop(); }
+
+void TimerQueue::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running)
+        return;
+    running = true;
+    timer_thread = std::thread(&TimerQueue::timer_loop, this);
+}
+
+void TimerQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wakeup.notify_all();
+    if (timer_thread.joinable()) {
+        timer_thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    callbacks.clear();
+    deadlines = decltype(deadlines)();
+}
+
+TimerQueue::TimerId TimerQueue::schedule(Clock::duration delay,
+                                         Callback callback) {
+    TimerId id;
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = next_id++;
+        Deadline deadline = {Clock::now() + delay, id};
+        earliest = deadlines.empty() || deadline.when < deadlines.top().when;
+        deadlines.push(deadline);
+        callbacks.emplace(id, std::move(callback));
+    }
+    // Only a new earliest deadline shortens the thread's sleep
+    if (earliest) {
+        wakeup.notify_one();
+    }
+    return id;
+}
+
+bool TimerQueue::cancel(TimerId id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return callbacks.erase(id) > 0;
+}
+
+std::size_t TimerQueue::get_pending_count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return callbacks.size();
+}
+
+void TimerQueue::timer_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        if (deadlines.empty()) {
+            wakeup.wait(lock);
+            continue;
+        }
+
+        Deadline next = deadlines.top();
+        if (Clock::now() < next.when) {
+            wakeup.wait_until(lock, next.when);
+            continue;
+        }
+
+        deadlines.pop();
+        auto it = callbacks.find(next.id);
+        if (it == callbacks.end())
+            continue; // cancelled
+
+        Callback callback = std::move(it->second);
+        callbacks.erase(it);
+        lock.unlock();
+        callback();
+        lock.lock();
+    }
+}
+
+} // namespace state_machine
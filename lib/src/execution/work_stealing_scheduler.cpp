@@ -0,0 +1,166 @@
+#include "state_machine/execution/work_stealing_scheduler.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace state_machine {
+
+namespace {
+
+// Lets schedule() called from a worker push to that worker's own deque
+struct CurrentWorker {
+    const WorkStealingScheduler *scheduler;
+    std::size_t index;
+};
+thread_local CurrentWorker current_worker = {nullptr, 0};
+
+void pin_to_cpu(std::thread &thread, int cpu) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    int error =
+        ::pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+    if (error != 0) {
+        throw std::runtime_error("Cannot pin worker to CPU " +
+                                 std::to_string(cpu) + ": " +
+                                 std::strerror(error));
+    }
+}
+
+} // namespace
+
+WorkStealingScheduler::WorkStealingScheduler(std::size_t worker_count,
+                                             RunTask task_runner,
+                                             std::vector<int> cpus)
+    : run_task(std::move(task_runner)), worker_cpus(std::move(cpus)) {
+    if (worker_count == 0) {
+        worker_count = 1;
+    }
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(new Worker());
+    }
+}
+
+WorkStealingScheduler::~WorkStealingScheduler() { stop(); }
+
+void WorkStealingScheduler::start() {
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        workers[i]->thread =
+            std::thread(&WorkStealingScheduler::worker_loop, this, i);
+        if (!worker_cpus.empty()) {
+            try {
+                pin_to_cpu(workers[i]->thread,
+                           worker_cpus[i % worker_cpus.size()]);
+            } catch (...) {
+                stop();
+                throw;
+            }
+        }
+    }
+}
+
+void WorkStealingScheduler::request_stop() {
+    stop_requested = true;
+    std::lock_guard<std::mutex> lock(idle_mutex);
+    idle_cv.notify_all();
+}
+
+void WorkStealingScheduler::stop() {
+    request_stop();
+    for (auto &worker : workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void WorkStealingScheduler::schedule(TaskId task, bool urgent) {
+    // Counted before it is visible so that queued never drops below zero
+    queued.fetch_add(1);
+    if (current_worker.scheduler == this) {
+        push(current_worker.index, task, urgent);
+    } else {
+        push(next_worker.fetch_add(1, std::memory_order_relaxed) %
+                 workers.size(),
+             task, urgent);
+    }
+
+    if (sleeping.load() > 0) {
+        std::lock_guard<std::mutex> lock(idle_mutex);
+        idle_cv.notify_one();
+    }
+}
+
+void WorkStealingScheduler::push(std::size_t worker, TaskId task,
+                                 bool urgent) {
+    std::lock_guard<std::mutex> lock(workers[worker]->mutex);
+    if (urgent) {
+        workers[worker]->tasks.push_front(task);
+    } else {
+        workers[worker]->tasks.push_back(task);
+    }
+}
+
+void WorkStealingScheduler::worker_loop(std::size_t self) {
+    current_worker = {this, self};
+    TaskId task;
+    while (!stop_requested) {
+        if (next_task(self, task)) {
+            queued.fetch_sub(1);
+            run_task(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        sleeping.fetch_add(1);
+        idle_cv.wait(lock, [this] {
+            return stop_requested || queued.load() > 0;
+        });
+        sleeping.fetch_sub(1);
+    }
+    current_worker = {nullptr, 0};
+}
+
+bool WorkStealingScheduler::next_task(std::size_t self, TaskId &task) {
+    Worker &own = *workers[self];
+    for (std::size_t offset = 0; offset < workers.size(); ++offset) {
+        if (offset > 0 && !steal_into(self, (self + offset) % workers.size()))
+            continue;
+
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkStealingScheduler::steal_into(std::size_t self, std::size_t victim) {
+    std::vector<TaskId> loot;
+    {
+        Worker &target = *workers[victim];
+        std::lock_guard<std::mutex> lock(target.mutex);
+        std::size_t count = (target.tasks.size() + 1) / 2;
+        for (std::size_t i = 0; i < count; ++i) {
+            loot.push_back(target.tasks.back());
+            target.tasks.pop_back();
+        }
+    }
+    if (loot.empty())
+        return false;
+
+    // Never hold two worker locks at once
+    Worker &own = *workers[self];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    own.tasks.insert(own.tasks.end(), loot.rbegin(), loot.rend());
+    steals.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+} // namespace state_machine
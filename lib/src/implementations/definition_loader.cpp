@@ -0,0 +1,588 @@
+#include "state_machine/implementations/definition_loader.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <initializer_list>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace state_machine {
+
+namespace {
+
+// Deeper documents are rejected rather than recursed into
+const std::size_t MAX_DEPTH = 32;
+
+/**
+ * @brief Parsed JSON value, remembering where it started for error messages
+ */
+struct Json {
+    enum Kind { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    Kind kind = NUL;
+    bool boolean = false;
+    double number = 0;
+    std::string text;
+    std::vector<Json> items;
+    std::vector<std::pair<std::string, Json>> members; // in source order
+    std::size_t line = 0;
+    std::size_t column = 0;
+};
+
+std::string location(std::size_t line, std::size_t column) {
+    return "Definition line " + std::to_string(line) + ", column " +
+           std::to_string(column) + ": ";
+}
+
+[[noreturn]] void fail(const Json &at, const std::string &message) {
+    throw std::runtime_error(location(at.line, at.column) + message);
+}
+
+/**
+ * @brief Recursive descent parser for RFC 8259 JSON
+ */
+class JsonParser {
+  private:
+    const std::string &text;
+    std::size_t pos = 0;
+    std::size_t line = 1;
+    std::size_t column = 1;
+
+  public:
+    explicit JsonParser(const std::string &source) : text(source) {}
+
+    Json parse_document() {
+        Json value = parse_value(0);
+        skip_space();
+        if (pos != text.size()) {
+            error("unexpected text after the definition");
+        }
+        return value;
+    }
+
+  private:
+    [[noreturn]] void error(const std::string &message) const {
+        throw std::runtime_error(location(line, column) + message);
+    }
+
+    bool at_end() const { return pos >= text.size(); }
+    char peek() const { return at_end() ? '\0' : text[pos]; }
+
+    char next() {
+        char c = text[pos++];
+        if (c == '\n') {
+            ++line;
+            column = 1;
+        } else {
+            ++column;
+        }
+        return c;
+    }
+
+    void skip_space() {
+        while (!at_end() && (peek() == ' ' || peek() == '\t' ||
+                             peek() == '\n' || peek() == '\r')) {
+            next();
+        }
+    }
+
+    void expect(char c) {
+        if (peek() != c) {
+            error(std::string("expected '") + c + "'");
+        }
+        next();
+    }
+
+    void expect_word(const char *word) {
+        for (const char *c = word; *c; ++c) {
+            if (peek() != *c) {
+                error(std::string("expected '") + word + "'");
+            }
+            next();
+        }
+    }
+
+    Json parse_value(std::size_t depth) {
+        if (depth > MAX_DEPTH) {
+            error("nested too deeply");
+        }
+        skip_space();
+        Json value;
+        value.line = line;
+        value.column = column;
+        switch (peek()) {
+        case '{':
+            parse_object(value, depth);
+            break;
+        case '[':
+            parse_array(value, depth);
+            break;
+        case '"':
+            value.kind = Json::STRING;
+            value.text = parse_string();
+            break;
+        case 't':
+            expect_word("true");
+            value.kind = Json::BOOLEAN;
+            value.boolean = true;
+            break;
+        case 'f':
+            expect_word("false");
+            value.kind = Json::BOOLEAN;
+            break;
+        case 'n':
+            expect_word("null");
+            break;
+        default:
+            if (peek() == '-' || (peek() >= '0' && peek() <= '9')) {
+                value.kind = Json::NUMBER;
+                value.number = parse_number();
+            } else if (at_end()) {
+                error("unexpected end of definition");
+            } else {
+                error(std::string("unexpected character '") + peek() + "'");
+            }
+        }
+        return value;
+    }
+
+    void parse_object(Json &value, std::size_t depth) {
+        value.kind = Json::OBJECT;
+        next();
+        skip_space();
+        if (peek() == '}') {
+            next();
+            return;
+        }
+        std::set<std::string> keys;
+        while (true) {
+            skip_space();
+            if (peek() != '"') {
+                error("expected a key");
+            }
+            std::string key = parse_string();
+            if (!keys.insert(key).second) {
+                error("duplicate key '" + key + "'");
+            }
+            skip_space();
+            expect(':');
+            value.members.emplace_back(key, parse_value(depth + 1));
+            skip_space();
+            if (peek() == ',') {
+                next();
+                continue;
+            }
+            expect('}');
+            return;
+        }
+    }
+
+    void parse_array(Json &value, std::size_t depth) {
+        value.kind = Json::ARRAY;
+        next();
+        skip_space();
+        if (peek() == ']') {
+            next();
+            return;
+        }
+        while (true) {
+            value.items.push_back(parse_value(depth + 1));
+            skip_space();
+            if (peek() == ',') {
+                next();
+                continue;
+            }
+            expect(']');
+            return;
+        }
+    }
+
+    std::string parse_string() {
+        next(); // opening quote
+        std::string result;
+        while (true) {
+            if (at_end()) {
+                error("unterminated string");
+            }
+            char c = next();
+            if (c == '"')
+                return result;
+            if (static_cast<unsigned char>(c) < 0x20) {
+                error("control character in string");
+            }
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            if (at_end()) {
+                error("unterminated string");
+            }
+            switch (next()) {
+            case '"':
+                result += '"';
+                break;
+            case '\\':
+                result += '\\';
+                break;
+            case '/':
+                result += '/';
+                break;
+            case 'b':
+                result += '\b';
+                break;
+            case 'f':
+                result += '\f';
+                break;
+            case 'n':
+                result += '\n';
+                break;
+            case 'r':
+                result += '\r';
+                break;
+            case 't':
+                result += '\t';
+                break;
+            case 'u':
+                append_utf8(result, parse_hex4());
+                break;
+            default:
+                error("invalid escape in string");
+            }
+        }
+    }
+
+    unsigned parse_hex4() {
+        unsigned code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = at_end() ? '\0' : next();
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= static_cast<unsigned>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                code |= static_cast<unsigned>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                code |= static_cast<unsigned>(c - 'A' + 10);
+            } else {
+                error("invalid \\u escape");
+            }
+        }
+        return code;
+    }
+
+    // Surrogate pairs are not joined; names are expected to be ASCII
+    static void append_utf8(std::string &out, unsigned code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    double parse_number() {
+        std::size_t start = pos;
+        if (peek() == '-')
+            next();
+        if (peek() == '0') {
+            next();
+        } else if (!digits()) {
+            error("invalid number");
+        }
+        if (peek() == '.') {
+            next();
+            if (!digits()) {
+                error("invalid number");
+            }
+        }
+        if (peek() == 'e' || peek() == 'E') {
+            next();
+            if (peek() == '+' || peek() == '-')
+                next();
+            if (!digits()) {
+                error("invalid number");
+            }
+        }
+        return std::strtod(text.substr(start, pos - start).c_str(), nullptr);
+    }
+
+    bool digits() {
+        bool any = false;
+        while (peek() >= '0' && peek() <= '9') {
+            next();
+            any = true;
+        }
+        return any;
+    }
+};
+
+const char *kind_name(Json::Kind kind) {
+    switch (kind) {
+    case Json::NUL:
+        return "null";
+    case Json::BOOLEAN:
+        return "a boolean";
+    case Json::NUMBER:
+        return "a number";
+    case Json::STRING:
+        return "a string";
+    case Json::ARRAY:
+        return "an array";
+    case Json::OBJECT:
+        return "an object";
+    }
+    return "a value";
+}
+
+const Json &require(const Json &value, Json::Kind kind,
+                    const std::string &what) {
+    if (value.kind != kind) {
+        fail(value, what + " must be " + kind_name(kind) + ", not " +
+                        kind_name(value.kind));
+    }
+    return value;
+}
+
+// Rejects members outside allowed, catching misspelt optional keys
+void check_keys(const Json &object, const std::string &what,
+                std::initializer_list<const char *> allowed) {
+    for (const auto &member : object.members) {
+        bool known = false;
+        for (const char *key : allowed) {
+            known = known || member.first == key;
+        }
+        if (!known) {
+            fail(member.second, "unknown key '" + member.first + "' in " + what);
+        }
+    }
+}
+
+const Json *member(const Json &object, const char *key) {
+    for (const auto &entry : object.members) {
+        if (entry.first == key)
+            return &entry.second;
+    }
+    return nullptr;
+}
+
+const Json &required(const Json &object, const char *key,
+                     const std::string &what) {
+    const Json *value = member(object, key);
+    if (!value) {
+        fail(object, what + " lacks \"" + key + "\"");
+    }
+    return *value;
+}
+
+std::string name_of(const Json &value, const std::string &what) {
+    const std::string &name = require(value, Json::STRING, what).text;
+    if (name.empty()) {
+        fail(value, what + " must not be empty");
+    }
+    return name;
+}
+
+uint64_t count_of(const Json &value, const std::string &what, uint64_t max) {
+    require(value, Json::NUMBER, what);
+    if (value.number < 0 || value.number != std::floor(value.number) ||
+        value.number > static_cast<double>(max)) {
+        fail(value, what + " must be a whole number from 0 to " +
+                        std::to_string(max));
+    }
+    return static_cast<uint64_t>(value.number);
+}
+
+std::string display_text(const Json &value, const std::string &what) {
+    switch (value.kind) {
+    case Json::STRING:
+        return value.text;
+    case Json::BOOLEAN:
+        return value.boolean ? "true" : "false";
+    case Json::NUMBER: {
+        std::ostringstream out;
+        out << value.number;
+        return out.str();
+    }
+    default:
+        fail(value, what + " must be a string, number or boolean");
+    }
+}
+
+/**
+ * @brief Index of each declared name, rejecting duplicates
+ */
+class NameTable {
+  private:
+    std::string kind;
+    std::map<std::string, std::size_t> indexes;
+
+  public:
+    explicit NameTable(std::string table_kind) : kind(std::move(table_kind)) {}
+
+    void declare(const Json &at, const std::string &name) {
+        if (!indexes.emplace(name, indexes.size()).second) {
+            fail(at, kind + " '" + name + "' declared twice");
+        }
+    }
+
+    std::size_t find(const Json &at, const std::string &name) const {
+        auto it = indexes.find(name);
+        if (it == indexes.end()) {
+            fail(at, "undeclared " + kind + " '" + name + "'");
+        }
+        return it->second;
+    }
+};
+
+DefinitionDocument build_document(const Json &root) {
+    require(root, Json::OBJECT, "A definition");
+    check_keys(root, "the definition",
+               {"name", "version", "initial", "events", "guards", "states",
+                "transitions", "map_states"});
+
+    DefinitionDocument document;
+    if (const Json *name = member(root, "name")) {
+        document.name = name_of(*name, "\"name\"");
+    }
+    if (const Json *version = member(root, "version")) {
+        document.version = count_of(*version, "\"version\"", UINT32_MAX);
+        if (document.version == 0) {
+            fail(*version, "\"version\" starts at 1");
+        }
+    }
+
+    NameTable events("event");
+    for (const Json &item :
+         require(required(root, "events", "The definition"), Json::ARRAY,
+                 "\"events\"")
+             .items) {
+        document.events.push_back(name_of(item, "An event"));
+        events.declare(item, document.events.back());
+    }
+
+    NameTable guards("guard");
+    if (const Json *list = member(root, "guards")) {
+        for (const Json &item : require(*list, Json::ARRAY, "\"guards\"").items) {
+            document.guards.push_back(name_of(item, "A guard"));
+            guards.declare(item, document.guards.back());
+        }
+    }
+
+    NameTable states("state");
+    const Json &state_list = require(required(root, "states", "The definition"),
+                                     Json::ARRAY, "\"states\"");
+    if (state_list.items.empty()) {
+        fail(state_list, "a definition needs at least one state");
+    }
+    for (const Json &item : state_list.items) {
+        require(item, Json::OBJECT, "A state");
+        check_keys(item, "a state", {"name", "timeout", "display"});
+        DefinitionDocument::State state;
+        state.name = name_of(required(item, "name", "A state"), "A state name");
+        states.declare(item, state.name);
+        if (const Json *timeout = member(item, "timeout")) {
+            state.timeout = static_cast<uint32_t>(
+                count_of(*timeout, "\"timeout\"", UINT32_MAX));
+        }
+        if (const Json *display = member(item, "display")) {
+            for (const auto &entry :
+                 require(*display, Json::OBJECT, "\"display\"").members) {
+                state.display[entry.first] =
+                    display_text(entry.second, "Display entry '" +
+                                                   entry.first + "'");
+            }
+        }
+        document.states.push_back(std::move(state));
+    }
+
+    if (const Json *initial = member(root, "initial")) {
+        document.initial_state =
+            states.find(*initial, name_of(*initial, "\"initial\""));
+    }
+
+    std::set<std::pair<std::size_t, std::size_t>> handled;
+    std::vector<bool> guard_used(document.guards.size(), false);
+    for (const Json &item :
+         require(required(root, "transitions", "The definition"), Json::ARRAY,
+                 "\"transitions\"")
+             .items) {
+        require(item, Json::OBJECT, "A transition");
+        check_keys(item, "a transition",
+                   {"from", "event", "to", "guard", "guarded_to"});
+        const Json &from = required(item, "from", "A transition");
+        const Json &event = required(item, "event", "A transition");
+        const Json &to = required(item, "to", "A transition");
+
+        DefinitionDocument::Transition transition;
+        transition.from_state = states.find(from, name_of(from, "\"from\""));
+        transition.event = events.find(event, name_of(event, "\"event\""));
+        transition.to_state = states.find(to, name_of(to, "\"to\""));
+        transition.guarded_state = transition.to_state;
+        transition.guard = -1;
+
+        const Json *guard = member(item, "guard");
+        const Json *guarded_to = member(item, "guarded_to");
+        if ((guard == nullptr) != (guarded_to == nullptr)) {
+            fail(item, "\"guard\" and \"guarded_to\" go together");
+        }
+        if (guard) {
+            std::size_t index = guards.find(*guard, name_of(*guard, "\"guard\""));
+            transition.guard = static_cast<int>(index);
+            transition.guarded_state = states.find(
+                *guarded_to, name_of(*guarded_to, "\"guarded_to\""));
+            guard_used[index] = true;
+        }
+
+        if (!handled.emplace(transition.from_state, transition.event).second) {
+            fail(item, "second transition from '" +
+                           document.states[transition.from_state].name +
+                           "' on '" + document.events[transition.event] +
+                           "'");
+        }
+        document.transitions.push_back(transition);
+    }
+    for (std::size_t i = 0; i < guard_used.size(); ++i) {
+        if (!guard_used[i]) {
+            fail(root, "guard '" + document.guards[i] +
+                           "' is declared but never used");
+        }
+    }
+
+    if (const Json *map = member(root, "map_states")) {
+        for (const auto &entry :
+             require(*map, Json::OBJECT, "\"map_states\"").members) {
+            document.state_map[entry.first] = states.find(
+                entry.second, name_of(entry.second, "A mapped state"));
+        }
+    }
+    return document;
+}
+
+} // namespace
+
+DefinitionDocument parse_definition(const std::string &text) {
+    JsonParser parser(text);
+    return build_document(parser.parse_document());
+}
+
+DefinitionDocument read_definition_file(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open definition file: " + path);
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    try {
+        return parse_definition(contents.str());
+    } catch (const std::runtime_error &e) {
+        throw std::runtime_error(path + ": " + e.what());
+    }
+}
+
+} // namespace state_machine
@@ -0,0 +1,140 @@
+#include "state_machine/ipc/ingestion_socket.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+constexpr uint16_t FrameBatchHeader::FORMAT_VERSION;
+
+namespace {
+
+std::string system_error(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+sockaddr_un socket_address(const std::string &path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Invalid ingestion socket path '" + path +
+                                 "'");
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+} // namespace
+
+bool parse_frame_batch(const void *data, std::size_t size,
+                       FrameBatchView &view) {
+    if (size < sizeof(FrameBatchHeader))
+        return false;
+    const auto *header = static_cast<const FrameBatchHeader *>(data);
+    if (header->magic != FRAME_BATCH_MAGIC ||
+        header->version != FrameBatchHeader::FORMAT_VERSION ||
+        header->frame_count > MAX_BATCH_FRAMES ||
+        size != sizeof(FrameBatchHeader) +
+                    header->frame_count * sizeof(EventFrame)) {
+        return false;
+    }
+    view.header = header;
+    view.frames = reinterpret_cast<const EventFrame *>(header + 1);
+    view.count = header->frame_count;
+    return true;
+}
+
+int listen_ingestion_socket(const std::string &path) {
+    sockaddr_un address = socket_address(path);
+    int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                      0);
+    if (fd < 0) {
+        throw std::runtime_error(system_error("Cannot create ingestion socket"));
+    }
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<const sockaddr *>(&address),
+               sizeof(address)) < 0 ||
+        ::listen(fd, SOMAXCONN) < 0) {
+        std::string message = system_error("Cannot listen on " + path);
+        ::close(fd);
+        throw std::runtime_error(message);
+    }
+    return fd;
+}
+
+IngestionClient::IngestionClient(const std::string &path)
+    : buffer(MAX_BATCH_BYTES / sizeof(uint64_t)) {
+    sockaddr_un address = socket_address(path);
+    fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error(system_error("Cannot create ingestion socket"));
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr *>(&address),
+                  sizeof(address)) < 0) {
+        std::string message = system_error("Cannot connect to " + path);
+        ::close(fd);
+        throw std::runtime_error(message);
+    }
+}
+
+IngestionClient::~IngestionClient() { ::close(fd); }
+
+uint32_t IngestionClient::send(const EventFrame *frames, std::size_t count,
+                               bool want_reply) {
+    if (count > MAX_BATCH_FRAMES) {
+        throw std::runtime_error("Ingestion batch of " +
+                                 std::to_string(count) + " frames is too large");
+    }
+    FrameBatchHeader header = {};
+    header.magic = FRAME_BATCH_MAGIC;
+    header.version = FrameBatchHeader::FORMAT_VERSION;
+    header.flags = want_reply ? FRAME_BATCH_REPLY : 0;
+    header.frame_count = static_cast<uint32_t>(count);
+    header.sequence = next_sequence++;
+
+    // Header and frames go out as one datagram straight from the caller
+    iovec parts[2];
+    parts[0].iov_base = &header;
+    parts[0].iov_len = sizeof(header);
+    parts[1].iov_base = const_cast<EventFrame *>(frames);
+    parts[1].iov_len = count * sizeof(EventFrame);
+    msghdr message = {};
+    message.msg_iov = parts;
+    message.msg_iovlen = 2;
+    while (::sendmsg(fd, &message, MSG_NOSIGNAL) < 0) {
+        if (errno != EINTR) {
+            throw std::runtime_error(system_error("Ingestion send failed"));
+        }
+    }
+    return header.sequence;
+}
+
+uint32_t IngestionClient::receive_reply(std::vector<StateFrame> &states) {
+    ssize_t bytes;
+    while ((bytes = ::recv(fd, buffer.data(), MAX_BATCH_BYTES, 0)) < 0) {
+        if (errno != EINTR) {
+            throw std::runtime_error(system_error("Ingestion receive failed"));
+        }
+    }
+    if (bytes == 0) {
+        throw std::runtime_error("Ingestion server closed the connection");
+    }
+
+    const auto *header = reinterpret_cast<const FrameBatchHeader *>(buffer.data());
+    auto size = static_cast<std::size_t>(bytes);
+    if (size < sizeof(FrameBatchHeader) || header->magic != STATE_BATCH_MAGIC ||
+        size != sizeof(FrameBatchHeader) +
+                    header->frame_count * sizeof(StateFrame)) {
+        throw std::runtime_error("Malformed ingestion reply");
+    }
+    const auto *first = reinterpret_cast<const StateFrame *>(header + 1);
+    states.assign(first, first + header->frame_count);
+    return header->sequence;
+}
+
+} // namespace state_machine
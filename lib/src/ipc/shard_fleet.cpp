@@ -0,0 +1,241 @@
+#include "state_machine/ipc/shard_fleet.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+namespace {
+
+std::string system_error(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+// The shard child's last words; it exits without unwinding
+void report_failure(std::size_t shard, const char *what) {
+    std::string message =
+        "Shard " + std::to_string(shard) + " failed: " + what + "\n";
+    ssize_t written = ::write(STDERR_FILENO, message.data(), message.size());
+    (void)written;
+}
+
+// Spreads sequential ids evenly (splitmix64 finaliser)
+uint64_t mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+} // namespace
+
+FleetCoordinator::FleetCoordinator(FleetOptions fleet_options, ShardMain main)
+    : options(std::move(fleet_options)), shard_main(std::move(main)) {
+    if (options.shard_count == 0) {
+        throw std::runtime_error("A fleet needs at least one shard");
+    }
+
+    std::size_t size = options.shard_count * sizeof(ShardControl);
+    control_mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (control_mapping == MAP_FAILED) {
+        throw std::runtime_error(system_error("Cannot map shard counters"));
+    }
+    controls = static_cast<ShardControl *>(control_mapping);
+    for (std::size_t shard = 0; shard < options.shard_count; ++shard) {
+        new (&controls[shard]) ShardControl();
+        controls[shard].pid.store(0);
+        controls[shard].received.store(0);
+        controls[shard].unrouted.store(0);
+        controls[shard].handled.store(0);
+        controls[shard].heartbeat_ns.store(0);
+        controls[shard].stop.store(0);
+    }
+
+    try {
+        for (std::size_t shard = 0; shard < options.shard_count; ++shard) {
+            rings.emplace_back(new ShmFrameRing(options.ring_capacity));
+        }
+        if (!options.board_name.empty()) {
+            board = StateBoard::create(options.board_name,
+                                       options.instance_count);
+        }
+    } catch (...) {
+        ::munmap(control_mapping, size);
+        throw;
+    }
+
+    owned.resize(options.shard_count);
+    for (std::size_t id = 0; id < options.instance_count; ++id) {
+        owned[shard_of(static_cast<uint32_t>(id))].push_back(
+            static_cast<uint32_t>(id));
+    }
+    pids.assign(options.shard_count, 0);
+    restarts.reset(new std::atomic<uint64_t>[options.shard_count]);
+    for (std::size_t shard = 0; shard < options.shard_count; ++shard) {
+        restarts[shard].store(0, std::memory_order_relaxed);
+    }
+    outgoing.resize(options.shard_count);
+}
+
+FleetCoordinator::~FleetCoordinator() {
+    stop();
+    ::munmap(control_mapping, options.shard_count * sizeof(ShardControl));
+}
+
+void FleetCoordinator::start() {
+    for (std::size_t shard = 0; shard < options.shard_count; ++shard) {
+        if (pids[shard] == 0) {
+            spawn(shard);
+        }
+    }
+}
+
+void FleetCoordinator::stop() {
+    for (std::size_t shard = 0; shard < options.shard_count; ++shard) {
+        if (pids[shard] != 0) {
+            controls[shard].stop.store(1, std::memory_order_release);
+            rings[shard]->notify();
+        }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + options.stop_timeout;
+    for (std::size_t shard = 0; shard < options.shard_count; ++shard) {
+        if (pids[shard] == 0)
+            continue;
+        while (::waitpid(pids[shard], nullptr, WNOHANG) == 0) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                ::kill(pids[shard], SIGKILL);
+                ::waitpid(pids[shard], nullptr, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        pids[shard] = 0;
+    }
+}
+
+std::size_t FleetCoordinator::route(const EventFrame *frames,
+                                    std::size_t count) {
+    std::lock_guard<std::mutex> lock(route_mutex);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (frames[i].instance_id < options.instance_count) {
+            outgoing[shard_of(frames[i].instance_id)].push_back(frames[i]);
+        }
+    }
+
+    std::size_t accepted = 0;
+    for (std::size_t shard = 0; shard < options.shard_count; ++shard) {
+        auto &share = outgoing[shard];
+        if (share.empty())
+            continue;
+        // One wakeup per shard per batch
+        accepted += rings[shard]->push(share.data(), share.size());
+        rings[shard]->notify();
+        share.clear();
+    }
+    return accepted;
+}
+
+std::size_t FleetCoordinator::restart_failed() {
+    std::size_t restarted = 0;
+    for (std::size_t shard = 0; shard < options.shard_count; ++shard) {
+        if (pids[shard] == 0 || ::waitpid(pids[shard], nullptr, WNOHANG) == 0)
+            continue;
+        // Frames still in the ring wait for the replacement
+        restarts[shard].fetch_add(1, std::memory_order_relaxed);
+        spawn(shard);
+        ++restarted;
+    }
+    return restarted;
+}
+
+bool FleetCoordinator::query(uint32_t instance_id,
+                             StateBoardEntry &entry) const {
+    if (!board || instance_id >= options.instance_count)
+        return false;
+    return board->read(instance_id, entry);
+}
+
+std::vector<std::size_t>
+FleetCoordinator::register_metrics(MetricsRegistry &registry,
+                                   const MetricLabels &labels) {
+    // Readers point into the coordinator, which must outlive them
+    std::vector<std::size_t> ids;
+    for (std::size_t shard = 0; shard < options.shard_count; ++shard) {
+        MetricLabels shard_labels = labels;
+        shard_labels.emplace_back("shard", std::to_string(shard));
+        const ShardControl *control = &controls[shard];
+        const ShmFrameRing *ring = rings[shard].get();
+
+        ids.push_back(registry.add(
+            "state_machine_shard_frames_received_total",
+            "Event frames a shard took off its ring", MetricType::COUNTER,
+            shard_labels, [control]() {
+                return static_cast<double>(
+                    control->received.load(std::memory_order_relaxed));
+            }));
+        ids.push_back(registry.add(
+            "state_machine_shard_events_handled_total",
+            "Events handled by a shard's executor", MetricType::COUNTER,
+            shard_labels, [control]() {
+                return static_cast<double>(
+                    control->handled.load(std::memory_order_relaxed));
+            }));
+        ids.push_back(registry.add(
+            "state_machine_shard_frames_dropped_total",
+            "Event frames that did not fit a shard's ring", MetricType::COUNTER,
+            shard_labels,
+            [ring]() { return static_cast<double>(ring->get_dropped()); }));
+        ids.push_back(registry.add(
+            "state_machine_shard_ring_depth", "Event frames waiting in a ring",
+            MetricType::GAUGE, shard_labels,
+            [ring]() { return static_cast<double>(ring->size()); }));
+        ids.push_back(registry.add(
+            "state_machine_shard_restarts_total",
+            "Times a shard process was replaced", MetricType::COUNTER,
+            shard_labels, [this, shard]() {
+                return static_cast<double>(
+                    restarts[shard].load(std::memory_order_relaxed));
+            }));
+    }
+    return ids;
+}
+
+std::size_t FleetCoordinator::shard_of(uint32_t instance_id) const {
+    return static_cast<std::size_t>(mix(instance_id) % options.shard_count);
+}
+
+void FleetCoordinator::spawn(std::size_t shard) {
+    controls[shard].stop.store(0, std::memory_order_release);
+    pid_t pid = ::fork();
+    if (pid < 0) {
+        throw std::runtime_error(system_error("Cannot fork shard " +
+                                              std::to_string(shard)));
+    }
+    if (pid == 0) {
+        // The child never returns into the coordinator's stack
+        int status = 1;
+        try {
+            ShardContext context = {shard,        options.shard_count,
+                                    owned[shard], rings[shard].get(),
+                                    &controls[shard], board};
+            status = shard_main(context);
+        } catch (const std::exception &e) {
+            report_failure(shard, e.what());
+        } catch (...) {
+            report_failure(shard, "unknown exception");
+        }
+        ::_exit(status);
+    }
+    pids[shard] = pid;
+}
+
+} // namespace state_machine
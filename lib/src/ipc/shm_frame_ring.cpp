@@ -0,0 +1,110 @@
+#include "state_machine/ipc/shm_frame_ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+namespace {
+
+std::string system_error(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+ShmFrameRing::ShmFrameRing(std::size_t capacity) {
+    if (capacity == 0) {
+        capacity = 1;
+    }
+    mapping_size = sizeof(Header) + capacity * sizeof(EventFrame);
+    mapping = ::mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error(system_error("Cannot map frame ring"));
+    }
+    event_fd = ::eventfd(0, EFD_NONBLOCK);
+    if (event_fd < 0) {
+        std::string message = system_error("Cannot create frame ring eventfd");
+        ::munmap(mapping, mapping_size);
+        throw std::runtime_error(message);
+    }
+
+    header = new (mapping) Header();
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    header->capacity = capacity;
+    header->dropped.store(0, std::memory_order_relaxed);
+    frames = reinterpret_cast<EventFrame *>(header + 1);
+}
+
+ShmFrameRing::~ShmFrameRing() {
+    ::close(event_fd);
+    ::munmap(mapping, mapping_size);
+}
+
+std::size_t ShmFrameRing::push(const EventFrame *source, std::size_t count) {
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    uint64_t tail = header->tail.load(std::memory_order_acquire);
+    uint64_t capacity = header->capacity;
+    auto room = static_cast<std::size_t>(capacity - (head - tail));
+    std::size_t written = std::min(count, room);
+
+    // At most two copies, split where the ring wraps
+    std::size_t start = static_cast<std::size_t>(head % capacity);
+    std::size_t first = std::min(written, static_cast<std::size_t>(capacity) - start);
+    std::memcpy(frames + start, source, first * sizeof(EventFrame));
+    std::memcpy(frames, source + first, (written - first) * sizeof(EventFrame));
+    header->head.store(head + written, std::memory_order_release);
+
+    if (written < count) {
+        header->dropped.fetch_add(count - written, std::memory_order_relaxed);
+    }
+    return written;
+}
+
+std::size_t ShmFrameRing::pop(EventFrame *out, std::size_t max_count) {
+    uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    uint64_t capacity = header->capacity;
+    std::size_t read =
+        std::min(max_count, static_cast<std::size_t>(head - tail));
+
+    std::size_t start = static_cast<std::size_t>(tail % capacity);
+    std::size_t first = std::min(read, static_cast<std::size_t>(capacity) - start);
+    std::memcpy(out, frames + start, first * sizeof(EventFrame));
+    std::memcpy(out + first, frames, (read - first) * sizeof(EventFrame));
+    header->tail.store(tail + read, std::memory_order_release);
+    return read;
+}
+
+void ShmFrameRing::notify() {
+    uint64_t one = 1;
+    while (::write(event_fd, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+}
+
+uint64_t ShmFrameRing::take_notifications() {
+    uint64_t count = 0;
+    while (::read(event_fd, &count, sizeof(count)) < 0) {
+        if (errno != EINTR)
+            return 0;
+    }
+    return count;
+}
+
+std::size_t ShmFrameRing::size() const {
+    return static_cast<std::size_t>(
+        header->head.load(std::memory_order_acquire) -
+        header->tail.load(std::memory_order_acquire));
+}
+
+} // namespace state_machine
@@ -0,0 +1,120 @@
+#include "state_machine/memory/memory_resource.h"
+
+#ifndef STATE_MACHINE_STD_PMR
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+namespace state_machine {
+namespace pmr {
+
+constexpr std::size_t memory_resource::max_align;
+constexpr std::size_t monotonic_buffer_resource::DEFAULT_CHUNK_SIZE;
+
+namespace {
+
+class NewDeleteResource : public memory_resource {
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        // Plain operator new already honours max_align_t; the over-aligned
+        // overloads only arrive with C++17
+        if (alignment > max_align)
+            throw std::bad_alloc();
+        return ::operator new(bytes);
+    }
+
+    void do_deallocate(void *p, std::size_t, std::size_t) override {
+        ::operator delete(p);
+    }
+
+    bool do_is_equal(const memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+std::atomic<memory_resource *> default_resource{nullptr};
+
+} // namespace
+
+memory_resource *new_delete_resource() noexcept {
+    static NewDeleteResource resource;
+    return &resource;
+}
+
+memory_resource *get_default_resource() noexcept {
+    memory_resource *resource =
+        default_resource.load(std::memory_order_acquire);
+    return resource ? resource : new_delete_resource();
+}
+
+memory_resource *set_default_resource(memory_resource *resource) noexcept {
+    memory_resource *previous =
+        default_resource.exchange(resource, std::memory_order_acq_rel);
+    return previous ? previous : new_delete_resource();
+}
+
+monotonic_buffer_resource::monotonic_buffer_resource(
+    memory_resource *upstream)
+    : monotonic_buffer_resource(DEFAULT_CHUNK_SIZE, upstream) {}
+
+monotonic_buffer_resource::monotonic_buffer_resource(
+    std::size_t initial_size, memory_resource *upstream)
+    : upstream(upstream),
+      first_size(std::max<std::size_t>(initial_size, 64)),
+      next_size(first_size) {}
+
+monotonic_buffer_resource::monotonic_buffer_resource(
+    void *buffer, std::size_t buffer_size, memory_resource *upstream)
+    : upstream(upstream), initial_buffer(buffer), initial_size(buffer_size),
+      current(static_cast<char *>(buffer)), remaining(buffer_size),
+      first_size(std::max<std::size_t>(buffer_size * 2, DEFAULT_CHUNK_SIZE)),
+      next_size(first_size) {}
+
+monotonic_buffer_resource::~monotonic_buffer_resource() { release(); }
+
+void monotonic_buffer_resource::release() {
+    while (chunks) {
+        Chunk *next = chunks->next;
+        upstream->deallocate(chunks, chunks->size, max_align);
+        chunks = next;
+    }
+    current = static_cast<char *>(initial_buffer);
+    remaining = initial_size;
+    next_size = first_size;
+}
+
+void *monotonic_buffer_resource::do_allocate(std::size_t bytes,
+                                             std::size_t alignment) {
+    if (bytes == 0)
+        bytes = 1;
+    auto address = reinterpret_cast<std::uintptr_t>(current);
+    std::size_t padding = (alignment - address % alignment) % alignment;
+    if (!current || padding > remaining || bytes > remaining - padding) {
+        // The header keeps max_align_t alignment for what follows it
+        std::size_t header =
+            (sizeof(Chunk) + max_align - 1) / max_align * max_align;
+        std::size_t needed = header + bytes + alignment;
+        std::size_t size = std::max(next_size, needed);
+        auto *chunk =
+            static_cast<Chunk *>(upstream->allocate(size, max_align));
+        chunk->next = chunks;
+        chunk->size = size;
+        chunks = chunk;
+        current = reinterpret_cast<char *>(chunk) + header;
+        remaining = size - header;
+        next_size = size * 2;
+
+        address = reinterpret_cast<std::uintptr_t>(current);
+        padding = (alignment - address % alignment) % alignment;
+    }
+    void *result = current + padding;
+    current += padding + bytes;
+    remaining -= padding + bytes;
+    return result;
+}
+
+} // namespace pmr
+} // namespace state_machine
+
+#endif // STATE_MACHINE_STD_PMR
@@ -0,0 +1,113 @@
+#include "state_machine/metrics/latency_histogram.h"
+
+#include <new>
+#include <vector>
+
+namespace state_machine {
+
+constexpr unsigned LatencyHistogram::SUB_BUCKET_BITS;
+constexpr std::size_t LatencyHistogram::SUB_BUCKETS;
+constexpr unsigned LatencyHistogram::MAX_EXPONENT;
+constexpr std::size_t LatencyHistogram::BUCKET_COUNT;
+constexpr std::size_t LatencyHistogram::SHARDS;
+
+// Shards hold only atomics and bytes, so nothing needs destroying
+LatencyHistogram::~LatencyHistogram() {
+    Shard *all = shards.load(std::memory_order_acquire);
+    if (all) {
+        resource->deallocate(all, SHARDS * sizeof(Shard), alignof(Shard));
+    }
+}
+
+LatencyHistogram::Shard *LatencyHistogram::allocate_shards() {
+    Shard *fresh = static_cast<Shard *>(
+        resource->allocate(SHARDS * sizeof(Shard), alignof(Shard)));
+    for (std::size_t s = 0; s < SHARDS; ++s) {
+        new (&fresh[s]) Shard();
+    }
+    Shard *expected = nullptr;
+    if (shards.compare_exchange_strong(expected, fresh,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+        return fresh;
+    }
+    resource->deallocate(fresh, SHARDS * sizeof(Shard), alignof(Shard));
+    return expected;
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(std::size_t bucket) {
+    if (bucket < SUB_BUCKETS)
+        return bucket;
+    std::size_t group = bucket / SUB_BUCKETS;
+    uint64_t sub = bucket % SUB_BUCKETS;
+    uint64_t lower = (SUB_BUCKETS + sub) << (group - 1);
+    return lower + (uint64_t(1) << (group - 1)) - 1;
+}
+
+LatencySnapshot LatencyHistogram::snapshot() const {
+    LatencySnapshot result;
+    const Shard *all = shards.load(std::memory_order_acquire);
+    if (!all)
+        return result;
+
+    std::vector<uint64_t> merged(BUCKET_COUNT, 0);
+    uint64_t total_ns = 0;
+    for (std::size_t s = 0; s < SHARDS; ++s) {
+        const Shard &shard = all[s];
+        for (std::size_t b = 0; b < BUCKET_COUNT; ++b) {
+            uint64_t hits = shard.buckets[b].load(std::memory_order_relaxed);
+            merged[b] += hits;
+            result.count += hits;
+        }
+        total_ns += shard.total_ns.load(std::memory_order_relaxed);
+        uint64_t max_ns = shard.max_ns.load(std::memory_order_relaxed);
+        if (max_ns > result.max_ns) {
+            result.max_ns = max_ns;
+        }
+    }
+
+    if (result.count == 0)
+        return result;
+
+    result.mean_ns = static_cast<double>(total_ns) / result.count;
+
+    // Rank of the value at or below which the given fraction of samples lie
+    auto rank = [&result](uint64_t per_thousand) {
+        return (result.count * per_thousand + 999) / 1000;
+    };
+    const uint64_t ranks[] = {rank(500), rank(990), rank(999)};
+    uint64_t *targets[] = {&result.p50_ns, &result.p99_ns, &result.p999_ns};
+
+    uint64_t seen = 0;
+    std::size_t next = 0;
+    for (std::size_t b = 0; b < BUCKET_COUNT && next < 3; ++b) {
+        seen += merged[b];
+        while (next < 3 && seen >= ranks[next]) {
+            *targets[next++] = bucket_upper_bound(b);
+        }
+    }
+
+    // Bucket bounds can overshoot the largest recorded value
+    for (uint64_t *target : targets) {
+        if (*target > result.max_ns) {
+            *target = result.max_ns;
+        }
+    }
+    return result;
+}
+
+void LatencyHistogram::reset() {
+    Shard *all = shards.load(std::memory_order_acquire);
+    if (!all)
+        return;
+    for (std::size_t s = 0; s < SHARDS; ++s) {
+        Shard &shard = all[s];
+        for (auto &bucket : shard.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        shard.total_ns.store(0, std::memory_order_relaxed);
+        shard.max_ns.store(0, std::memory_order_relaxed);
+    }
+}
+
+} // namespace state_machine
@@ -0,0 +1,136 @@
+#include "state_machine/metrics/metrics_exporter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+namespace {
+
+// How often the server thread checks for stop()
+constexpr int ACCEPT_POLL_MS = 100;
+// How long to wait for a client to send a request line
+constexpr int REQUEST_WAIT_MS = 50;
+
+std::string system_error(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+bool send_fully(int fd, const char *data, std::size_t size) {
+    while (size > 0) {
+        ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+} // namespace
+
+MetricsExporter::MetricsExporter(
+    std::shared_ptr<MetricsRegistry> metrics_registry, std::string path)
+    : registry(std::move(metrics_registry)), socket_path(std::move(path)) {}
+
+MetricsExporter::~MetricsExporter() { stop(); }
+
+void MetricsExporter::start() {
+    if (running)
+        return;
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Metrics socket path too long: " +
+                                 socket_path);
+    }
+    std::strncpy(address.sun_path, socket_path.c_str(),
+                 sizeof(address.sun_path) - 1);
+
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error(system_error("Cannot create metrics socket"));
+    }
+
+    ::unlink(socket_path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&address),
+               sizeof(address)) < 0 ||
+        ::listen(listen_fd, 16) < 0) {
+        std::string message =
+            system_error("Cannot listen on metrics socket " + socket_path);
+        ::close(listen_fd);
+        listen_fd = -1;
+        throw std::runtime_error(message);
+    }
+
+    running = true;
+    server_thread = std::thread(&MetricsExporter::serve_loop, this);
+}
+
+void MetricsExporter::stop() {
+    running = false;
+    if (server_thread.joinable()) {
+        server_thread.join();
+    }
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+        listen_fd = -1;
+        ::unlink(socket_path.c_str());
+    }
+}
+
+void MetricsExporter::serve_loop() {
+    pollfd listener = {listen_fd, POLLIN, 0};
+    while (running) {
+        int ready = ::poll(&listener, 1, ACCEPT_POLL_MS);
+        if (ready <= 0)
+            continue;
+
+        int client_fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_fd < 0)
+            continue;
+        serve_client(client_fd);
+        ::close(client_fd);
+    }
+}
+
+void MetricsExporter::serve_client(int client_fd) {
+    // Peek at the request to decide between HTTP and bare text
+    char request[1024];
+    ssize_t received = 0;
+    pollfd client = {client_fd, POLLIN, 0};
+    if (::poll(&client, 1, REQUEST_WAIT_MS) > 0) {
+        received = ::recv(client_fd, request, sizeof(request), 0);
+    }
+    bool http = received >= 4 && (std::memcmp(request, "GET ", 4) == 0 ||
+                                  std::memcmp(request, "HEAD", 4) == 0);
+
+    std::string body = registry->render();
+    scrapes.fetch_add(1, std::memory_order_relaxed);
+
+    if (http) {
+        std::string head =
+            "HTTP/1.0 200 OK\r\n"
+            "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+            "Content-Length: " +
+            std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+        if (!send_fully(client_fd, head.data(), head.size()))
+            return;
+        if (std::memcmp(request, "HEAD", 4) == 0)
+            return;
+    }
+    send_fully(client_fd, body.data(), body.size());
+}
+
+} // namespace state_machine
@@ -0,0 +1,138 @@
+#include "state_machine/metrics/metrics_registry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+namespace state_machine {
+
+namespace {
+
+bool valid_name(const std::string &name) {
+    if (name.empty())
+        return false;
+    for (std::size_t i = 0; i < name.size(); ++i) {
+        char c = name[i];
+        bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                     c == '_' || c == ':';
+        if (!alpha && !(i > 0 && c >= '0' && c <= '9'))
+            return false;
+    }
+    return true;
+}
+
+void write_escaped(std::ostream &os, const std::string &value,
+                   bool escape_quotes) {
+    for (char c : value) {
+        if (c == '\\') {
+            os << "\\\\";
+        } else if (c == '\n') {
+            os << "\\n";
+        } else if (c == '"' && escape_quotes) {
+            os << "\\\"";
+        } else {
+            os << c;
+        }
+    }
+}
+
+void write_value(std::ostream &os, double value) {
+    if (std::isnan(value)) {
+        os << "NaN";
+    } else if (std::isinf(value)) {
+        os << (value > 0 ? "+Inf" : "-Inf");
+    } else if (value == std::floor(value) && std::fabs(value) < 9e15) {
+        os << static_cast<int64_t>(value);
+    } else {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+        os << buffer;
+    }
+}
+
+} // namespace
+
+std::size_t MetricsRegistry::add(const std::string &name,
+                                 const std::string &help, MetricType type,
+                                 MetricLabels labels, Reader reader) {
+    if (!valid_name(name)) {
+        throw std::runtime_error("Invalid metric name: " + name);
+    }
+    for (const auto &label : labels) {
+        if (!valid_name(label.first) || label.first.find(':') !=
+                                            std::string::npos) {
+            throw std::runtime_error("Invalid label name: " + label.first);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto family = std::find_if(
+        families.begin(), families.end(),
+        [&name](const Family &candidate) { return candidate.name == name; });
+    if (family == families.end()) {
+        families.push_back({name, help, type, {}});
+        family = families.end() - 1;
+    } else if (family->type != type) {
+        throw std::runtime_error("Metric registered with another type: " +
+                                 name);
+    }
+
+    std::size_t id = next_id++;
+    family->samples.push_back({id, std::move(labels), std::move(reader)});
+    return id;
+}
+
+void MetricsRegistry::remove(std::size_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto family = families.begin(); family != families.end(); ++family) {
+        auto &samples = family->samples;
+        auto sample = std::find_if(
+            samples.begin(), samples.end(),
+            [id](const Sample &candidate) { return candidate.id == id; });
+        if (sample != samples.end()) {
+            samples.erase(sample);
+            if (samples.empty()) {
+                families.erase(family);
+            }
+            return;
+        }
+    }
+}
+
+void MetricsRegistry::render(std::ostream &os) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &family : families) {
+        os << "# HELP " << family.name << " ";
+        write_escaped(os, family.help, false);
+        os << "\n# TYPE " << family.name << " "
+           << (family.type == MetricType::COUNTER ? "counter" : "gauge")
+           << "\n";
+
+        for (const auto &sample : family.samples) {
+            os << family.name;
+            if (!sample.labels.empty()) {
+                os << "{";
+                for (std::size_t i = 0; i < sample.labels.size(); ++i) {
+                    os << (i ? "," : "") << sample.labels[i].first << "=\"";
+                    write_escaped(os, sample.labels[i].second, true);
+                    os << "\"";
+                }
+                os << "}";
+            }
+            os << " ";
+            write_value(os, sample.reader ? sample.reader() : 0.0);
+            os << "\n";
+        }
+    }
+}
+
+std::string MetricsRegistry::render() const {
+    std::ostringstream os;
+    render(os);
+    return os.str();
+}
+
+} // namespace state_machine
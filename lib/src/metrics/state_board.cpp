@@ -0,0 +1,258 @@
+#include "state_machine/metrics/state_board.h"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+namespace {
+
+// Slots start on their own cache line after the header
+constexpr std::size_t SLOTS_OFFSET = 64;
+// Torn reads are retried this many times before a slot is reported busy;
+// bounded because a writer that died mid-publish leaves the slot odd
+constexpr int READ_ATTEMPTS = 1024;
+
+std::string system_error(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+// Slots left behind by a crashed process may be claimed again
+bool owner_gone(uint64_t pid) {
+    return ::kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH;
+}
+
+} // namespace
+
+constexpr uint64_t StateBoard::MAGIC;
+constexpr uint32_t StateBoard::VERSION;
+
+StateBoard::StateBoard(const std::string &name, bool create,
+                       bool writable_mapping, std::size_t slot_count)
+    : segment_name(name), owner(create), writable(writable_mapping) {
+    static_assert(sizeof(Header) <= SLOTS_OFFSET, "Header overlaps slots");
+    static_assert(sizeof(Slot) == 64, "Slot must fill one cache line");
+
+    int fd;
+    if (create) {
+        ::shm_unlink(name.c_str());
+        fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC,
+                        0644);
+    } else {
+        fd = ::shm_open(name.c_str(),
+                        (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC, 0);
+    }
+    if (fd < 0) {
+        throw std::runtime_error(
+            system_error("Cannot open state board " + name));
+    }
+
+    if (create) {
+        mapping_size = SLOTS_OFFSET + slot_count * sizeof(Slot);
+        if (::ftruncate(fd, static_cast<off_t>(mapping_size)) != 0) {
+            std::string message =
+                system_error("Cannot size state board " + name);
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::runtime_error(message);
+        }
+    } else {
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            std::string message =
+                system_error("Cannot stat state board " + name);
+            ::close(fd);
+            throw std::runtime_error(message);
+        }
+        mapping_size = static_cast<std::size_t>(info.st_size);
+        if (mapping_size < SLOTS_OFFSET) {
+            ::close(fd);
+            throw std::runtime_error("Truncated state board: " + name);
+        }
+    }
+
+    mapping = ::mmap(nullptr, mapping_size,
+                     writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED,
+                     fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        if (create) {
+            ::shm_unlink(name.c_str());
+        }
+        throw std::runtime_error(
+            system_error("Cannot map state board " + name));
+    }
+
+    header = static_cast<Header *>(mapping);
+    slots = reinterpret_cast<Slot *>(static_cast<char *>(mapping) +
+                                     SLOTS_OFFSET);
+
+    if (create) {
+        // The segment is zero-filled: every slot starts free
+        header->version = VERSION;
+        header->slot_count = static_cast<uint32_t>(slot_count);
+        header->magic.store(MAGIC, std::memory_order_release);
+        return;
+    }
+
+    std::string problem;
+    if (header->magic.load(std::memory_order_acquire) != MAGIC) {
+        problem = "Not an initialized state board: ";
+    } else if (header->version != VERSION) {
+        problem = "Unsupported state board version: ";
+    } else if (mapping_size <
+               SLOTS_OFFSET + header->slot_count * sizeof(Slot)) {
+        problem = "Truncated state board: ";
+    }
+    if (!problem.empty()) {
+        ::munmap(mapping, mapping_size);
+        mapping = nullptr;
+        throw std::runtime_error(problem + name);
+    }
+}
+
+std::unique_ptr<StateBoard> StateBoard::create(const std::string &name,
+                                               std::size_t slot_count) {
+    return std::unique_ptr<StateBoard>(
+        new StateBoard(name, true, true, slot_count));
+}
+
+std::unique_ptr<StateBoard> StateBoard::open(const std::string &name,
+                                             bool writable) {
+    return std::unique_ptr<StateBoard>(
+        new StateBoard(name, false, writable, 0));
+}
+
+StateBoard::~StateBoard() {
+    if (mapping) {
+        ::munmap(mapping, mapping_size);
+    }
+    if (owner) {
+        ::shm_unlink(segment_name.c_str());
+    }
+}
+
+std::size_t StateBoard::claim_slot(const std::string &instance_name,
+                                   std::size_t first_slot) {
+    if (!writable) {
+        throw std::runtime_error("State board " + segment_name +
+                                 " is mapped read-only");
+    }
+
+    uint64_t pid = static_cast<uint64_t>(::getpid());
+    std::size_t count = get_slot_count();
+    for (std::size_t probe = 0; probe < count; ++probe) {
+        std::size_t index = (first_slot + probe) % count;
+        Slot &slot = slots[index];
+        uint64_t expected = 0;
+        if (!slot.owner.compare_exchange_strong(expected, pid) &&
+            !(owner_gone(expected) &&
+              slot.owner.compare_exchange_strong(expected, pid)))
+            continue;
+
+        uint64_t name_words[3] = {};
+        std::strncpy(reinterpret_cast<char *>(name_words),
+                     instance_name.c_str(), sizeof(name_words) - 1);
+
+        // A previous owner killed inside publish() left the sequence odd;
+        // round it up so readers see this write complete
+        uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        sequence = (sequence + 1) & ~uint64_t(1);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < 3; ++i) {
+            slot.name[i].store(name_words[i], std::memory_order_relaxed);
+        }
+        slot.state.store(0, std::memory_order_relaxed);
+        slot.transitions.store(0, std::memory_order_relaxed);
+        slot.updated_ns.store(now_ns(), std::memory_order_relaxed);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        return index;
+    }
+    throw std::runtime_error("State board " + segment_name + " is full");
+}
+
+void StateBoard::release_slot(std::size_t slot) {
+    if (slot < get_slot_count()) {
+        slots[slot].owner.store(0, std::memory_order_release);
+    }
+}
+
+void StateBoard::publish(std::size_t index, uint32_t state,
+                         uint64_t transitions) {
+    Slot &slot = slots[index];
+    // Read the clock outside the odd window to keep readers retrying less
+    uint64_t updated = now_ns();
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.state.store(state, std::memory_order_relaxed);
+    slot.transitions.store(transitions, std::memory_order_relaxed);
+    slot.updated_ns.store(updated, std::memory_order_relaxed);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool StateBoard::read(std::size_t index, StateBoardEntry &entry) const {
+    if (index >= get_slot_count())
+        return false;
+
+    const Slot &slot = slots[index];
+    for (int attempt = 0; attempt < READ_ATTEMPTS; ++attempt) {
+        uint64_t pid = slot.owner.load(std::memory_order_acquire);
+        if (pid == 0)
+            return false;
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+
+        uint64_t name_words[3];
+        uint64_t state = slot.state.load(std::memory_order_relaxed);
+        uint64_t transitions = slot.transitions.load(std::memory_order_relaxed);
+        uint64_t updated = slot.updated_ns.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < 3; ++i) {
+            name_words[i] = slot.name[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before)
+            continue;
+
+        entry.slot = index;
+        entry.owner_pid = static_cast<uint32_t>(pid);
+        entry.state = static_cast<uint32_t>(state);
+        entry.transitions = transitions;
+        entry.updated_ns = updated;
+        std::memcpy(entry.name, name_words, sizeof(entry.name));
+        entry.name[sizeof(entry.name) - 1] = '\0';
+        return true;
+    }
+    return false;
+}
+
+std::vector<StateBoardEntry> StateBoard::snapshot() const {
+    std::vector<StateBoardEntry> entries;
+    StateBoardEntry entry;
+    for (std::size_t index = 0; index < get_slot_count(); ++index) {
+        if (read(index, entry)) {
+            entries.push_back(entry);
+        }
+    }
+    return entries;
+}
+
+} // namespace state_machine
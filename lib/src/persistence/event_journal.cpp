@@ -0,0 +1,338 @@
+#include "state_machine/persistence/event_journal.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+namespace {
+
+const char *const SEGMENT_PREFIX = "journal-";
+const char *const SEGMENT_SUFFIX = ".seg";
+
+std::string system_error(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+std::string segment_path(const std::string &directory, uint64_t index) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s%08llu%s", SEGMENT_PREFIX,
+                  static_cast<unsigned long long>(index), SEGMENT_SUFFIX);
+    return directory + "/" + name;
+}
+
+// Returns segment indexes found in directory, sorted ascending
+std::vector<uint64_t> list_segments(const std::string &directory) {
+    std::vector<uint64_t> indexes;
+    DIR *dir = opendir(directory.c_str());
+    if (!dir)
+        return indexes;
+
+    const std::size_t prefix_len = std::strlen(SEGMENT_PREFIX);
+    const std::size_t suffix_len = std::strlen(SEGMENT_SUFFIX);
+    while (dirent *entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() <= prefix_len + suffix_len ||
+            name.compare(0, prefix_len, SEGMENT_PREFIX) != 0 ||
+            name.compare(name.size() - suffix_len, suffix_len,
+                         SEGMENT_SUFFIX) != 0)
+            continue;
+
+        std::string digits =
+            name.substr(prefix_len, name.size() - prefix_len - suffix_len);
+        if (digits.empty() ||
+            !std::all_of(digits.begin(), digits.end(), ::isdigit))
+            continue;
+        indexes.push_back(std::stoull(digits));
+    }
+    closedir(dir);
+
+    std::sort(indexes.begin(), indexes.end());
+    return indexes;
+}
+
+void write_fully(int fd, const char *data, std::size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t written = ::pwrite(fd, data, size, offset);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(system_error("Journal write failed"));
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+        offset += written;
+    }
+}
+
+} // namespace
+
+uint32_t journal_checksum(const JournalRecord &record) {
+    // FNV-1a over the fields preceding the checksum
+    const auto *bytes = reinterpret_cast<const unsigned char *>(&record);
+    uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < offsetof(JournalRecord, checksum); ++i) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+EventJournal::EventJournal(const std::string &journal_directory,
+                           const JournalOptions &journal_options)
+    : directory(journal_directory), options(journal_options) {
+
+    if (options.group_commit_events == 0) {
+        options.group_commit_events = 1;
+    }
+    // Segments always hold a whole number of records
+    options.segment_size -= options.segment_size % sizeof(JournalRecord);
+    if (options.segment_size == 0) {
+        options.segment_size = sizeof(JournalRecord);
+    }
+
+    if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error(
+            system_error("Cannot create journal directory: " + directory));
+    }
+
+    // Never append into a segment that may hold a torn tail from a crash
+    auto existing = list_segments(directory);
+    segment_index = existing.empty() ? 0 : existing.back() + 1;
+    open_next_segment();
+
+    pending.reserve(options.group_commit_events * 2);
+    writing.reserve(options.group_commit_events * 2);
+
+    committer = std::thread(&EventJournal::committer_loop, this);
+}
+
+EventJournal::~EventJournal() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    commit_cv.notify_one();
+
+    if (committer.joinable())
+        committer.join();
+
+    close_segment();
+}
+
+void EventJournal::append(uint32_t instance_id, uint16_t event,
+                          uint16_t from_state, uint16_t to_state) {
+    JournalRecord record;
+    record.timestamp_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
+    record.instance_id = instance_id;
+    record.event = event;
+    record.from_state = from_state;
+    record.to_state = to_state;
+    record.marker = JournalRecord::JOURNAL_RECORD_MARKER;
+    record.checksum = journal_checksum(record);
+
+    bool wake_committer = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (failure)
+            std::rethrow_exception(failure);
+        if (pending.empty()) {
+            // Start the commit budget with the first record of a batch
+            first_pending_time = std::chrono::steady_clock::now();
+            wake_committer = true;
+        }
+        pending.push_back(record);
+        ++appended_count;
+        if (pending.size() >= options.group_commit_events) {
+            wake_committer = true;
+        }
+    }
+
+    if (wake_committer)
+        commit_cv.notify_one();
+}
+
+void EventJournal::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t target = appended_count;
+    if (durable_count < target && !failure) {
+        flush_requested = true;
+        commit_cv.notify_one();
+        durable_cv.wait(lock, [this, target] {
+            return durable_count >= target || failure;
+        });
+    }
+    if (failure)
+        std::rethrow_exception(failure);
+}
+
+uint64_t EventJournal::get_appended_count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return appended_count;
+}
+
+uint64_t EventJournal::get_durable_count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return durable_count;
+}
+
+void EventJournal::committer_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        commit_cv.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty())
+            break; // stopping with nothing left to commit
+
+        // Let the batch fill up until it is large enough or its budget ends
+        auto deadline = first_pending_time + options.group_commit_budget;
+        commit_cv.wait_until(lock, deadline, [this] {
+            return stopping || flush_requested ||
+                   pending.size() >= options.group_commit_events;
+        });
+
+        flush_requested = false;
+        writing.swap(pending);
+        lock.unlock();
+
+        try {
+            write_batch(writing);
+        } catch (...) {
+            lock.lock();
+            failure = std::current_exception();
+            durable_cv.notify_all();
+            return;
+        }
+        uint64_t committed = writing.size();
+        writing.clear();
+
+        lock.lock();
+        durable_count += committed;
+        durable_cv.notify_all();
+    }
+}
+
+void EventJournal::write_batch(const std::vector<JournalRecord> &batch) {
+    std::size_t next = 0;
+    while (next < batch.size()) {
+        if (segment_offset == options.segment_size) {
+            if (::fdatasync(segment_fd) != 0) {
+                throw std::runtime_error(system_error("Journal sync failed"));
+            }
+            close_segment();
+            open_next_segment();
+        }
+
+        std::size_t room =
+            (options.segment_size - segment_offset) / sizeof(JournalRecord);
+        std::size_t count = std::min(room, batch.size() - next);
+
+        write_fully(segment_fd, reinterpret_cast<const char *>(&batch[next]),
+                    count * sizeof(JournalRecord),
+                    static_cast<off_t>(segment_offset));
+
+        segment_offset += count * sizeof(JournalRecord);
+        next += count;
+    }
+
+    // Segments are preallocated, so this does not touch file metadata
+    if (::fdatasync(segment_fd) != 0) {
+        throw std::runtime_error(system_error("Journal sync failed"));
+    }
+}
+
+void EventJournal::open_next_segment() {
+    std::string path = segment_path(directory, segment_index++);
+    segment_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (segment_fd < 0) {
+        throw std::runtime_error(
+            system_error("Cannot open journal segment: " + path));
+    }
+
+    int err = ::posix_fallocate(segment_fd, 0,
+                                static_cast<off_t>(options.segment_size));
+    if (err != 0 &&
+        ::ftruncate(segment_fd, static_cast<off_t>(options.segment_size)) !=
+            0) {
+        throw std::runtime_error(
+            system_error("Cannot preallocate journal segment: " + path));
+    }
+
+    // Persist the new file and its size once, not on every commit
+    ::fsync(segment_fd);
+    int dir_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+
+    segment_offset = 0;
+}
+
+void EventJournal::close_segment() {
+    if (segment_fd >= 0) {
+        ::close(segment_fd);
+        segment_fd = -1;
+    }
+}
+
+EventJournalReader::EventJournalReader(const std::string &journal_directory) {
+    for (uint64_t index : list_segments(journal_directory)) {
+        segment_paths.push_back(segment_path(journal_directory, index));
+    }
+}
+
+std::size_t EventJournalReader::for_each(
+    const std::function<void(const JournalRecord &)> &visitor) const {
+    std::size_t visited = 0;
+    std::vector<JournalRecord> buffer(4096);
+
+    for (const auto &path : segment_paths) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(
+                system_error("Cannot open journal segment: " + path));
+        }
+
+        bool segment_done = false;
+        while (!segment_done) {
+            ssize_t bytes = ::read(fd, buffer.data(),
+                                   buffer.size() * sizeof(JournalRecord));
+            if (bytes < 0 && errno == EINTR)
+                continue;
+            if (bytes <= 0)
+                break;
+
+            std::size_t count =
+                static_cast<std::size_t>(bytes) / sizeof(JournalRecord);
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto &record = buffer[i];
+                // Preallocated space is zero-filled; a torn write fails
+                // the checksum. Either one ends the segment.
+                if (record.marker != JournalRecord::JOURNAL_RECORD_MARKER ||
+                    record.checksum != journal_checksum(record)) {
+                    segment_done = true;
+                    break;
+                }
+                visitor(record);
+                ++visited;
+            }
+        }
+        ::close(fd);
+    }
+    return visited;
+}
+
+} // namespace state_machine
@@ -0,0 +1,483 @@
+#include "state_machine/tracing/columnar_trace.h"
+#include "state_machine/tracing/trace_reader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+constexpr std::size_t ColumnarTraceWriter::DEFAULT_BLOCK_RECORDS;
+
+namespace {
+
+constexpr char COLUMNAR_MAGIC[8] = {'S', 'M', 'C', 'O', 'L', 'T', 'R', '\0'};
+constexpr uint32_t COLUMNAR_VERSION = 1;
+
+struct ColumnarFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    TraceFileHeader source; // tick period and clock origin of the trace
+};
+
+struct ColumnarFileTrailer {
+    uint64_t index_offset;
+    uint64_t block_count;
+    char magic[8];
+};
+
+enum ColumnEncoding : uint8_t { COLUMN_RLE = 0, COLUMN_BITPACKED = 1 };
+
+std::string system_error(const std::string &what,
+                         const std::string &filename) {
+    return what + " " + filename + ": " + std::strerror(errno);
+}
+
+void pread_fully(int fd, void *data, std::size_t size, uint64_t offset,
+                 const std::string &filename) {
+    auto *out = static_cast<char *>(data);
+    while (size > 0) {
+        ssize_t bytes = ::pread(fd, out, size, static_cast<off_t>(offset));
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        if (bytes < 0)
+            throw std::runtime_error(system_error("Cannot read", filename));
+        if (bytes == 0)
+            throw std::runtime_error("Truncated columnar trace: " + filename);
+        out += bytes;
+        size -= static_cast<std::size_t>(bytes);
+        offset += static_cast<uint64_t>(bytes);
+    }
+}
+
+void put_varint(std::vector<uint8_t> &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^
+           static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+uint8_t bit_width(uint32_t value) {
+    uint8_t width = 0;
+    while (value) {
+        ++width;
+        value >>= 1;
+    }
+    return width;
+}
+
+/**
+ * @brief Bounds-checked cursor over one encoded block
+ */
+class BlockCursor {
+  private:
+    const uint8_t *data;
+    std::size_t size;
+    std::size_t pos = 0;
+
+  public:
+    BlockCursor(const uint8_t *bytes, std::size_t length)
+        : data(bytes), size(length) {}
+
+    uint8_t byte() {
+        if (pos >= size)
+            throw std::runtime_error("Corrupt columnar trace block");
+        return data[pos++];
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return value;
+        }
+        throw std::runtime_error("Corrupt columnar trace varint");
+    }
+
+    const uint8_t *take(std::size_t length) {
+        if (size - pos < length)
+            throw std::runtime_error("Corrupt columnar trace block");
+        const uint8_t *start = data + pos;
+        pos += length;
+        return start;
+    }
+};
+
+void encode_rle(std::vector<uint8_t> &out, const std::vector<uint32_t> &values) {
+    std::vector<uint8_t> runs;
+    uint64_t run_count = 0;
+    for (std::size_t i = 0; i < values.size();) {
+        std::size_t j = i + 1;
+        while (j < values.size() && values[j] == values[i])
+            ++j;
+        put_varint(runs, values[i]);
+        put_varint(runs, j - i);
+        ++run_count;
+        i = j;
+    }
+    out.push_back(COLUMN_RLE);
+    put_varint(out, run_count);
+    out.insert(out.end(), runs.begin(), runs.end());
+}
+
+void encode_bitpacked(std::vector<uint8_t> &out,
+                      const std::vector<uint32_t> &values, uint32_t min_value,
+                      uint8_t width) {
+    out.push_back(COLUMN_BITPACKED);
+    put_varint(out, min_value);
+    out.push_back(width);
+
+    std::size_t start = out.size();
+    out.resize(start + (values.size() * width + 7) / 8, 0);
+    std::size_t bit = 0;
+    for (uint32_t value : values) {
+        uint32_t packed = value - min_value;
+        for (uint8_t b = 0; b < width; ++b, ++bit) {
+            if (packed & (1u << b)) {
+                out[start + bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+            }
+        }
+    }
+}
+
+// Appends the smaller of the RLE and bit-packed encodings of values
+void encode_column(std::vector<uint8_t> &out,
+                   const std::vector<uint32_t> &values) {
+    auto bounds = std::minmax_element(values.begin(), values.end());
+    uint32_t min_value = *bounds.first;
+    uint8_t width = bit_width(*bounds.second - min_value);
+
+    std::vector<uint8_t> rle;
+    encode_rle(rle, values);
+
+    std::size_t packed_size = 1 + 5 + 1 + (values.size() * width + 7) / 8;
+    if (rle.size() <= packed_size) {
+        out.insert(out.end(), rle.begin(), rle.end());
+    } else {
+        encode_bitpacked(out, values, min_value, width);
+    }
+}
+
+void decode_column(BlockCursor &cursor, std::size_t count,
+                   std::vector<uint32_t> &values) {
+    values.clear();
+    values.reserve(count);
+
+    uint8_t encoding = cursor.byte();
+    if (encoding == COLUMN_RLE) {
+        uint64_t runs = cursor.varint();
+        for (uint64_t r = 0; r < runs; ++r) {
+            auto value = static_cast<uint32_t>(cursor.varint());
+            uint64_t length = cursor.varint();
+            if (length > count - values.size())
+                throw std::runtime_error("Corrupt columnar trace run");
+            values.insert(values.end(), length, value);
+        }
+    } else if (encoding == COLUMN_BITPACKED) {
+        auto min_value = static_cast<uint32_t>(cursor.varint());
+        uint8_t width = cursor.byte();
+        if (width > 32)
+            throw std::runtime_error("Corrupt columnar trace bit width");
+        const uint8_t *bits = cursor.take((count * width + 7) / 8);
+        std::size_t bit = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            uint32_t packed = 0;
+            for (uint8_t b = 0; b < width; ++b, ++bit) {
+                if (bits[bit / 8] & (1u << (bit % 8))) {
+                    packed |= 1u << b;
+                }
+            }
+            values.push_back(min_value + packed);
+        }
+    } else {
+        throw std::runtime_error("Unknown columnar trace encoding");
+    }
+
+    if (values.size() != count)
+        throw std::runtime_error("Corrupt columnar trace column length");
+}
+
+} // namespace
+
+ColumnarTraceWriter::ColumnarTraceWriter(const std::string &columnar_filename,
+                                         const TraceFileHeader &source_header,
+                                         std::size_t records_per_block)
+    : filename(columnar_filename),
+      block_records(std::max<std::size_t>(1, records_per_block)) {
+    fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(system_error("Cannot open", filename));
+    }
+
+    ColumnarFileHeader header;
+    std::memcpy(header.magic, COLUMNAR_MAGIC, sizeof(header.magic));
+    header.version = COLUMNAR_VERSION;
+    header.reserved = 0;
+    header.source = source_header;
+    // The destructor does not run for a throwing constructor
+    try {
+        write_bytes(&header, sizeof(header));
+        block.reserve(block_records);
+    } catch (...) {
+        ::close(fd);
+        fd = -1;
+        throw;
+    }
+}
+
+ColumnarTraceWriter::~ColumnarTraceWriter() {
+    if (fd >= 0) {
+        try {
+            finish();
+        } catch (const std::exception &) {
+            // Nothing sensible to do with a failed write during teardown
+        }
+    }
+}
+
+void ColumnarTraceWriter::finish() {
+    if (fd < 0)
+        return;
+
+    // Closed however the writes end; a file that failed here is unusable
+    try {
+        if (!block.empty()) {
+            write_block();
+        }
+
+        ColumnarFileTrailer trailer;
+        trailer.index_offset = file_offset;
+        trailer.block_count = index.size();
+        std::memcpy(trailer.magic, COLUMNAR_MAGIC, sizeof(trailer.magic));
+
+        if (!index.empty()) {
+            write_bytes(index.data(),
+                        index.size() * sizeof(ColumnarBlockInfo));
+        }
+        write_bytes(&trailer, sizeof(trailer));
+    } catch (...) {
+        ::close(fd);
+        fd = -1;
+        throw;
+    }
+
+    ::close(fd);
+    fd = -1;
+}
+
+void ColumnarTraceWriter::write_block() {
+    std::vector<uint32_t> column(block.size());
+    encoded.clear();
+
+    for (std::size_t i = 0; i < block.size(); ++i)
+        column[i] = block[i].instance_id;
+    encode_column(encoded, column);
+    for (std::size_t i = 0; i < block.size(); ++i)
+        column[i] = block[i].from_state;
+    encode_column(encoded, column);
+    for (std::size_t i = 0; i < block.size(); ++i)
+        column[i] = block[i].event;
+    encode_column(encoded, column);
+    for (std::size_t i = 0; i < block.size(); ++i)
+        column[i] = block[i].to_state;
+    encode_column(encoded, column);
+
+    // Timestamps: base value, then zigzag deltas from the previous record
+    uint64_t previous = block.front().ticks;
+    uint64_t min_ticks = previous;
+    uint64_t max_ticks = previous;
+    put_varint(encoded, previous);
+    for (const auto &record : block) {
+        put_varint(encoded, zigzag(static_cast<int64_t>(record.ticks - previous)));
+        previous = record.ticks;
+        min_ticks = std::min(min_ticks, record.ticks);
+        max_ticks = std::max(max_ticks, record.ticks);
+    }
+
+    ColumnarBlockInfo info;
+    info.offset = file_offset;
+    info.first_ticks = min_ticks;
+    info.last_ticks = max_ticks;
+    info.record_count = static_cast<uint32_t>(block.size());
+    info.byte_size = static_cast<uint32_t>(encoded.size());
+    index.push_back(info);
+
+    write_bytes(encoded.data(), encoded.size());
+    block.clear();
+}
+
+void ColumnarTraceWriter::write_bytes(const void *data, std::size_t size) {
+    const auto *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(system_error("Cannot write", filename));
+        }
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+        file_offset += static_cast<uint64_t>(written);
+    }
+}
+
+ColumnarTraceReader::ColumnarTraceReader(const std::string &columnar_filename)
+    : filename(columnar_filename) {
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(system_error("Cannot open", filename));
+    }
+
+    try {
+        ColumnarFileHeader file_header;
+        pread_fully(fd, &file_header, sizeof(file_header), 0, filename);
+        if (std::memcmp(file_header.magic, COLUMNAR_MAGIC,
+                        sizeof(file_header.magic)) != 0 ||
+            file_header.version != COLUMNAR_VERSION) {
+            throw std::runtime_error("Not a columnar trace file: " + filename);
+        }
+        header = file_header.source;
+        validate_trace_header(header, filename);
+
+        off_t end = ::lseek(fd, 0, SEEK_END);
+        if (end < static_cast<off_t>(sizeof(ColumnarFileHeader) +
+                                     sizeof(ColumnarFileTrailer))) {
+            throw std::runtime_error("Truncated columnar trace: " + filename);
+        }
+
+        ColumnarFileTrailer trailer;
+        pread_fully(fd, &trailer, sizeof(trailer),
+                    static_cast<uint64_t>(end) - sizeof(trailer), filename);
+        if (std::memcmp(trailer.magic, COLUMNAR_MAGIC, sizeof(trailer.magic)) !=
+                0 ||
+            trailer.index_offset + trailer.block_count *
+                                       sizeof(ColumnarBlockInfo) !=
+                static_cast<uint64_t>(end) - sizeof(trailer)) {
+            throw std::runtime_error("Unfinished columnar trace: " + filename);
+        }
+
+        index.resize(trailer.block_count);
+        if (!index.empty()) {
+            pread_fully(fd, index.data(),
+                        index.size() * sizeof(ColumnarBlockInfo),
+                        trailer.index_offset, filename);
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+ColumnarTraceReader::~ColumnarTraceReader() {
+    if (fd >= 0)
+        ::close(fd);
+}
+
+uint64_t ColumnarTraceReader::get_record_count() const {
+    uint64_t total = 0;
+    for (const auto &info : index) {
+        total += info.record_count;
+    }
+    return total;
+}
+
+void ColumnarTraceReader::decode_block(const ColumnarBlockInfo &info,
+                                       std::vector<TraceRecord> &records) const {
+    std::vector<uint8_t> bytes(info.byte_size);
+    pread_fully(fd, bytes.data(), bytes.size(), info.offset, filename);
+
+    BlockCursor cursor(bytes.data(), bytes.size());
+    std::size_t count = info.record_count;
+    records.assign(count, TraceRecord());
+
+    std::vector<uint32_t> column;
+    decode_column(cursor, count, column);
+    for (std::size_t i = 0; i < count; ++i)
+        records[i].instance_id = column[i];
+    decode_column(cursor, count, column);
+    for (std::size_t i = 0; i < count; ++i)
+        records[i].from_state = static_cast<uint8_t>(column[i]);
+    decode_column(cursor, count, column);
+    for (std::size_t i = 0; i < count; ++i)
+        records[i].event = static_cast<uint8_t>(column[i]);
+    decode_column(cursor, count, column);
+    for (std::size_t i = 0; i < count; ++i)
+        records[i].to_state = static_cast<uint8_t>(column[i]);
+
+    uint64_t previous = cursor.varint();
+    for (std::size_t i = 0; i < count; ++i) {
+        previous += static_cast<uint64_t>(unzigzag(cursor.varint()));
+        records[i].ticks = previous;
+    }
+}
+
+std::size_t ColumnarTraceReader::scan(
+    uint64_t min_ticks, uint64_t max_ticks,
+    const std::function<void(const TraceRecord &)> &visitor) const {
+    std::size_t visited = 0;
+    std::vector<TraceRecord> records;
+
+    for (const auto &info : index) {
+        // Block index lets us skip blocks outside the requested range
+        if (info.last_ticks < min_ticks || info.first_ticks > max_ticks)
+            continue;
+
+        decode_block(info, records);
+        for (const auto &record : records) {
+            if (record.ticks >= min_ticks && record.ticks <= max_ticks) {
+                visitor(record);
+                ++visited;
+            }
+        }
+    }
+    return visited;
+}
+
+bool is_columnar_trace(const std::string &filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    char magic[sizeof(COLUMNAR_MAGIC)];
+    bool columnar = ::read(fd, magic, sizeof(magic)) ==
+                        static_cast<ssize_t>(sizeof(magic)) &&
+                    std::memcmp(magic, COLUMNAR_MAGIC, sizeof(magic)) == 0;
+    ::close(fd);
+    return columnar;
+}
+
+std::size_t convert_trace_to_columnar(const std::string &trace_filename,
+                                      const std::string &columnar_filename,
+                                      std::size_t records_per_block) {
+    TraceFileReader reader(trace_filename);
+    ColumnarTraceWriter writer(columnar_filename, reader.get_header(),
+                               records_per_block);
+
+    std::size_t converted = 0;
+    TraceRecord record;
+    while (reader.next(record)) {
+        writer.append(record);
+        ++converted;
+    }
+    writer.finish();
+    return converted;
+}
+
+} // namespace state_machine
@@ -0,0 +1,205 @@
+#include "state_machine/tracing/flight_recorder.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+#include <unistd.h>
+
+namespace state_machine {
+
+namespace {
+
+// Rings dumped by the fatal-signal handler; a fixed table so that
+// registration and the handler never allocate or lock
+constexpr std::size_t MAX_CRASH_RINGS = 64;
+std::atomic<const FlightRing *> crash_rings[MAX_CRASH_RINGS];
+
+std::atomic<int> crash_fd{2};
+
+const int FATAL_SIGNALS[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+// Small stack buffer with async-signal-safe formatting
+class LineBuffer {
+  private:
+    char data[160];
+    std::size_t size = 0;
+
+  public:
+    void append(const char *text) {
+        while (*text && size < sizeof(data)) {
+            data[size++] = *text++;
+        }
+    }
+
+    void append(uint64_t value) {
+        char digits[20];
+        std::size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+        while (count > 0 && size < sizeof(data)) {
+            data[size++] = digits[--count];
+        }
+    }
+
+    void flush(int fd) {
+        const char *cursor = data;
+        while (size > 0) {
+            ssize_t written = ::write(fd, cursor, size);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            cursor += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        size = 0;
+    }
+};
+
+void fatal_signal_handler(int signal_number) {
+    int saved_errno = errno;
+    int fd = crash_fd.load(std::memory_order_relaxed);
+
+    LineBuffer line;
+    line.append("*** fatal signal ");
+    line.append(static_cast<uint64_t>(signal_number));
+    line.append(", dumping flight recorders ***\n");
+    line.flush(fd);
+    dump_all_flight_recorders(fd);
+
+    // SA_RESETHAND restored the default action
+    errno = saved_errno;
+    ::raise(signal_number);
+}
+
+std::size_t round_up_pow2(std::size_t value) {
+    std::size_t capacity = 1;
+    while (capacity < value) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+} // namespace
+
+FlightRing::FlightRing(std::size_t capacity, const std::string &ring_name,
+                       bool crash_dump_enabled)
+    : slots(new Slot[round_up_pow2(capacity == 0 ? 1 : capacity)]()),
+      mask(round_up_pow2(capacity == 0 ? 1 : capacity) - 1),
+      crash_dump(crash_dump_enabled) {
+    std::strncpy(name, ring_name.c_str(), sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+
+    if (crash_dump) {
+        for (auto &entry : crash_rings) {
+            const FlightRing *expected = nullptr;
+            if (entry.compare_exchange_strong(expected, this))
+                break;
+        }
+    }
+}
+
+FlightRing::~FlightRing() {
+    if (crash_dump) {
+        for (auto &entry : crash_rings) {
+            const FlightRing *expected = this;
+            if (entry.compare_exchange_strong(expected, nullptr))
+                break;
+        }
+    }
+}
+
+bool FlightRing::read_slot(uint64_t sequence, FlightRecord &record) const {
+    const Slot &slot = slots[sequence & mask];
+    uint64_t before = slot.version.load(std::memory_order_acquire);
+    if (before != 2 * sequence + 2)
+        return false;
+
+    uint64_t timestamp = slot.timestamp_ns.load(std::memory_order_relaxed);
+    uint64_t transition = slot.transition.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.version.load(std::memory_order_relaxed) != before)
+        return false;
+
+    record.sequence = sequence;
+    record.timestamp_ns = timestamp;
+    record.from_state = static_cast<uint16_t>(transition);
+    record.event = static_cast<uint16_t>(transition >> 16);
+    record.to_state = static_cast<uint16_t>(transition >> 32);
+    return true;
+}
+
+std::vector<FlightRecord> FlightRing::snapshot() const {
+    std::vector<FlightRecord> records;
+    uint64_t end = get_recorded_count();
+    uint64_t begin = end > get_capacity() ? end - get_capacity() : 0;
+    records.reserve(static_cast<std::size_t>(end - begin));
+
+    FlightRecord record;
+    for (uint64_t sequence = begin; sequence < end; ++sequence) {
+        if (read_slot(sequence, record)) {
+            records.push_back(record);
+        }
+    }
+    return records;
+}
+
+void FlightRing::dump(int fd) const {
+    uint64_t end = get_recorded_count();
+    uint64_t begin = end > get_capacity() ? end - get_capacity() : 0;
+
+    LineBuffer line;
+    line.append("flight recorder ");
+    line.append(name);
+    line.append(": last ");
+    line.append(end - begin);
+    line.append(" of ");
+    line.append(end);
+    line.append(" transitions (from event to, numeric)\n");
+    line.flush(fd);
+
+    FlightRecord record;
+    for (uint64_t sequence = begin; sequence < end; ++sequence) {
+        if (!read_slot(sequence, record))
+            continue;
+        line.append("  #");
+        line.append(record.sequence);
+        line.append(" t=");
+        line.append(record.timestamp_ns);
+        line.append("ns ");
+        line.append(static_cast<uint64_t>(record.from_state));
+        line.append(" --[");
+        line.append(static_cast<uint64_t>(record.event));
+        line.append("]--> ");
+        line.append(static_cast<uint64_t>(record.to_state));
+        line.append("\n");
+        line.flush(fd);
+    }
+}
+
+void dump_all_flight_recorders(int fd) {
+    for (const auto &entry : crash_rings) {
+        if (const FlightRing *ring = entry.load(std::memory_order_acquire)) {
+            ring->dump(fd);
+        }
+    }
+}
+
+void install_flight_recorder_signal_handlers(int fd) {
+    crash_fd.store(fd, std::memory_order_relaxed);
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = fatal_signal_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESETHAND | SA_NODEFER;
+    for (int signal_number : FATAL_SIGNALS) {
+        ::sigaction(signal_number, &action, nullptr);
+    }
+}
+
+} // namespace state_machine
@@ -0,0 +1,66 @@
+#include "state_machine/tracing/mapped_trace.h"
+#include "state_machine/tracing/trace_reader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+MappedTrace::MappedTrace(const std::string &trace_filename)
+    : filename(trace_filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open trace file " + filename + ": " +
+                                 std::strerror(errno));
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat trace file " + filename + ": " +
+                                 std::strerror(errno));
+    }
+
+    mapping_size = static_cast<std::size_t>(info.st_size);
+    if (mapping_size < sizeof(TraceFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Truncated trace file: " + filename);
+    }
+
+    mapping = ::mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::runtime_error("Cannot map trace file " + filename + ": " +
+                                 std::strerror(errno));
+    }
+    // Queries walk instances in file order, tell the kernel to read ahead
+    ::madvise(mapping, mapping_size, MADV_WILLNEED);
+
+    try {
+        validate_trace_header(get_header(), filename);
+    } catch (...) {
+        ::munmap(mapping, mapping_size);
+        throw;
+    }
+
+    records = reinterpret_cast<const TraceRecord *>(
+        static_cast<const char *>(mapping) + sizeof(TraceFileHeader));
+    // A partial trailing record is an unfinished write; ignore it
+    record_count =
+        (mapping_size - sizeof(TraceFileHeader)) / sizeof(TraceRecord);
+}
+
+MappedTrace::~MappedTrace() {
+    if (mapping) {
+        ::munmap(mapping, mapping_size);
+    }
+}
+
+} // namespace state_machine
@@ -0,0 +1,289 @@
+#include "state_machine/tracing/trace_query.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace state_machine {
+
+constexpr int TraceStep::ANY;
+constexpr std::size_t TraceQueryEngine::STATE_LIMIT;
+
+TraceQueryEngine::TraceQueryEngine(const std::vector<std::string> &trace_files,
+                                   unsigned threads)
+    : by_state(STATE_LIMIT), worker_count(threads) {
+    if (worker_count == 0) {
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (const auto &file : trace_files) {
+        traces.emplace_back(new MappedTrace(file));
+        if (traces.back()->size() > UINT32_MAX) {
+            throw std::runtime_error("Trace file too large to index: " + file);
+        }
+    }
+
+    build_indexes();
+}
+
+std::size_t TraceQueryEngine::get_record_count() const {
+    std::size_t total = 0;
+    for (const auto &trace : traces) {
+        total += trace->size();
+    }
+    return total;
+}
+
+void TraceQueryEngine::build_indexes() {
+    // Per-instance index: one sequential pass over every mapped file
+    std::unordered_map<uint32_t, uint32_t> slot_of;
+    for (uint32_t t = 0; t < traces.size(); ++t) {
+        const MappedTrace &trace = *traces[t];
+        for (uint32_t i = 0; i < trace.size(); ++i) {
+            auto inserted = slot_of.emplace(
+                trace[i].instance_id, static_cast<uint32_t>(slot_of.size()));
+            if (inserted.second) {
+                instance_ids.push_back(trace[i].instance_id);
+                by_instance.emplace_back();
+            }
+            by_instance[inserted.first->second].push_back({t, i});
+        }
+    }
+
+    // Each file is in time order; merged files need a sort per instance
+    if (traces.size() > 1) {
+        for_each_range(by_instance.size(), [this](unsigned, std::size_t begin,
+                                                  std::size_t end) {
+            for (std::size_t slot = begin; slot < end; ++slot) {
+                std::stable_sort(by_instance[slot].begin(),
+                                 by_instance[slot].end(),
+                                 [this](const RecordRef &a,
+                                        const RecordRef &b) {
+                                     return time_ns(a) < time_ns(b);
+                                 });
+            }
+        });
+    }
+
+    // Per-state index: built per worker, then concatenated in slot order
+    std::vector<std::vector<std::vector<InstancePosition>>> partial(
+        worker_count);
+    for_each_range(by_instance.size(), [this, &partial](unsigned worker,
+                                                        std::size_t begin,
+                                                        std::size_t end) {
+        auto &local = partial[worker];
+        local.resize(STATE_LIMIT);
+        for (std::size_t slot = begin; slot < end; ++slot) {
+            const auto &refs = by_instance[slot];
+            for (uint32_t pos = 0; pos < refs.size(); ++pos) {
+                const TraceRecord &record = record_at(refs[pos]);
+                if (record.from_state != record.to_state) {
+                    local[record.to_state].push_back(
+                        {static_cast<uint32_t>(slot), pos});
+                }
+            }
+        }
+    });
+    for (auto &local : partial) {
+        for (std::size_t state = 0; state < local.size(); ++state) {
+            by_state[state].insert(by_state[state].end(), local[state].begin(),
+                                   local[state].end());
+        }
+    }
+}
+
+void TraceQueryEngine::for_each_range(
+    std::size_t count,
+    const std::function<void(unsigned, std::size_t, std::size_t)> &fn) const {
+    unsigned workers = static_cast<unsigned>(
+        std::min<std::size_t>(worker_count, std::max<std::size_t>(count, 1)));
+    std::size_t per_worker = (count + workers - 1) / workers;
+
+    std::vector<std::thread> threads;
+    for (unsigned w = 1; w < workers; ++w) {
+        std::size_t begin = std::min(count, w * per_worker);
+        std::size_t end = std::min(count, begin + per_worker);
+        threads.emplace_back(fn, w, begin, end);
+    }
+    fn(0, 0, std::min(count, per_worker));
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+DurationStats TraceQueryEngine::dwell_time(uint8_t state) const {
+    const auto &entries = by_state[state];
+    std::vector<std::vector<int64_t>> partial(worker_count);
+
+    for_each_range(entries.size(), [&](unsigned worker, std::size_t begin,
+                                       std::size_t end) {
+        for (std::size_t e = begin; e < end; ++e) {
+            const auto &refs = by_instance[entries[e].instance_slot];
+            // Walk forward from the entry until the instance leaves state
+            for (std::size_t pos = entries[e].position + 1; pos < refs.size();
+                 ++pos) {
+                const TraceRecord &record = record_at(refs[pos]);
+                if (record.from_state == state && record.to_state != state) {
+                    partial[worker].push_back(
+                        time_ns(refs[pos]) -
+                        time_ns(refs[entries[e].position]));
+                    break;
+                }
+            }
+        }
+    });
+
+    std::vector<int64_t> durations;
+    for (auto &local : partial) {
+        durations.insert(durations.end(), local.begin(), local.end());
+    }
+    return summarize(durations);
+}
+
+DurationStats TraceQueryEngine::wait_time(const TraceStep &start,
+                                          const TraceStep &end) const {
+    std::vector<std::vector<int64_t>> partial(worker_count);
+
+    for_each_range(by_instance.size(), [&](unsigned worker,
+                                           std::size_t first_slot,
+                                           std::size_t last_slot) {
+        for (std::size_t slot = first_slot; slot < last_slot; ++slot) {
+            bool pending = false;
+            int64_t started_ns = 0;
+            for (const auto &ref : by_instance[slot]) {
+                const TraceRecord &record = record_at(ref);
+                if (pending && end.matches(record)) {
+                    partial[worker].push_back(time_ns(ref) - started_ns);
+                    pending = false;
+                } else if (!pending && start.matches(record)) {
+                    pending = true;
+                    started_ns = time_ns(ref);
+                }
+            }
+        }
+    });
+
+    std::vector<int64_t> durations;
+    for (auto &local : partial) {
+        durations.insert(durations.end(), local.begin(), local.end());
+    }
+    return summarize(durations);
+}
+
+std::vector<PathCount> TraceQueryEngine::path_frequency(std::size_t length,
+                                                        std::size_t top) const {
+    if (length == 0)
+        return {};
+
+    // Paths are keyed by their raw state bytes
+    std::vector<std::unordered_map<std::string, uint64_t>> partial(
+        worker_count);
+
+    for_each_range(by_instance.size(), [&](unsigned worker,
+                                           std::size_t first_slot,
+                                           std::size_t last_slot) {
+        std::string changes;
+        for (std::size_t slot = first_slot; slot < last_slot; ++slot) {
+            // Collapse the instance into its sequence of visited states
+            changes.clear();
+            for (const auto &ref : by_instance[slot]) {
+                const TraceRecord &record = record_at(ref);
+                if (record.from_state == record.to_state)
+                    continue;
+                if (changes.empty() ||
+                    static_cast<uint8_t>(changes.back()) != record.from_state) {
+                    changes.push_back(static_cast<char>(record.from_state));
+                }
+                changes.push_back(static_cast<char>(record.to_state));
+            }
+
+            for (std::size_t i = 0; i + length < changes.size(); ++i) {
+                ++partial[worker][changes.substr(i, length + 1)];
+            }
+        }
+    });
+
+    std::unordered_map<std::string, uint64_t> merged;
+    for (auto &local : partial) {
+        for (const auto &entry : local) {
+            merged[entry.first] += entry.second;
+        }
+    }
+
+    std::vector<PathCount> result;
+    result.reserve(merged.size());
+    for (const auto &entry : merged) {
+        result.push_back(
+            {std::vector<uint8_t>(entry.first.begin(), entry.first.end()),
+             entry.second});
+    }
+    std::sort(result.begin(), result.end(),
+              [](const PathCount &a, const PathCount &b) {
+                  return a.count != b.count ? a.count > b.count
+                                            : a.states < b.states;
+              });
+    if (result.size() > top) {
+        result.resize(top);
+    }
+    return result;
+}
+
+uint64_t
+TraceQueryEngine::count_sequence(const std::vector<TraceStep> &steps) const {
+    if (steps.empty())
+        return 0;
+
+    std::vector<uint64_t> partial(worker_count, 0);
+
+    for_each_range(by_instance.size(), [&](unsigned worker,
+                                           std::size_t first_slot,
+                                           std::size_t last_slot) {
+        for (std::size_t slot = first_slot; slot < last_slot; ++slot) {
+            const auto &refs = by_instance[slot];
+            for (std::size_t pos = 0; pos + steps.size() <= refs.size();
+                 ++pos) {
+                std::size_t matched = 0;
+                while (matched < steps.size() &&
+                       steps[matched].matches(record_at(refs[pos + matched]))) {
+                    ++matched;
+                }
+                if (matched == steps.size()) {
+                    ++partial[worker];
+                }
+            }
+        }
+    });
+
+    uint64_t total = 0;
+    for (uint64_t count : partial) {
+        total += count;
+    }
+    return total;
+}
+
+DurationStats TraceQueryEngine::summarize(std::vector<int64_t> &durations) {
+    DurationStats stats;
+    if (durations.empty())
+        return stats;
+
+    std::sort(durations.begin(), durations.end());
+
+    long double sum = 0;
+    for (int64_t d : durations) {
+        sum += d;
+    }
+
+    std::size_t n = durations.size();
+    stats.count = n;
+    stats.mean_ns = static_cast<double>(sum / n);
+    stats.min_ns = durations.front();
+    stats.max_ns = durations.back();
+    stats.p50_ns = durations[(n - 1) * 50 / 100];
+    stats.p99_ns = durations[(n - 1) * 99 / 100];
+    return stats;
+}
+
+} // namespace state_machine
@@ -0,0 +1,91 @@
+#include "state_machine/tracing/trace_reader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+namespace {
+
+// Reads up to size bytes, returns fewer only at end of file
+std::size_t read_fully(int fd, void *data, std::size_t size,
+                       const std::string &filename) {
+    std::size_t total = 0;
+    while (total < size) {
+        ssize_t bytes = ::read(fd, static_cast<char *>(data) + total,
+                               size - total);
+        if (bytes < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("Cannot read trace file " + filename +
+                                     ": " + std::strerror(errno));
+        }
+        if (bytes == 0)
+            break;
+        total += static_cast<std::size_t>(bytes);
+    }
+    return total;
+}
+
+} // namespace
+
+void validate_trace_header(const TraceFileHeader &header,
+                           const std::string &filename) {
+    if (std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a binary trace file: " + filename);
+    }
+    if (header.version != TraceFileHeader::TRACE_VERSION ||
+        header.record_size != sizeof(TraceRecord)) {
+        throw std::runtime_error("Unsupported trace file version: " +
+                                 filename);
+    }
+    if (header.tick_num <= 0 || header.tick_den <= 0) {
+        throw std::runtime_error("Corrupt trace file header: " + filename);
+    }
+}
+
+TraceFileReader::TraceFileReader(const std::string &trace_filename)
+    : filename(trace_filename), buffer(4096) {
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open trace file " + filename + ": " +
+                                 std::strerror(errno));
+    }
+
+    if (read_fully(fd, &header, sizeof(header), filename) != sizeof(header)) {
+        ::close(fd);
+        throw std::runtime_error("Truncated trace file: " + filename);
+    }
+    try {
+        validate_trace_header(header, filename);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+TraceFileReader::~TraceFileReader() {
+    if (fd >= 0)
+        ::close(fd);
+}
+
+bool TraceFileReader::next(TraceRecord &record) {
+    if (buffer_pos == buffer_fill) {
+        std::size_t bytes = read_fully(fd, buffer.data(),
+                                       buffer.size() * sizeof(TraceRecord),
+                                       filename);
+        // A partial trailing record is an unfinished write; ignore it
+        buffer_fill = bytes / sizeof(TraceRecord);
+        buffer_pos = 0;
+        if (buffer_fill == 0)
+            return false;
+    }
+    record = buffer[buffer_pos++];
+    return true;
+}
+
+} // namespace state_machine
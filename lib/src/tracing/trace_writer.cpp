@@ -0,0 +1,135 @@
+#include "state_machine/tracing/trace_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace state_machine {
+
+namespace {
+
+std::string system_error(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+// writev() until every iovec has been consumed
+void writev_fully(int fd, std::vector<iovec> &iov) {
+    std::size_t first = 0;
+    while (first < iov.size()) {
+        int count = static_cast<int>(std::min<std::size_t>(
+            iov.size() - first, static_cast<std::size_t>(IOV_MAX)));
+        ssize_t written = ::writev(fd, &iov[first], count);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(system_error("Trace write failed"));
+        }
+
+        auto remaining = static_cast<std::size_t>(written);
+        while (first < iov.size() && remaining >= iov[first].iov_len) {
+            remaining -= iov[first].iov_len;
+            ++first;
+        }
+        if (remaining > 0) {
+            iov[first].iov_base =
+                static_cast<char *>(iov[first].iov_base) + remaining;
+            iov[first].iov_len -= remaining;
+        }
+    }
+}
+
+} // namespace
+
+TraceWriter::TraceWriter(const std::string &trace_filename,
+                         const TraceWriterOptions &options)
+    : filename(trace_filename) {
+
+    chunk_records = std::max<std::size_t>(1, options.chunk_size /
+                                                 sizeof(TraceRecord));
+    std::size_t chunk_count = std::max<std::size_t>(
+        1, options.buffer_size / (chunk_records * sizeof(TraceRecord)));
+    for (std::size_t i = 0; i < chunk_count; ++i) {
+        chunks.emplace_back(new TraceRecord[chunk_records]);
+    }
+
+    using steady = std::chrono::steady_clock;
+    flush_interval_ticks = static_cast<uint64_t>(
+        std::chrono::duration_cast<steady::duration>(options.flush_interval)
+            .count());
+
+    fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(
+            system_error("Cannot open trace file: " + filename));
+    }
+
+    auto steady_now = steady::now();
+    auto system_now = std::chrono::system_clock::now();
+    last_flush_ticks =
+        static_cast<uint64_t>(steady_now.time_since_epoch().count());
+
+    TraceFileHeader header;
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TraceFileHeader::TRACE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    header.tick_num = steady::period::num;
+    header.tick_den = steady::period::den;
+    header.steady_origin_ticks = steady_now.time_since_epoch().count();
+    header.system_origin_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            system_now.time_since_epoch())
+            .count();
+
+    // The destructor does not run for a throwing constructor
+    try {
+        std::vector<iovec> iov(1);
+        iov[0].iov_base = &header;
+        iov[0].iov_len = sizeof(header);
+        writev_fully(fd, iov);
+    } catch (...) {
+        ::close(fd);
+        fd = -1;
+        throw;
+    }
+}
+
+TraceWriter::~TraceWriter() {
+    if (fd >= 0) {
+        try {
+            flush();
+        } catch (const std::exception &) {
+            // Nothing sensible to do with a failed write during teardown
+        }
+        ::close(fd);
+    }
+}
+
+void TraceWriter::flush() {
+    std::vector<iovec> iov;
+    iov.reserve(active_chunk + 1);
+
+    for (std::size_t i = 0; i < active_chunk; ++i) {
+        iov.push_back({chunks[i].get(), chunk_records * sizeof(TraceRecord)});
+    }
+    if (active_chunk < chunks.size() && active_fill > 0) {
+        iov.push_back(
+            {chunks[active_chunk].get(), active_fill * sizeof(TraceRecord)});
+    }
+
+    active_chunk = 0;
+    active_fill = 0;
+    last_flush_ticks = static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+
+    if (!iov.empty()) {
+        writev_fully(fd, iov);
+    }
+}
+
+} // namespace state_machine
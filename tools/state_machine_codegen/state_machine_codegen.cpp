@@ -0,0 +1,526 @@
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <state_machine/implementations/definition_loader.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace state_machine;
+
+// Turns a JSON machine definition into a header holding its enums, their
+// name tables and a switch-based IStateMachine. Driven by the CMake
+// function add_state_machine(); see cmake/StateMachineCodegen.cmake.
+namespace {
+
+struct Options {
+    std::string input;
+    std::string output;
+    std::string name_space;
+    std::string machine;
+    std::string state_enum;
+    std::string event_enum;
+};
+
+void usage() {
+    std::cerr << "Usage: state_machine_codegen <definition.json> <output.h>\n"
+              << "         [--namespace <ns>] [--machine <Class>]\n"
+              << "         [--state-enum <Enum>] [--event-enum <Enum>]\n";
+}
+
+bool is_identifier(const std::string &name) {
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])))
+        return false;
+    for (char c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_')
+            return false;
+    }
+    return true;
+}
+
+// "traffic_light-standard" -> "TrafficLightStandard"
+std::string camel_case(const std::string &name) {
+    std::string result;
+    bool upper = true;
+    for (char c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c))) {
+            upper = true;
+            continue;
+        }
+        result += upper ? static_cast<char>(
+                              std::toupper(static_cast<unsigned char>(c)))
+                        : c;
+        upper = false;
+    }
+    return result;
+}
+
+// "pedestrian_waiting" -> "PEDESTRIAN_WAITING"
+std::string constant_case(const std::string &name) {
+    std::string result;
+    for (char c : name) {
+        result += std::isalnum(static_cast<unsigned char>(c))
+                      ? static_cast<char>(
+                            std::toupper(static_cast<unsigned char>(c)))
+                      : '_';
+    }
+    return result;
+}
+
+std::string quoted(const std::string &text) {
+    std::string result = "\"";
+    for (char c : text) {
+        switch (c) {
+        case '"':
+            result += "\\\"";
+            break;
+        case '\\':
+            result += "\\\\";
+            break;
+        case '\n':
+            result += "\\n";
+            break;
+        case '\t':
+            result += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\%03o",
+                              static_cast<unsigned char>(c));
+                result += escaped;
+            } else {
+                result += c;
+            }
+        }
+    }
+    return result + "\"";
+}
+
+void check_identifiers(const std::vector<std::string> &names,
+                       const char *kind) {
+    for (const auto &name : names) {
+        if (!is_identifier(name)) {
+            throw std::runtime_error(std::string(kind) + " '" + name +
+                                     "' is not a C++ identifier");
+        }
+    }
+}
+
+/**
+ * @brief Writes the header for one definition
+ */
+class Generator {
+  private:
+    const DefinitionDocument &doc;
+    const Options &options;
+    std::ostringstream out;
+
+  public:
+    Generator(const DefinitionDocument &document, const Options &opts)
+        : doc(document), options(opts) {}
+
+    std::string generate() {
+        std::vector<std::string> states;
+        for (const auto &state : doc.states) {
+            states.push_back(state.name);
+        }
+        check_identifiers(states, "State");
+        check_identifiers(doc.events, "Event");
+
+        out << "// Generated by state_machine_codegen from "
+            << base_name(options.input) << "; do not edit.\n"
+            << "#pragma once\n"
+            << "#include <state_machine/core/state_machine.h>\n"
+            << "#include <state_machine/metrics/transition_counters.h>\n"
+            << "#include <array>\n"
+            << "#include <cstddef>\n"
+            << "#include <cstdint>\n"
+            << "#include <cstring>\n"
+            << "#include <functional>\n"
+            << "#include <memory>\n"
+            << "#include <ostream>\n"
+            << "#include <stdexcept>\n"
+            << "#include <string>\n"
+            << "#include <vector>\n\n";
+        std::vector<std::string> scopes = split_scopes(options.name_space);
+        for (const auto &scope : scopes) {
+            out << "namespace " << scope << " {\n";
+        }
+        if (!scopes.empty()) {
+            out << "\n";
+        }
+        write_enum(options.state_enum, states);
+        write_enum(options.event_enum, doc.events);
+        write_names(options.state_enum, states, "UNKNOWN_STATE");
+        write_names(options.event_enum, doc.events, "UNKNOWN_EVENT");
+        write_machine(states);
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            out << "} // namespace " << *it << "\n";
+        }
+        return out.str();
+    }
+
+  private:
+    // "a::b" -> {"a", "b"}; C++14 has no nested namespace definitions
+    static std::vector<std::string> split_scopes(const std::string &name) {
+        std::vector<std::string> scopes;
+        std::size_t start = 0;
+        while (start < name.size()) {
+            std::size_t end = name.find("::", start);
+            std::string scope = name.substr(start, end - start);
+            if (!is_identifier(scope)) {
+                throw std::runtime_error("'" + name +
+                                         "' is not a namespace name");
+            }
+            scopes.push_back(scope);
+            if (end == std::string::npos)
+                break;
+            start = end + 2;
+        }
+        return scopes;
+    }
+
+    static std::string base_name(const std::string &path) {
+        auto slash = path.find_last_of('/');
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    void write_enum(const std::string &type,
+                    const std::vector<std::string> &names) {
+        out << "enum class " << type << " {\n";
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            out << "    " << names[i] << (i + 1 < names.size() ? ",\n" : "\n");
+        }
+        out << "};\n\n";
+    }
+
+    void write_names(const std::string &type,
+                     const std::vector<std::string> &names,
+                     const char *unknown) {
+        out << "inline const char *to_string(" << type << " value) {\n"
+            << "    switch (value) {\n";
+        for (const auto &name : names) {
+            out << "    case " << type << "::" << name << ":\n"
+                << "        return \"" << name << "\";\n";
+        }
+        out << "    default:\n"
+            << "        return \"" << unknown << "\";\n"
+            << "    }\n"
+            << "}\n\n"
+            << "inline std::ostream &operator<<(std::ostream &os, " << type
+            << " value) {\n"
+            << "    return os << to_string(value);\n"
+            << "}\n\n";
+    }
+
+    void write_machine(const std::vector<std::string> &states) {
+        const std::string &m = options.machine;
+        const std::string state = options.state_enum;
+        const std::string event = options.event_enum;
+        const std::string initial = state + "::" + states[doc.initial_state];
+
+        write_constants(states);
+        out << "/**\n"
+            << " * @brief Definition " << quoted(doc.name) << " version "
+            << doc.version << " compiled into switches\n"
+            << " *\n"
+            << " * Drop-in IStateMachine for the definition. Guards are bound "
+               "by name\n"
+            << " * as with VersionedStateMachine; the table itself is fixed.\n"
+            << " */\n"
+            << "class " << m << "\n"
+            << "    : public state_machine::IStateMachine<" << state << ", "
+            << event << ">,\n"
+            << "      public " << m << "Constants<> {\n"
+            << "  public:\n"
+            << "    using Guard = std::function<bool()>;\n"
+            << "    using Counters = state_machine::TransitionCounters<"
+            << state << ", " << event << ">;\n\n"
+            << "  private:\n"
+            << "    " << state << " current_state = " << initial << ";\n"
+            << "    std::array<Guard, GUARD_COUNT> guards;\n"
+            << "    std::shared_ptr<Counters> counters;\n\n"
+            << "  public:\n"
+            << "    // Throws for a guard the definition does not name\n"
+            << "    void bind_guard(const std::string &name, Guard guard) {\n";
+        for (std::size_t i = 0; i < doc.guards.size(); ++i) {
+            out << "        if (name == " << quoted(doc.guards[i]) << ") {\n"
+                << "            guards[" << i << "] = std::move(guard);\n"
+                << "            return;\n"
+                << "        }\n";
+        }
+        if (doc.guards.empty()) {
+            out << "        (void)guard;\n";
+        }
+        out << "        throw std::runtime_error(\"" << m
+            << " has no guard \" + name);\n"
+            << "    }\n\n"
+            << "    // See RuntimeStateMachine::set_counters\n"
+            << "    void set_counters(std::shared_ptr<Counters> shared) {\n"
+            << "        counters = std::move(shared);\n"
+            << "        if (!counters)\n"
+            << "            return;\n";
+        for (const auto &transition : doc.transitions) {
+            out << "        counters->declare(" << state
+                << "::" << states[transition.from_state] << ", " << event
+                << "::" << doc.events[transition.event] << ");\n";
+        }
+        out << "    }\n\n"
+            << "    " << state
+            << " get_current_state() const override { return current_state; "
+               "}\n\n"
+            << "    void set_state(" << state
+            << " state) override { current_state = state; }\n\n"
+            << "    void add_transition(std::unique_ptr<\n"
+            << "        state_machine::IStateTransition<" << state << ", "
+            << event << ">>) override {\n"
+            << "        throw std::runtime_error(\"" << m
+            << " is generated; edit its definition instead\");\n"
+            << "    }\n\n"
+            << "    " << state << " get_next_state(" << state << " state, "
+            << event << " event) const override {\n"
+            << "        state_machine::GuardOutcome outcome;\n"
+            << "        return step(state, event, outcome);\n"
+            << "    }\n\n"
+            << "    bool process_event(" << event << " event) override {\n"
+            << "        state_machine::GuardOutcome outcome;\n"
+            << "        " << state
+            << " next_state = step(current_state, event, outcome);\n"
+            << "        if (counters) {\n"
+            << "            counters->record(current_state, event,\n"
+            << "                             next_state != current_state, "
+               "outcome);\n"
+            << "        }\n"
+            << "        if (next_state == current_state)\n"
+            << "            return false;\n"
+            << "        current_state = next_state;\n"
+            << "        return true;\n"
+            << "    }\n\n";
+        write_list("get_all_states", state, states);
+        write_list("get_all_events", event, doc.events);
+        write_step(states);
+        write_timeouts(states);
+        write_display(states);
+        out << "};\n\n";
+    }
+
+    // A class template, so the definitions C++14 wants for odr-used
+    // constexpr members can sit in a header included by many sources
+    void write_constants(const std::vector<std::string> &states) {
+        const std::string constants = options.machine + "Constants";
+        out << "// Constants of " << options.machine << "\n"
+            << "template <typename Unused = void> struct " << constants
+            << " {\n"
+            << "    static constexpr std::size_t STATE_COUNT = "
+            << states.size() << ";\n"
+            << "    static constexpr std::size_t EVENT_COUNT = "
+            << doc.events.size() << ";\n"
+            << "    static constexpr std::size_t GUARD_COUNT = "
+            << doc.guards.size() << ";\n"
+            << "    static constexpr uint64_t VERSION = " << doc.version
+            << ";\n";
+        for (const auto &guard : doc.guards) {
+            out << "    static constexpr const char *" << constant_case(guard)
+                << "_GUARD = " << quoted(guard) << ";\n";
+        }
+        out << "};\n\n";
+
+        const std::string scope = constants + "<Unused>::";
+        for (const char *member :
+             {"STATE_COUNT", "EVENT_COUNT", "GUARD_COUNT"}) {
+            out << "template <typename Unused>\n"
+                << "constexpr std::size_t " << scope << member << ";\n";
+        }
+        out << "template <typename Unused>\n"
+            << "constexpr uint64_t " << scope << "VERSION;\n";
+        for (const auto &guard : doc.guards) {
+            out << "template <typename Unused>\n"
+                << "constexpr const char *" << scope << constant_case(guard)
+                << "_GUARD;\n";
+        }
+        out << "\n";
+    }
+
+    void write_list(const char *method, const std::string &type,
+                    const std::vector<std::string> &names) {
+        out << "    std::vector<" << type << "> " << method
+            << "() const override {\n"
+            << "        return {";
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            out << (i ? ",\n                " : "") << type << "::"
+                << names[i];
+        }
+        out << "};\n"
+            << "    }\n\n";
+    }
+
+    void write_step(const std::vector<std::string> &states) {
+        const std::string &state = options.state_enum;
+        const std::string &event = options.event_enum;
+        out << "    // Target of event in state; state itself if ignored\n"
+            << "    " << state << " step(" << state << " state, " << event
+            << " event,\n"
+            << "               state_machine::GuardOutcome &outcome) const {\n"
+            << "        outcome = state_machine::GuardOutcome::NONE;\n"
+            << "        switch (state) {\n";
+        for (std::size_t s = 0; s < states.size(); ++s) {
+            bool any = false;
+            for (const auto &transition : doc.transitions) {
+                if (transition.from_state != s)
+                    continue;
+                if (!any) {
+                    out << "        case " << state << "::" << states[s]
+                        << ":\n"
+                        << "            switch (event) {\n";
+                    any = true;
+                }
+                out << "            case " << event
+                    << "::" << doc.events[transition.event] << ":\n";
+                std::string to =
+                    state + "::" + states[transition.to_state];
+                if (transition.guard < 0) {
+                    out << "                return " << to << ";\n";
+                    continue;
+                }
+                out << "                if (guards[" << transition.guard
+                    << "] && guards[" << transition.guard << "]()) {\n"
+                    << "                    outcome = "
+                       "state_machine::GuardOutcome::PASSED;\n"
+                    << "                    return " << state
+                    << "::" << states[transition.guarded_state] << ";\n"
+                    << "                }\n"
+                    << "                outcome = "
+                       "state_machine::GuardOutcome::FAILED;\n"
+                    << "                return " << to << ";\n";
+            }
+            if (any) {
+                out << "            default:\n"
+                    << "                return state;\n"
+                    << "            }\n";
+            }
+        }
+        out << "        default:\n"
+            << "            return state;\n"
+            << "        }\n"
+            << "    }\n\n";
+    }
+
+    void write_timeouts(const std::vector<std::string> &states) {
+        const std::string &state = options.state_enum;
+        out << "    // Seconds to spend in state, 0 for none\n"
+            << "    static uint32_t get_timeout(" << state << " state) {\n"
+            << "        switch (state) {\n";
+        for (std::size_t s = 0; s < states.size(); ++s) {
+            if (doc.states[s].timeout == 0)
+                continue;
+            out << "        case " << state << "::" << states[s] << ":\n"
+                << "            return " << doc.states[s].timeout << ";\n";
+        }
+        out << "        default:\n"
+            << "            return 0;\n"
+            << "        }\n"
+            << "    }\n\n";
+    }
+
+    void write_display(const std::vector<std::string> &states) {
+        const std::string &state = options.state_enum;
+        out << "    // Display entry key of state, nullptr if it has none\n"
+            << "    static const char *get_display(" << state
+            << " state, const char *key) {\n"
+            << "        (void)key;\n"
+            << "        switch (state) {\n";
+        for (std::size_t s = 0; s < states.size(); ++s) {
+            if (doc.states[s].display.empty())
+                continue;
+            out << "        case " << state << "::" << states[s] << ":\n";
+            for (const auto &entry : doc.states[s].display) {
+                out << "            if (std::strcmp(key, "
+                    << quoted(entry.first) << ") == 0)\n"
+                    << "                return " << quoted(entry.second)
+                    << ";\n";
+            }
+            out << "            return nullptr;\n";
+        }
+        out << "        default:\n"
+            << "            return nullptr;\n"
+            << "        }\n"
+            << "    }\n";
+    }
+};
+
+bool parse_options(int argc, char *argv[], Options &options) {
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string *target = nullptr;
+        if (arg == "--namespace") {
+            target = &options.name_space;
+        } else if (arg == "--machine") {
+            target = &options.machine;
+        } else if (arg == "--state-enum") {
+            target = &options.state_enum;
+        } else if (arg == "--event-enum") {
+            target = &options.event_enum;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            return false;
+        } else {
+            positional.push_back(arg);
+            continue;
+        }
+        if (++i >= argc)
+            return false;
+        *target = argv[i];
+    }
+    if (positional.size() != 2)
+        return false;
+    options.input = positional[0];
+    options.output = positional[1];
+    return true;
+}
+
+void write_file(const std::string &path, const std::string &text) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << text;
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    try {
+        DefinitionDocument document = read_definition_file(options.input);
+        std::string stem = camel_case(
+            document.name.empty() ? "Generated" : document.name);
+        if (options.machine.empty())
+            options.machine = stem + "Machine";
+        if (options.state_enum.empty())
+            options.state_enum = stem + "State";
+        if (options.event_enum.empty())
+            options.event_enum = stem + "Event";
+        for (const std::string *name :
+             {&options.machine, &options.state_enum, &options.event_enum}) {
+            if (!is_identifier(*name)) {
+                throw std::runtime_error("'" + *name +
+                                         "' is not a C++ identifier");
+            }
+        }
+
+        Generator generator(document, options);
+        write_file(options.output, generator.generate());
+    } catch (const std::exception &e) {
+        std::cerr << "state_machine_codegen: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}